@@ -32,6 +32,14 @@ public:
       throw ValueError(S("Value ") + NAME_SUBPARTITION_DIMENSION + " must be smaller or equal than " + NAME_PARTITION_DIMENSION + ".");
     }
 
+    if (num_partitions_per_dimension < 1) {
+      throw ValueError(S("Value ") + NAME_NUM_PARTITIONS_PER_DIMENSION + " must be at least 1.");
+    }
+
+    if (num_threads < 1) {
+      throw ValueError(S("Value ") + NAME_NUM_THREADS + " must be at least 1.");
+    }
+
     if (is_set(initial_partition_origin)) {
       if (initial_partition_origin.size() != 3) {
         throw ValueError(S("Value ") + NAME_INITIAL_PARTITION_ORIGIN + " must be a vector of three floating point values.");
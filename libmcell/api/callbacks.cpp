@@ -85,8 +85,8 @@ void Callbacks::do_mol_wall_hit_callbacks(std::shared_ptr<MolWallHitInfo> info)
 
   geometry_object_id_t geometry_object_id = info->geometry_object->geometry_object_id;
 
-  // only one partition for now
-  const MCell::Molecule& m = model->get_world()->get_partition(PARTITION_ID_INITIAL).get_m(info->molecule_id);
+  const MCell::Molecule& m =
+      model->get_world()->get_partition(info->partition_id).get_m(info->molecule_id);
 
   // call callback for all matching registered callbacks
   auto it_specific_geom_obj = mol_wall_hit_callbacks.find(geometry_object_id);
@@ -62,37 +62,38 @@ std::vector<int> Introspection::get_molecule_ids(std::shared_ptr<Complex> patter
     }
   }
 
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
-  std::vector<MCell::Molecule>& molecules = p.get_molecules();
-  for (MCell::Molecule& m: molecules) {
-    if (m.is_defunct()) {
-      continue;
-    }
-    if (is_set(pattern)) {
-      // include only molecules that match the pattern
-      if (matching_species.count(m.species_id) != 0) {
-        res.push_back(m.id);
-      }
-      else if (not_matching_species.count(m.species_id) != 0) {
-        // nothing to do
+  for (Partition& p: world->get_partitions()) {
+    std::vector<MCell::Molecule>& molecules = p.get_molecules();
+    for (MCell::Molecule& m: molecules) {
+      if (m.is_defunct()) {
+        continue;
       }
-      else {
-        // not seen species
-        const BNG::Species& species = world->get_all_species().get(m.species_id);
-        BNG::compartment_id_t species_compartment = species.get_primary_compartment_id();
-        bool match = species.matches_pattern(bng_pattern, true) &&
-            (primary_compartment_id == BNG::COMPARTMENT_ID_NONE || primary_compartment_id == species_compartment);
-        if (match) {
-          matching_species.insert(m.species_id);
+      if (is_set(pattern)) {
+        // include only molecules that match the pattern
+        if (matching_species.count(m.species_id) != 0) {
           res.push_back(m.id);
         }
+        else if (not_matching_species.count(m.species_id) != 0) {
+          // nothing to do
+        }
         else {
-          not_matching_species.insert(m.species_id);
+          // not seen species
+          const BNG::Species& species = world->get_all_species().get(m.species_id);
+          BNG::compartment_id_t species_compartment = species.get_primary_compartment_id();
+          bool match = species.matches_pattern(bng_pattern, true) &&
+              (primary_compartment_id == BNG::COMPARTMENT_ID_NONE || primary_compartment_id == species_compartment);
+          if (match) {
+            matching_species.insert(m.species_id);
+            res.push_back(m.id);
+          }
+          else {
+            not_matching_species.insert(m.species_id);
+          }
         }
       }
-    }
-    else {
-      res.push_back(m.id);
+      else {
+        res.push_back(m.id);
+      }
     }
   }
 
@@ -102,10 +103,11 @@ std::vector<int> Introspection::get_molecule_ids(std::shared_ptr<Complex> patter
 
 std::shared_ptr<API::Molecule> Introspection::get_molecule(const int id) {
   std::shared_ptr<API::Molecule> res;
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
-  if (!p.does_molecule_exist(id)) {
+  Partition* p_ptr = world->find_partition_with_molecule(id);
+  if (p_ptr == nullptr) {
     throw RuntimeError("Molecule with id " + to_string(id) + " does not exist.");
   }
+  Partition& p = *p_ptr;
   MCell::Molecule& m = p.get_m(id);
   assert(!m.is_defunct() && "is_defunct is checked already by does_molecule_exist()");
 
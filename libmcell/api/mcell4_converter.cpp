@@ -86,10 +86,12 @@ void MCell4Converter::convert_before_init() {
     world->config.use_expanded_list = false;
   }
 
-  // at this point, we need to create the first (and for now the only) partition
-  // create initial partition with center at 0,0,0
-  partition_id_t index = world->add_partition(world->config.partition0_llf);
-  assert(index == PARTITION_ID_INITIAL);
+  // at this point, we need to create the partitions,
+  // geometry is created in the initial partition and copied to the others in World::init_counted_volumes
+  world->add_partition_lattice();
+
+  // config.num_threads is already known, threads are used to process geometry
+  world->create_thread_pool_if_needed();
 
   convert_geometry_objects();
 
@@ -127,6 +129,8 @@ void MCell4Converter::convert_before_init() {
   }
 
   check_all_mol_types_have_diffusion_const();
+
+  check_partition_lattice_is_supported();
 }
 
 
@@ -215,6 +219,7 @@ void MCell4Converter::convert_simulation_setup() {
   world->config.rxn_and_species_report = notifications.rxn_and_species_report;
   world->config.iteration_report = notifications.iteration_report;
   world->config.wall_overlap_report = notifications.wall_overlap_report;
+  world->config.startup_timing_report = notifications.startup_timing_report;
   world->config.simulation_stats_every_n_iterations = notifications.simulation_stats_every_n_iterations;
 
   world->config.notifications.bng_verbosity_level = notifications.bng_verbosity_level;
@@ -270,6 +275,26 @@ void MCell4Converter::convert_simulation_setup() {
   world->config.randomize_smol_pos = !config.center_molecules_on_grid;
 
   world->config.sort_mols_by_subpart = config.sort_molecules;
+  world->config.sort_mols_in_morton_order = config.sort_molecules_in_morton_order;
+
+  world->config.num_threads = config.num_threads;
+
+  world->config.use_counter_based_rng = config.use_counter_based_rng;
+
+  world->config.use_async_viz_output = config.use_async_viz_output;
+  world->config.max_pending_viz_frames = config.max_pending_viz_frames;
+  world->config.use_async_count_output = config.use_async_count_output;
+  world->config.max_pending_count_output_mb = config.max_pending_count_output_mb;
+  world->config.use_wall_bvh = config.use_bvh_for_wall_collisions;
+  world->config.use_adaptive_subparts = config.use_adaptive_subpartitions;
+  if (world->config.use_adaptive_subparts && world->config.num_threads > 1) {
+    // molecules in different subpartitions of the same cell would update the same reactant set
+    throw ValueError(S(NAME_CONFIG) + "." + NAME_USE_ADAPTIVE_SUBPARTITIONS + " cannot be used with " +
+        NAME_NUM_THREADS + " larger than 1.");
+  }
+  world->config.use_batched_gauss_rng = config.use_batched_gaussian_rng;
+  world->config.use_counted_volume_voxels = config.use_voxelized_counted_volumes;
+  world->config.use_rxn_pathway_alias_tables = config.use_reaction_pathway_alias_tables;
 
   world->config.check_overlapped_walls = config.check_overlapped_walls;
 
@@ -369,12 +394,14 @@ void MCell4Converter::convert_simulation_setup() {
   // align the origin to a multiple of subpartition length
   pos_t sp_len = config.subpartition_dimension / length_unit;
 
-  uint tentative_subparts = world->config.partition_edge_length / sp_len;
+  // the limit applies to each partition of the lattice
+  uint num_partitions = config.num_partitions_per_dimension;
+  uint tentative_subparts = world->config.partition_edge_length / sp_len / num_partitions;
   if (tentative_subparts > MAX_SUBPARTS_PER_PARTITION) {
     cout <<
       "Info: Approximate number of subpartitions " << tentative_subparts <<
       " is too high, lowering it to a limit of " << MAX_SUBPARTS_PER_PARTITION << ".\n";
-    sp_len = world->config.partition_edge_length / MAX_SUBPARTS_PER_PARTITION;
+    sp_len = world->config.partition_edge_length / (MAX_SUBPARTS_PER_PARTITION * num_partitions);
   }
 
   Vec3 orig_origin = world->config.partition0_llf;
@@ -389,6 +416,17 @@ void MCell4Converter::convert_simulation_setup() {
   world->config.num_subparts_per_partition_edge =
       round_f(world->config.partition_edge_length / sp_len);
 
+  // the simulated space is split into a lattice of partitions where each partition
+  // has the same number of subpartitions, partition_edge_length is then the edge of
+  // a single partition
+  world->config.num_partitions_per_world_edge = num_partitions;
+  if (num_partitions > 1) {
+    uint subparts_per_partition =
+        (world->config.num_subparts_per_partition_edge + num_partitions - 1) / num_partitions;
+    world->config.num_subparts_per_partition_edge = subparts_per_partition;
+    world->config.partition_edge_length = subparts_per_partition * sp_len;
+  }
+
   // this option in MCell3 was removed in MCell4
   world->config.use_expanded_list = true;
 
@@ -1028,7 +1066,9 @@ void MCell4Converter::convert_geometry_objects() {
     }
   }
 
-  p.finalize_walls();
+  auto start_time = chrono::steady_clock::now();
+  p.finalize_walls(world->get_thread_pool());
+  world->add_startup_phase_time("walls", start_time);
 }
 
 
@@ -1762,6 +1802,34 @@ void MCell4Converter::check_all_mol_types_have_diffusion_const() {
 }
 
 
+// partitions do not share molecules near their boundaries and each partition has its own
+// copy of surface grids, results would be wrong for bimolecular reactions of molecules
+// in different partitions and for surface molecules
+void MCell4Converter::check_partition_lattice_is_supported() {
+  if (world->config.num_partitions_per_world_edge == 1) {
+    return;
+  }
+
+  const string msg_suffix =
+      " when " + S(NAME_CONFIG) + "." + NAME_NUM_PARTITIONS_PER_DIMENSION + " is higher than 1.";
+
+  for (const BNG::RxnRule* rxn: world->get_all_rxns().get_rxn_rules_vector()) {
+    if (rxn->is_bimol() || rxn->is_surf_rxn()) {
+      throw ValueError(
+          "Reaction '" + rxn->name + "' is not supported" + msg_suffix +
+          " Only unimolecular reactions of volume molecules can be used.");
+    }
+  }
+
+  for (const BNG::ElemMolType& mt: world->bng_engine.get_data().get_elem_mol_types()) {
+    if (!mt.is_vol() && !mt.is_reactive_surface()) {
+      throw ValueError(
+          "Surface molecule type '" + mt.name + "' is not supported" + msg_suffix);
+    }
+  }
+}
+
+
 // must be called after world initialization
 void MCell4Converter::convert_after_init() {
   convert_rng_state();
@@ -1790,11 +1858,15 @@ void MCell4Converter::convert_rng_state() {
   std::copy(src->mm.begin(), src->mm.end(), dst.mm);
 
   dst.rngblocks = src->rngblocks;
+
+  // values drawn from the previous state must not be used
+  world->gauss_buffer.discard();
 }
 
 
 void MCell4Converter::convert_checkpointed_molecules() {
-  // single partition for now
+  // volume molecules are added to the partition where they are located,
+  // surface molecules are supported only with a single partition
   Partition& p = world->get_partition(PARTITION_ID_INITIAL);
 
   uint_set<MCell::molecule_id_t> used_mol_ids;
@@ -1835,7 +1907,7 @@ void MCell4Converter::convert_checkpointed_molecules() {
       const shared_ptr<ChkptVolMol>& vm = dynamic_pointer_cast<ChkptVolMol>(m);
       res_m.v.pos = vm->pos * Vec3(world->config.rcp_length_unit);
 
-      p.add_volume_molecule(res_m, 0);
+      world->get_partition_for_pos(res_m.v.pos).add_volume_molecule(res_m, 0);
     }
     else {
       res_m.reset_surf_data();
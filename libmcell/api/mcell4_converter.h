@@ -152,6 +152,7 @@ private:
   void add_ctrl_c_termination_event();
 
   void check_all_mol_types_have_diffusion_const();
+  void check_partition_lattice_is_supported();
 
   // after init
   void convert_rng_state();
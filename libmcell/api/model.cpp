@@ -278,11 +278,12 @@ std::vector<int> Model::run_reaction(
     throw RuntimeError(S("Method ") + NAME_RUN_REACTION + " currently supports only unimolecular reactions.");
   }
 
-  MCell::Partition& p = world->get_partition(PARTITION_ID_INITIAL);
   molecule_id_t id1 = reactant_ids[0];
-  if (!p.does_molecule_exist(id1)) {
+  MCell::Partition* p_ptr = world->find_partition_with_molecule(id1);
+  if (p_ptr == nullptr) {
     throw RuntimeError("Molecule with id " + to_string(id1) + " does not exist.");
   }
+  MCell::Partition& p = *p_ptr;
   MCell::Molecule& m1 = p.get_m(id1);
   if (m1.is_defunct()) {
     throw RuntimeError("Molecule with id " + to_string(id1) + " was removed.");
@@ -396,6 +397,11 @@ std::vector<std::shared_ptr<WallWallHitInfo>> Model::apply_vertex_moves(
     const bool collect_wall_wall_hits,
     const bool randomize_order) {
 
+  if (world->get_partitions().size() > 1) {
+    throw RuntimeError(S("Method ") + NAME_APPLY_VERTEX_MOVES + " is not supported when " +
+        NAME_CONFIG + "." + NAME_NUM_PARTITIONS_PER_DIMENSION + " is higher than 1.");
+  }
+
   // run the actual vertex update
   std::set<GeometryObjectWallUnorderedPair> colliding_walls;
   Partition& p = world->get_partition(PARTITION_ID_INITIAL);
@@ -443,6 +449,12 @@ std::vector<std::shared_ptr<WallWallHitInfo>> Model::apply_vertex_moves(
 
 
 void Model::pair_molecules(const int id1, const int id2) {
+  // pairing is used together with dynamic geometry that supports only a single partition
+  if (world->get_partitions().size() > 1) {
+    throw RuntimeError(S("Method ") + NAME_PAIR_MOLECULES + " is not supported when " +
+        NAME_CONFIG + "." + NAME_NUM_PARTITIONS_PER_DIMENSION + " is higher than 1.");
+  }
+
   Partition& p = world->get_partition(PARTITION_ID_INITIAL);
 
   string res = p.pair_molecules(id1, id2);
@@ -32,6 +32,7 @@ public:
   // extra information to be converted in Callbacks
   geometry_object_id_t geometry_object_id; // to geometry_object
   wall_index_t partition_wall_index; // to wall_index
+  partition_id_t partition_id; // partition that contains the molecule
 };
 
 } // namespace API
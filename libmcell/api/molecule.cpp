@@ -20,14 +20,14 @@ namespace API {
 void Molecule::remove() {
   check_initialization();
 
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
+  Partition* p = world->find_partition_with_molecule(id);
 
-  if (!p.does_molecule_exist(id)) {
+  if (p == nullptr) {
     throw RuntimeError("Molecule with id " + std::to_string(id) + " does not exist anymore.");
   }
 
-  // set that this molecule is defunct
-  world->get_partition(PARTITION_ID_INITIAL).get_m(id).set_is_defunct();
+  // set that this molecule is defunct, also updates molecule counts
+  p->set_molecule_as_defunct(p->get_m(id));
 }
 
 }
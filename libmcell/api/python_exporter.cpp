@@ -201,7 +201,10 @@ void PythonExporter::export_simulation_state(
   // molecules
   export_molecules(out, ctx);
 
-  // rng state
+  // rng state,
+  // normal numbers buffered from the rng are not saved so the running simulation
+  // must draw new ones as the simulation resumed from this checkpoint will
+  world->gauss_buffer.discard();
   RngState rng_state = RngState(world->rng);
   config_variable_names[NAME_INITIAL_RNG_STATE] = rng_state.export_to_python(out, ctx);
 }
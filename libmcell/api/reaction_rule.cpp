@@ -121,6 +121,9 @@ void ReactionRule::update_reaction_rate(const BNG::rxn_rule_id_t rxn_rule_id, co
 
   BNG::RxnRule* rxn = world->get_all_rxns().get(rxn_rule_id);
   bool updated = rxn->update_rxn_rate(new_rate);
+  if (updated) {
+    world->clear_rxn_class_caches();
+  }
   if (updated && rxn->is_unimol()) {
     world->reset_unimol_rxn_times(rxn_rule_id);
   }
@@ -42,12 +42,25 @@ void GenConfig::set_all_attributes_as_default_or_unset() {
   partition_dimension = 10;
   initial_partition_origin = std::vector<double>();
   subpartition_dimension = 0.5;
+  num_partitions_per_dimension = 1;
   total_iterations = 1000000;
   check_overlapped_walls = true;
   reaction_class_cleanup_periodicity = 500;
   species_cleanup_periodicity = 10000;
   molecules_order_random_shuffle_periodicity = 10000;
   sort_molecules = false;
+  sort_molecules_in_morton_order = false;
+  num_threads = 1;
+  use_counter_based_rng = false;
+  use_async_viz_output = false;
+  max_pending_viz_frames = 2;
+  use_async_count_output = false;
+  max_pending_count_output_mb = 64;
+  use_bvh_for_wall_collisions = false;
+  use_adaptive_subpartitions = false;
+  use_batched_gaussian_rng = false;
+  use_voxelized_counted_volumes = false;
+  use_reaction_pathway_alias_tables = false;
   memory_limit_gb = -1;
   initial_iteration = 0;
   initial_time = 0;
@@ -70,12 +83,25 @@ std::shared_ptr<Config> GenConfig::copy_config() const {
   res->partition_dimension = partition_dimension;
   res->initial_partition_origin = initial_partition_origin;
   res->subpartition_dimension = subpartition_dimension;
+  res->num_partitions_per_dimension = num_partitions_per_dimension;
   res->total_iterations = total_iterations;
   res->check_overlapped_walls = check_overlapped_walls;
   res->reaction_class_cleanup_periodicity = reaction_class_cleanup_periodicity;
   res->species_cleanup_periodicity = species_cleanup_periodicity;
   res->molecules_order_random_shuffle_periodicity = molecules_order_random_shuffle_periodicity;
   res->sort_molecules = sort_molecules;
+  res->sort_molecules_in_morton_order = sort_molecules_in_morton_order;
+  res->num_threads = num_threads;
+  res->use_counter_based_rng = use_counter_based_rng;
+  res->use_async_viz_output = use_async_viz_output;
+  res->max_pending_viz_frames = max_pending_viz_frames;
+  res->use_async_count_output = use_async_count_output;
+  res->max_pending_count_output_mb = max_pending_count_output_mb;
+  res->use_bvh_for_wall_collisions = use_bvh_for_wall_collisions;
+  res->use_adaptive_subpartitions = use_adaptive_subpartitions;
+  res->use_batched_gaussian_rng = use_batched_gaussian_rng;
+  res->use_voxelized_counted_volumes = use_voxelized_counted_volumes;
+  res->use_reaction_pathway_alias_tables = use_reaction_pathway_alias_tables;
   res->memory_limit_gb = memory_limit_gb;
   res->initial_iteration = initial_iteration;
   res->initial_time = initial_time;
@@ -100,12 +126,25 @@ std::shared_ptr<Config> GenConfig::deepcopy_config(py::dict) const {
   res->partition_dimension = partition_dimension;
   res->initial_partition_origin = initial_partition_origin;
   res->subpartition_dimension = subpartition_dimension;
+  res->num_partitions_per_dimension = num_partitions_per_dimension;
   res->total_iterations = total_iterations;
   res->check_overlapped_walls = check_overlapped_walls;
   res->reaction_class_cleanup_periodicity = reaction_class_cleanup_periodicity;
   res->species_cleanup_periodicity = species_cleanup_periodicity;
   res->molecules_order_random_shuffle_periodicity = molecules_order_random_shuffle_periodicity;
   res->sort_molecules = sort_molecules;
+  res->sort_molecules_in_morton_order = sort_molecules_in_morton_order;
+  res->num_threads = num_threads;
+  res->use_counter_based_rng = use_counter_based_rng;
+  res->use_async_viz_output = use_async_viz_output;
+  res->max_pending_viz_frames = max_pending_viz_frames;
+  res->use_async_count_output = use_async_count_output;
+  res->max_pending_count_output_mb = max_pending_count_output_mb;
+  res->use_bvh_for_wall_collisions = use_bvh_for_wall_collisions;
+  res->use_adaptive_subpartitions = use_adaptive_subpartitions;
+  res->use_batched_gaussian_rng = use_batched_gaussian_rng;
+  res->use_voxelized_counted_volumes = use_voxelized_counted_volumes;
+  res->use_reaction_pathway_alias_tables = use_reaction_pathway_alias_tables;
   res->memory_limit_gb = memory_limit_gb;
   res->initial_iteration = initial_iteration;
   res->initial_time = initial_time;
@@ -129,12 +168,25 @@ bool GenConfig::__eq__(const Config& other) const {
     partition_dimension == other.partition_dimension &&
     initial_partition_origin == other.initial_partition_origin &&
     subpartition_dimension == other.subpartition_dimension &&
+    num_partitions_per_dimension == other.num_partitions_per_dimension &&
     total_iterations == other.total_iterations &&
     check_overlapped_walls == other.check_overlapped_walls &&
     reaction_class_cleanup_periodicity == other.reaction_class_cleanup_periodicity &&
     species_cleanup_periodicity == other.species_cleanup_periodicity &&
     molecules_order_random_shuffle_periodicity == other.molecules_order_random_shuffle_periodicity &&
     sort_molecules == other.sort_molecules &&
+    sort_molecules_in_morton_order == other.sort_molecules_in_morton_order &&
+    num_threads == other.num_threads &&
+    use_counter_based_rng == other.use_counter_based_rng &&
+    use_async_viz_output == other.use_async_viz_output &&
+    max_pending_viz_frames == other.max_pending_viz_frames &&
+    use_async_count_output == other.use_async_count_output &&
+    max_pending_count_output_mb == other.max_pending_count_output_mb &&
+    use_bvh_for_wall_collisions == other.use_bvh_for_wall_collisions &&
+    use_adaptive_subpartitions == other.use_adaptive_subpartitions &&
+    use_batched_gaussian_rng == other.use_batched_gaussian_rng &&
+    use_voxelized_counted_volumes == other.use_voxelized_counted_volumes &&
+    use_reaction_pathway_alias_tables == other.use_reaction_pathway_alias_tables &&
     memory_limit_gb == other.memory_limit_gb &&
     initial_iteration == other.initial_iteration &&
     initial_time == other.initial_time &&
@@ -166,12 +218,25 @@ bool GenConfig::eq_nonarray_attributes(const Config& other, const bool ignore_na
     partition_dimension == other.partition_dimension &&
     true /*initial_partition_origin*/ &&
     subpartition_dimension == other.subpartition_dimension &&
+    num_partitions_per_dimension == other.num_partitions_per_dimension &&
     total_iterations == other.total_iterations &&
     check_overlapped_walls == other.check_overlapped_walls &&
     reaction_class_cleanup_periodicity == other.reaction_class_cleanup_periodicity &&
     species_cleanup_periodicity == other.species_cleanup_periodicity &&
     molecules_order_random_shuffle_periodicity == other.molecules_order_random_shuffle_periodicity &&
     sort_molecules == other.sort_molecules &&
+    sort_molecules_in_morton_order == other.sort_molecules_in_morton_order &&
+    num_threads == other.num_threads &&
+    use_counter_based_rng == other.use_counter_based_rng &&
+    use_async_viz_output == other.use_async_viz_output &&
+    max_pending_viz_frames == other.max_pending_viz_frames &&
+    use_async_count_output == other.use_async_count_output &&
+    max_pending_count_output_mb == other.max_pending_count_output_mb &&
+    use_bvh_for_wall_collisions == other.use_bvh_for_wall_collisions &&
+    use_adaptive_subpartitions == other.use_adaptive_subpartitions &&
+    use_batched_gaussian_rng == other.use_batched_gaussian_rng &&
+    use_voxelized_counted_volumes == other.use_voxelized_counted_volumes &&
+    use_reaction_pathway_alias_tables == other.use_reaction_pathway_alias_tables &&
     memory_limit_gb == other.memory_limit_gb &&
     initial_iteration == other.initial_iteration &&
     initial_time == other.initial_time &&
@@ -204,12 +269,25 @@ std::string GenConfig::to_str(const bool all_details, const std::string ind) con
       "partition_dimension=" << partition_dimension << ", " <<
       "initial_partition_origin=" << vec_nonptr_to_str(initial_partition_origin, all_details, ind + "  ") << ", " <<
       "subpartition_dimension=" << subpartition_dimension << ", " <<
+      "num_partitions_per_dimension=" << num_partitions_per_dimension << ", " <<
       "total_iterations=" << total_iterations << ", " <<
       "check_overlapped_walls=" << check_overlapped_walls << ", " <<
       "reaction_class_cleanup_periodicity=" << reaction_class_cleanup_periodicity << ", " <<
       "species_cleanup_periodicity=" << species_cleanup_periodicity << ", " <<
       "molecules_order_random_shuffle_periodicity=" << molecules_order_random_shuffle_periodicity << ", " <<
       "sort_molecules=" << sort_molecules << ", " <<
+      "sort_molecules_in_morton_order=" << sort_molecules_in_morton_order << ", " <<
+      "num_threads=" << num_threads << ", " <<
+      "use_counter_based_rng=" << use_counter_based_rng << ", " <<
+      "use_async_viz_output=" << use_async_viz_output << ", " <<
+      "max_pending_viz_frames=" << max_pending_viz_frames << ", " <<
+      "use_async_count_output=" << use_async_count_output << ", " <<
+      "max_pending_count_output_mb=" << max_pending_count_output_mb << ", " <<
+      "use_bvh_for_wall_collisions=" << use_bvh_for_wall_collisions << ", " <<
+      "use_adaptive_subpartitions=" << use_adaptive_subpartitions << ", " <<
+      "use_batched_gaussian_rng=" << use_batched_gaussian_rng << ", " <<
+      "use_voxelized_counted_volumes=" << use_voxelized_counted_volumes << ", " <<
+      "use_reaction_pathway_alias_tables=" << use_reaction_pathway_alias_tables << ", " <<
       "memory_limit_gb=" << memory_limit_gb << ", " <<
       "initial_iteration=" << initial_iteration << ", " <<
       "initial_time=" << initial_time << ", " <<
@@ -234,12 +312,25 @@ py::class_<Config> define_pybinding_Config(py::module& m) {
             const double,
             const std::vector<double>,
             const double,
+            const int,
             const double,
             const bool,
             const int,
             const int,
             const int,
             const bool,
+            const bool,
+            const int,
+            const bool,
+            const bool,
+            const int,
+            const bool,
+            const int,
+            const bool,
+            const bool,
+            const bool,
+            const bool,
+            const bool,
             const int,
             const uint64_t,
             const double,
@@ -258,12 +349,25 @@ py::class_<Config> define_pybinding_Config(py::module& m) {
           py::arg("partition_dimension") = 10,
           py::arg("initial_partition_origin") = std::vector<double>(),
           py::arg("subpartition_dimension") = 0.5,
+          py::arg("num_partitions_per_dimension") = 1,
           py::arg("total_iterations") = 1000000,
           py::arg("check_overlapped_walls") = true,
           py::arg("reaction_class_cleanup_periodicity") = 500,
           py::arg("species_cleanup_periodicity") = 10000,
           py::arg("molecules_order_random_shuffle_periodicity") = 10000,
           py::arg("sort_molecules") = false,
+          py::arg("sort_molecules_in_morton_order") = false,
+          py::arg("num_threads") = 1,
+          py::arg("use_counter_based_rng") = false,
+          py::arg("use_async_viz_output") = false,
+          py::arg("max_pending_viz_frames") = 2,
+          py::arg("use_async_count_output") = false,
+          py::arg("max_pending_count_output_mb") = 64,
+          py::arg("use_bvh_for_wall_collisions") = false,
+          py::arg("use_adaptive_subpartitions") = false,
+          py::arg("use_batched_gaussian_rng") = false,
+          py::arg("use_voxelized_counted_volumes") = false,
+          py::arg("use_reaction_pathway_alias_tables") = false,
           py::arg("memory_limit_gb") = -1,
           py::arg("initial_iteration") = 0,
           py::arg("initial_time") = 0,
@@ -288,12 +392,25 @@ py::class_<Config> define_pybinding_Config(py::module& m) {
       .def_property("partition_dimension", &Config::get_partition_dimension, &Config::set_partition_dimension, "All the simulated 3d space is placed in a partition. The partition is a cube and \nthis partition_dimension specifies the length of its edge in um.\n")
       .def_property("initial_partition_origin", &Config::get_initial_partition_origin, &Config::set_initial_partition_origin, py::return_value_policy::reference, "Optional placement of the initial partition in um, specifies the left, lower front \npoint. If not set, value -partition_dimension/2 is used for each of the dimensions \nplacing the center of the partition to (0, 0, 0).   \n")
       .def_property("subpartition_dimension", &Config::get_subpartition_dimension, &Config::set_subpartition_dimension, "Subpartition are spatial division of 3D space used to accelerate collision checking.\nIn general, partitions should be chosen to avoid having too many surfaces and molecules\nin one subpartition. \nIf there are few surfaces and/or molecules in a subvolume, it is advantageous to have the \nsubvolume as large as possible. Crossing partition boundaries takes a small amount of time, \nso it is rarely useful to have partitions more finely spaced than the average diffusion distance \nof the faster-moving molecules in the simulation.\n")
+      .def_property("num_partitions_per_dimension", &Config::get_num_partitions_per_dimension, &Config::set_num_partitions_per_dimension, "Splits the simulated space given by partition_dimension and initial_partition_origin \ninto a lattice of num_partitions_per_dimension^3 partitions of equal size.\nEach partition holds its own molecules and subpartitions, molecules migrate \nbetween partitions when they diffuse across a partition boundary. \nThe number of subpartitions along each edge of the simulated space is rounded up \nso that each partition contains the same number of subpartitions.\nWhen more than one partition is used, the model must not contain bimolecular reactions, \nsurface reactions, or surface molecules, and dynamic geometry is not supported.  \n")
       .def_property("total_iterations", &Config::get_total_iterations, &Config::set_total_iterations, "Required for checkpointing so that the checkpointed model has information on\nthe intended total number of iterations. \nAlso used when generating visualization data files and also for other reporting uses. \nValue is truncated to an integer.\n")
       .def_property("check_overlapped_walls", &Config::get_check_overlapped_walls, &Config::set_check_overlapped_walls, "Enables check for overlapped walls. Overlapping walls can cause issues during \nsimulation such as a molecule escaping closed geometry when it hits two walls \nthat overlap. \n")
       .def_property("reaction_class_cleanup_periodicity", &Config::get_reaction_class_cleanup_periodicity, &Config::set_reaction_class_cleanup_periodicity, "Reaction class cleanup removes computed reaction classes for inactive species from memory.\nThis provides faster reaction lookup faster but when the same reaction class is \nneeded again, it must be recomputed.\n")
       .def_property("species_cleanup_periodicity", &Config::get_species_cleanup_periodicity, &Config::set_species_cleanup_periodicity, "Species cleanup removes inactive species from memory. It removes also all reaction classes \nthat reference it.\nThis provides faster addition of new species lookup faster but when the species is \nneeded again, it must be recomputed.\n")
       .def_property("molecules_order_random_shuffle_periodicity", &Config::get_molecules_order_random_shuffle_periodicity, &Config::set_molecules_order_random_shuffle_periodicity, "Randomly shuffle the order in which molecules are simulated.\nThis helps to overcome potential biases that may occur when \nmolecules are ordered e.g. by their species when simulation starts. \nThe first shuffling occurs at this iteration, i.e. no shuffle is done at iteration 0.\nSetting this parameter to 0 disables the shuffling.  \n")
       .def_property("sort_molecules", &Config::get_sort_molecules, &Config::set_sort_molecules, "Enables sorting of molecules for diffusion, this may improve cache locality and provide \nslightly better performance. \nProduces different results for the same seed when enabled because molecules are simulated \nin a different order. \n")
+      .def_property("sort_molecules_in_morton_order", &Config::get_sort_molecules_in_morton_order, &Config::set_sort_molecules_in_morton_order, "Enables sorting of molecules along a Z-order (Morton) curve of subpartitions so that\nconsecutively diffused molecules are close in space and in memory. \nUnlike sort_molecules, also the order in which molecules are diffused and \nthe lists of potential reactants are sorted. Sorting is done only when the order \ndegraded because of newly created molecules or periodic shuffling.\nProduces different results for the same seed when enabled. \n")
+      .def_property("num_threads", &Config::get_num_threads, &Config::set_num_threads, "Number of threads used to diffuse volume molecules. \nSubpartitions are split into 27 groups (colors) so that subpartitions of the same \ncolor are at least 2 subpartitions apart, molecules in subpartitions of the same color \nare then diffused in parallel. \nOnly molecules that cannot interact with anything during their diffusion step are diffused in parallel, \ni.e. the step stays within the neighboring subpartitions, no walls are present there and there \nare no molecules it could react with. Volume molecules that may hit a wall or react, \nmolecules with a scheduled unimolecular reaction, and all surface molecules \nare diffused serially afterwards in the original order, \nso the speedup is small for models where most molecules are close to walls or to their reactants.\nEach thread has its own random number generator seeded from seed, \nresults are reproducible for the same seed and number of threads but differ \nfrom results of serial runs because molecules are simulated in a different order.\nThe results are statistically equivalent. \n")
+      .def_property("use_counter_based_rng", &Config::get_use_counter_based_rng, &Config::set_use_counter_based_rng, "When enabled, random numbers used for displacements of diffusing molecules and for \nthe time and pathway of unimolecular reactions are generated by a counter-based generator \n(Philox4x32-10) keyed by seed, molecule id, and the time when the molecule is simulated. \nThese random numbers then do not depend on the order in which molecules are simulated. \nRandom numbers for bimolecular reaction tests, placement of reaction products, \nand releases are still drawn sequentially from seed, so results are the same regardless \nof num_threads and num_partitions_per_dimension only for models where these draws \ndo not occur during diffusion, e.g. models with only diffusion and unimolecular \nreactions of volume molecules. \nProduces different results than when disabled.\n")
+      .def_property("use_async_viz_output", &Config::get_use_async_viz_output, &Config::set_use_async_viz_output, "When enabled, visualization output only copies molecule data and the files \nare written in a background thread while the simulation continues.\nAll files are complete when run_iterations or end_simulation returns. \n")
+      .def_property("max_pending_viz_frames", &Config::get_max_pending_viz_frames, &Config::set_max_pending_viz_frames, "Used only when use_async_viz_output is enabled. Maximum number of visualization \nframes that were copied but not written yet, when this limit is reached the \nsimulation waits for the background writer. Each pending frame needs memory \nfor positions of all visualized molecules.\n")
+      .def_property("use_async_count_output", &Config::get_use_async_count_output, &Config::set_use_async_count_output, "When enabled, buffered molecule and reaction counts are written to .dat and .gdat files \nin a background thread. The contents of the files are the same as without this option.\nAll files are complete when end_simulation returns. \n")
+      .def_property("max_pending_count_output_mb", &Config::get_max_pending_count_output_mb, &Config::set_max_pending_count_output_mb, "Used only when use_async_count_output is enabled. Maximum amount of count data in MB \nthat waits to be written, when this limit is reached the simulation waits for the background writer.\n")
+      .def_property("use_bvh_for_wall_collisions", &Config::get_use_bvh_for_wall_collisions, &Config::set_use_bvh_for_wall_collisions, "Enables a bounding volume hierarchy over all walls that is used to find wall collisions \nof volume molecules instead of walls stored per subpartition. \nThe cost of wall collision detection then does not depend on the number of subpartitions and \nis lower for meshes with uneven density of walls. Bounding boxes are updated when vertices move.  \nMay produce different results for the same seed when enabled because walls are \ntested in a different order.\n")
+      .def_property("use_adaptive_subpartitions", &Config::get_use_adaptive_subpartitions, &Config::set_use_adaptive_subpartitions, "Enables an adaptive octree built over subpartitions. Walls and potential reactants are \nstored per octree cell, cells that contain many molecules or walls are split \ndown to single subpartitions and empty space is merged into large cells so that \na fine subpartitioning costs little memory in empty regions.\nCells are rebuilt every 100 iterations as molecules redistribute.\nCannot be used together with num_threads larger than 1. \nMay produce different results for the same seed when enabled.\n")
+      .def_property("use_batched_gaussian_rng", &Config::get_use_batched_gaussian_rng, &Config::set_use_batched_gaussian_rng, "When enabled, normally distributed random numbers used for diffusion of volume molecules \nare generated in blocks of 256 values using the same ziggurat method as when disabled. \nThe distribution is the same but the sequence of random numbers differs, \nso results are different than when disabled. Kept disabled by default so that \nresults match MCell3 for the same seed. Ignored when use_counter_based_rng is enabled. \n")
+      .def_property("use_voxelized_counted_volumes", &Config::get_use_voxelized_counted_volumes, &Config::set_use_voxelized_counted_volumes, "Used only when the model contains intersecting counted objects or compartments.\nWhen enabled, each subpartition that contains walls of counted objects is split into \n4x4x4 voxels and the counted volume of each voxel that is not intersected by such a wall \nis precomputed at initialization. Counted volumes of releases and of newly created \nvolume molecules are then mostly obtained without ray casting from waypoints. \nVoxels affected by moving walls of dynamic geometry are recomputed after each move.\nIncreases initialization time and memory usage.\n")
+      .def_property("use_reaction_pathway_alias_tables", &Config::get_use_reaction_pathway_alias_tables, &Config::set_use_reaction_pathway_alias_tables, "When enabled, the pathway of a reaction class with at least 8 pathways is selected \nin constant time using an alias table instead of searching cumulative probabilities. \nTables are rebuilt when reaction rates change. The probabilities of pathways are the same \nand the same random numbers are used but they map to different pathways, \nso results are different than when disabled. Kept disabled by default so that \nresults match MCell3 for the same seed. \n")
       .def_property("memory_limit_gb", &Config::get_memory_limit_gb, &Config::set_memory_limit_gb, "Sets memory limit in GB for simulation run. \nWhen this limit is hit, all buffers are flushed and simulation is terminated with an error.\n")
       .def_property("initial_iteration", &Config::get_initial_iteration, &Config::set_initial_iteration, "Initial iteration, used when resuming a checkpoint.")
       .def_property("initial_time", &Config::get_initial_time, &Config::set_initial_time, "Initial time in us, used when resuming a checkpoint.\nWill be truncated to be a multiple of time step.\n")
@@ -355,6 +472,9 @@ std::string GenConfig::export_to_python(std::ostream& out, PythonExportContext&
   if (subpartition_dimension != 0.5) {
     ss << ind << "subpartition_dimension = " << f_to_str(subpartition_dimension) << "," << nl;
   }
+  if (num_partitions_per_dimension != 1) {
+    ss << ind << "num_partitions_per_dimension = " << num_partitions_per_dimension << "," << nl;
+  }
   if (total_iterations != 1000000) {
     ss << ind << "total_iterations = " << f_to_str(total_iterations) << "," << nl;
   }
@@ -373,6 +493,42 @@ std::string GenConfig::export_to_python(std::ostream& out, PythonExportContext&
   if (sort_molecules != false) {
     ss << ind << "sort_molecules = " << sort_molecules << "," << nl;
   }
+  if (sort_molecules_in_morton_order != false) {
+    ss << ind << "sort_molecules_in_morton_order = " << sort_molecules_in_morton_order << "," << nl;
+  }
+  if (num_threads != 1) {
+    ss << ind << "num_threads = " << num_threads << "," << nl;
+  }
+  if (use_counter_based_rng != false) {
+    ss << ind << "use_counter_based_rng = " << use_counter_based_rng << "," << nl;
+  }
+  if (use_async_viz_output != false) {
+    ss << ind << "use_async_viz_output = " << use_async_viz_output << "," << nl;
+  }
+  if (max_pending_viz_frames != 2) {
+    ss << ind << "max_pending_viz_frames = " << max_pending_viz_frames << "," << nl;
+  }
+  if (use_async_count_output != false) {
+    ss << ind << "use_async_count_output = " << use_async_count_output << "," << nl;
+  }
+  if (max_pending_count_output_mb != 64) {
+    ss << ind << "max_pending_count_output_mb = " << max_pending_count_output_mb << "," << nl;
+  }
+  if (use_bvh_for_wall_collisions != false) {
+    ss << ind << "use_bvh_for_wall_collisions = " << use_bvh_for_wall_collisions << "," << nl;
+  }
+  if (use_adaptive_subpartitions != false) {
+    ss << ind << "use_adaptive_subpartitions = " << use_adaptive_subpartitions << "," << nl;
+  }
+  if (use_batched_gaussian_rng != false) {
+    ss << ind << "use_batched_gaussian_rng = " << use_batched_gaussian_rng << "," << nl;
+  }
+  if (use_voxelized_counted_volumes != false) {
+    ss << ind << "use_voxelized_counted_volumes = " << use_voxelized_counted_volumes << "," << nl;
+  }
+  if (use_reaction_pathway_alias_tables != false) {
+    ss << ind << "use_reaction_pathway_alias_tables = " << use_reaction_pathway_alias_tables << "," << nl;
+  }
   if (memory_limit_gb != -1) {
     ss << ind << "memory_limit_gb = " << memory_limit_gb << "," << nl;
   }
@@ -35,12 +35,25 @@ class PythonExportContext;
         const double partition_dimension_ = 10, \
         const std::vector<double> initial_partition_origin_ = std::vector<double>(), \
         const double subpartition_dimension_ = 0.5, \
+        const int num_partitions_per_dimension_ = 1, \
         const double total_iterations_ = 1000000, \
         const bool check_overlapped_walls_ = true, \
         const int reaction_class_cleanup_periodicity_ = 500, \
         const int species_cleanup_periodicity_ = 10000, \
         const int molecules_order_random_shuffle_periodicity_ = 10000, \
         const bool sort_molecules_ = false, \
+        const bool sort_molecules_in_morton_order_ = false, \
+        const int num_threads_ = 1, \
+        const bool use_counter_based_rng_ = false, \
+        const bool use_async_viz_output_ = false, \
+        const int max_pending_viz_frames_ = 2, \
+        const bool use_async_count_output_ = false, \
+        const int max_pending_count_output_mb_ = 64, \
+        const bool use_bvh_for_wall_collisions_ = false, \
+        const bool use_adaptive_subpartitions_ = false, \
+        const bool use_batched_gaussian_rng_ = false, \
+        const bool use_voxelized_counted_volumes_ = false, \
+        const bool use_reaction_pathway_alias_tables_ = false, \
         const int memory_limit_gb_ = -1, \
         const uint64_t initial_iteration_ = 0, \
         const double initial_time_ = 0, \
@@ -60,12 +73,25 @@ class PythonExportContext;
       partition_dimension = partition_dimension_; \
       initial_partition_origin = initial_partition_origin_; \
       subpartition_dimension = subpartition_dimension_; \
+      num_partitions_per_dimension = num_partitions_per_dimension_; \
       total_iterations = total_iterations_; \
       check_overlapped_walls = check_overlapped_walls_; \
       reaction_class_cleanup_periodicity = reaction_class_cleanup_periodicity_; \
       species_cleanup_periodicity = species_cleanup_periodicity_; \
       molecules_order_random_shuffle_periodicity = molecules_order_random_shuffle_periodicity_; \
       sort_molecules = sort_molecules_; \
+      sort_molecules_in_morton_order = sort_molecules_in_morton_order_; \
+      num_threads = num_threads_; \
+      use_counter_based_rng = use_counter_based_rng_; \
+      use_async_viz_output = use_async_viz_output_; \
+      max_pending_viz_frames = max_pending_viz_frames_; \
+      use_async_count_output = use_async_count_output_; \
+      max_pending_count_output_mb = max_pending_count_output_mb_; \
+      use_bvh_for_wall_collisions = use_bvh_for_wall_collisions_; \
+      use_adaptive_subpartitions = use_adaptive_subpartitions_; \
+      use_batched_gaussian_rng = use_batched_gaussian_rng_; \
+      use_voxelized_counted_volumes = use_voxelized_counted_volumes_; \
+      use_reaction_pathway_alias_tables = use_reaction_pathway_alias_tables_; \
       memory_limit_gb = memory_limit_gb_; \
       initial_iteration = initial_iteration_; \
       initial_time = initial_time_; \
@@ -259,6 +285,20 @@ public:
     return subpartition_dimension;
   }
 
+  int num_partitions_per_dimension;
+  virtual void set_num_partitions_per_dimension(const int new_num_partitions_per_dimension_) {
+    if (initialized) {
+      throw RuntimeError("Value 'num_partitions_per_dimension' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    num_partitions_per_dimension = new_num_partitions_per_dimension_;
+  }
+  virtual int get_num_partitions_per_dimension() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return num_partitions_per_dimension;
+  }
+
   double total_iterations;
   virtual void set_total_iterations(const double new_total_iterations_) {
     if (initialized) {
@@ -343,6 +383,174 @@ public:
     return sort_molecules;
   }
 
+  bool sort_molecules_in_morton_order;
+  virtual void set_sort_molecules_in_morton_order(const bool new_sort_molecules_in_morton_order_) {
+    if (initialized) {
+      throw RuntimeError("Value 'sort_molecules_in_morton_order' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    sort_molecules_in_morton_order = new_sort_molecules_in_morton_order_;
+  }
+  virtual bool get_sort_molecules_in_morton_order() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return sort_molecules_in_morton_order;
+  }
+
+  int num_threads;
+  virtual void set_num_threads(const int new_num_threads_) {
+    if (initialized) {
+      throw RuntimeError("Value 'num_threads' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    num_threads = new_num_threads_;
+  }
+  virtual int get_num_threads() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return num_threads;
+  }
+
+  bool use_counter_based_rng;
+  virtual void set_use_counter_based_rng(const bool new_use_counter_based_rng_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_counter_based_rng' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_counter_based_rng = new_use_counter_based_rng_;
+  }
+  virtual bool get_use_counter_based_rng() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_counter_based_rng;
+  }
+
+  bool use_async_viz_output;
+  virtual void set_use_async_viz_output(const bool new_use_async_viz_output_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_async_viz_output' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_async_viz_output = new_use_async_viz_output_;
+  }
+  virtual bool get_use_async_viz_output() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_async_viz_output;
+  }
+
+  int max_pending_viz_frames;
+  virtual void set_max_pending_viz_frames(const int new_max_pending_viz_frames_) {
+    if (initialized) {
+      throw RuntimeError("Value 'max_pending_viz_frames' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    max_pending_viz_frames = new_max_pending_viz_frames_;
+  }
+  virtual int get_max_pending_viz_frames() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return max_pending_viz_frames;
+  }
+
+  bool use_async_count_output;
+  virtual void set_use_async_count_output(const bool new_use_async_count_output_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_async_count_output' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_async_count_output = new_use_async_count_output_;
+  }
+  virtual bool get_use_async_count_output() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_async_count_output;
+  }
+
+  int max_pending_count_output_mb;
+  virtual void set_max_pending_count_output_mb(const int new_max_pending_count_output_mb_) {
+    if (initialized) {
+      throw RuntimeError("Value 'max_pending_count_output_mb' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    max_pending_count_output_mb = new_max_pending_count_output_mb_;
+  }
+  virtual int get_max_pending_count_output_mb() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return max_pending_count_output_mb;
+  }
+
+  bool use_bvh_for_wall_collisions;
+  virtual void set_use_bvh_for_wall_collisions(const bool new_use_bvh_for_wall_collisions_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_bvh_for_wall_collisions' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_bvh_for_wall_collisions = new_use_bvh_for_wall_collisions_;
+  }
+  virtual bool get_use_bvh_for_wall_collisions() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_bvh_for_wall_collisions;
+  }
+
+  bool use_adaptive_subpartitions;
+  virtual void set_use_adaptive_subpartitions(const bool new_use_adaptive_subpartitions_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_adaptive_subpartitions' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_adaptive_subpartitions = new_use_adaptive_subpartitions_;
+  }
+  virtual bool get_use_adaptive_subpartitions() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_adaptive_subpartitions;
+  }
+
+  bool use_batched_gaussian_rng;
+  virtual void set_use_batched_gaussian_rng(const bool new_use_batched_gaussian_rng_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_batched_gaussian_rng' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_batched_gaussian_rng = new_use_batched_gaussian_rng_;
+  }
+  virtual bool get_use_batched_gaussian_rng() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_batched_gaussian_rng;
+  }
+
+  bool use_voxelized_counted_volumes;
+  virtual void set_use_voxelized_counted_volumes(const bool new_use_voxelized_counted_volumes_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_voxelized_counted_volumes' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_voxelized_counted_volumes = new_use_voxelized_counted_volumes_;
+  }
+  virtual bool get_use_voxelized_counted_volumes() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_voxelized_counted_volumes;
+  }
+
+  bool use_reaction_pathway_alias_tables;
+  virtual void set_use_reaction_pathway_alias_tables(const bool new_use_reaction_pathway_alias_tables_) {
+    if (initialized) {
+      throw RuntimeError("Value 'use_reaction_pathway_alias_tables' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    use_reaction_pathway_alias_tables = new_use_reaction_pathway_alias_tables_;
+  }
+  virtual bool get_use_reaction_pathway_alias_tables() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return use_reaction_pathway_alias_tables;
+  }
+
   int memory_limit_gb;
   virtual void set_memory_limit_gb(const int new_memory_limit_gb_) {
     if (initialized) {
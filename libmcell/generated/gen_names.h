@@ -185,6 +185,8 @@ const char* const NAME_LOAD_BNGL_OBSERVABLES = "load_bngl_observables";
 const char* const NAME_LOAD_BNGL_PARAMETERS = "load_bngl_parameters";
 const char* const NAME_LOAD_DAT_FILE = "load_dat_file";
 const char* const NAME_LOCATION = "location";
+const char* const NAME_MAX_PENDING_COUNT_OUTPUT_MB = "max_pending_count_output_mb";
+const char* const NAME_MAX_PENDING_VIZ_FRAMES = "max_pending_viz_frames";
 const char* const NAME_MEMORY_LIMIT_GB = "memory_limit_gb";
 const char* const NAME_MM = "mm";
 const char* const NAME_MODE = "mode";
@@ -200,6 +202,8 @@ const char* const NAME_MULTIPLIER = "multiplier";
 const char* const NAME_NAME = "name";
 const char* const NAME_NODE_TYPE = "node_type";
 const char* const NAME_NOTIFICATIONS = "notifications";
+const char* const NAME_NUM_PARTITIONS_PER_DIMENSION = "num_partitions_per_dimension";
+const char* const NAME_NUM_THREADS = "num_threads";
 const char* const NAME_NUMBER_OF_TRAINS = "number_of_trains";
 const char* const NAME_NUMBER_TO_RELEASE = "number_to_release";
 const char* const NAME_O = "o";
@@ -270,11 +274,13 @@ const char* const NAME_SIMULATION_STATS_EVERY_N_ITERATIONS = "simulation_stats_e
 const char* const NAME_SITE_DIAMETER = "site_diameter";
 const char* const NAME_SITE_RADIUS = "site_radius";
 const char* const NAME_SORT_MOLECULES = "sort_molecules";
+const char* const NAME_SORT_MOLECULES_IN_MORTON_ORDER = "sort_molecules_in_morton_order";
 const char* const NAME_SPECIES = "species";
 const char* const NAME_SPECIES_CLEANUP_PERIODICITY = "species_cleanup_periodicity";
 const char* const NAME_SPECIES_ID = "species_id";
 const char* const NAME_SPECIES_LIST = "species_list";
 const char* const NAME_SPECIES_PATTERN = "species_pattern";
+const char* const NAME_STARTUP_TIMING_REPORT = "startup_timing_report";
 const char* const NAME_STATE = "state";
 const char* const NAME_STATES = "states";
 const char* const NAME_SUBDIVISIONS = "subdivisions";
@@ -298,7 +304,15 @@ const char* const NAME_TYPE = "type";
 const char* const NAME_UNIMOL_RXN_TIME = "unimol_rxn_time";
 const char* const NAME_UNIT_NORMAL = "unit_normal";
 const char* const NAME_UNPAIR_MOLECULES = "unpair_molecules";
+const char* const NAME_USE_ADAPTIVE_SUBPARTITIONS = "use_adaptive_subpartitions";
+const char* const NAME_USE_ASYNC_COUNT_OUTPUT = "use_async_count_output";
+const char* const NAME_USE_ASYNC_VIZ_OUTPUT = "use_async_viz_output";
+const char* const NAME_USE_BATCHED_GAUSSIAN_RNG = "use_batched_gaussian_rng";
 const char* const NAME_USE_BNG_UNITS = "use_bng_units";
+const char* const NAME_USE_BVH_FOR_WALL_COLLISIONS = "use_bvh_for_wall_collisions";
+const char* const NAME_USE_COUNTER_BASED_RNG = "use_counter_based_rng";
+const char* const NAME_USE_REACTION_PATHWAY_ALIAS_TABLES = "use_reaction_pathway_alias_tables";
+const char* const NAME_USE_VOXELIZED_COUNTED_VOLUMES = "use_voxelized_counted_volumes";
 const char* const NAME_VACANCY_SEARCH_DISTANCE = "vacancy_search_distance";
 const char* const NAME_VALIDATE_VOLUMETRIC_MESH = "validate_volumetric_mesh";
 const char* const NAME_VARIABLE_RATE = "variable_rate";
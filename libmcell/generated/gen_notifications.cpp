@@ -33,6 +33,7 @@ void GenNotifications::set_all_attributes_as_default_or_unset() {
   rxn_probability_changed = true;
   iteration_report = true;
   wall_overlap_report = false;
+  startup_timing_report = false;
 }
 
 std::shared_ptr<Notifications> GenNotifications::copy_notifications() const {
@@ -44,6 +45,7 @@ std::shared_ptr<Notifications> GenNotifications::copy_notifications() const {
   res->rxn_probability_changed = rxn_probability_changed;
   res->iteration_report = iteration_report;
   res->wall_overlap_report = wall_overlap_report;
+  res->startup_timing_report = startup_timing_report;
 
   return res;
 }
@@ -57,6 +59,7 @@ std::shared_ptr<Notifications> GenNotifications::deepcopy_notifications(py::dict
   res->rxn_probability_changed = rxn_probability_changed;
   res->iteration_report = iteration_report;
   res->wall_overlap_report = wall_overlap_report;
+  res->startup_timing_report = startup_timing_report;
 
   return res;
 }
@@ -68,7 +71,8 @@ bool GenNotifications::__eq__(const Notifications& other) const {
     simulation_stats_every_n_iterations == other.simulation_stats_every_n_iterations &&
     rxn_probability_changed == other.rxn_probability_changed &&
     iteration_report == other.iteration_report &&
-    wall_overlap_report == other.wall_overlap_report;
+    wall_overlap_report == other.wall_overlap_report &&
+    startup_timing_report == other.startup_timing_report;
 }
 
 bool GenNotifications::eq_nonarray_attributes(const Notifications& other, const bool ignore_name) const {
@@ -78,7 +82,8 @@ bool GenNotifications::eq_nonarray_attributes(const Notifications& other, const
     simulation_stats_every_n_iterations == other.simulation_stats_every_n_iterations &&
     rxn_probability_changed == other.rxn_probability_changed &&
     iteration_report == other.iteration_report &&
-    wall_overlap_report == other.wall_overlap_report;
+    wall_overlap_report == other.wall_overlap_report &&
+    startup_timing_report == other.startup_timing_report;
 }
 
 std::string GenNotifications::to_str(const bool all_details, const std::string ind) const {
@@ -89,7 +94,8 @@ std::string GenNotifications::to_str(const bool all_details, const std::string i
       "simulation_stats_every_n_iterations=" << simulation_stats_every_n_iterations << ", " <<
       "rxn_probability_changed=" << rxn_probability_changed << ", " <<
       "iteration_report=" << iteration_report << ", " <<
-      "wall_overlap_report=" << wall_overlap_report;
+      "wall_overlap_report=" << wall_overlap_report << ", " <<
+      "startup_timing_report=" << startup_timing_report;
   return ss.str();
 }
 
@@ -102,6 +108,7 @@ py::class_<Notifications> define_pybinding_Notifications(py::module& m) {
             const int,
             const bool,
             const bool,
+            const bool,
             const bool
           >(),
           py::arg("bng_verbosity_level") = 0,
@@ -109,7 +116,8 @@ py::class_<Notifications> define_pybinding_Notifications(py::module& m) {
           py::arg("simulation_stats_every_n_iterations") = 0,
           py::arg("rxn_probability_changed") = true,
           py::arg("iteration_report") = true,
-          py::arg("wall_overlap_report") = false
+          py::arg("wall_overlap_report") = false,
+          py::arg("startup_timing_report") = false
       )
       .def("check_semantics", &Notifications::check_semantics)
       .def("__copy__", &Notifications::copy_notifications)
@@ -123,6 +131,7 @@ py::class_<Notifications> define_pybinding_Notifications(py::module& m) {
       .def_property("rxn_probability_changed", &Notifications::get_rxn_probability_changed, &Notifications::set_rxn_probability_changed, "When True, information that a reaction's probability has changed is printed during simulation.    \n")
       .def_property("iteration_report", &Notifications::get_iteration_report, &Notifications::set_iteration_report, "When True, a running report of how many iterations have completed, chosen based \non the total number of iterations, will be printed during simulation.\n")
       .def_property("wall_overlap_report", &Notifications::get_wall_overlap_report, &Notifications::set_wall_overlap_report, "When True, information on wall overlaps will be printed. \n")
+      .def_property("startup_timing_report", &Notifications::get_startup_timing_report, &Notifications::set_startup_timing_report, "When True, wall-clock time spent in individual phases of simulation initialization,\nsuch as processing of counted volumes, waypoints, and wall grids, is printed\nonce the initialization finishes. \n")
     ;
 }
 
@@ -163,6 +172,9 @@ std::string GenNotifications::export_to_python(std::ostream& out, PythonExportCo
   if (wall_overlap_report != false) {
     ss << ind << "wall_overlap_report = " << wall_overlap_report << "," << nl;
   }
+  if (startup_timing_report != false) {
+    ss << ind << "startup_timing_report = " << startup_timing_report << "," << nl;
+  }
   ss << ")" << nl << nl;
   if (!str_export) {
     out << ss.str();
@@ -28,7 +28,8 @@ class PythonExportContext;
         const int simulation_stats_every_n_iterations_ = 0, \
         const bool rxn_probability_changed_ = true, \
         const bool iteration_report_ = true, \
-        const bool wall_overlap_report_ = false \
+        const bool wall_overlap_report_ = false, \
+        const bool startup_timing_report_ = false \
     ) { \
       class_name = "Notifications"; \
       bng_verbosity_level = bng_verbosity_level_; \
@@ -37,6 +38,7 @@ class PythonExportContext;
       rxn_probability_changed = rxn_probability_changed_; \
       iteration_report = iteration_report_; \
       wall_overlap_report = wall_overlap_report_; \
+      startup_timing_report = startup_timing_report_; \
       postprocess_in_ctor(); \
       check_semantics(); \
     } \
@@ -153,6 +155,20 @@ public:
     return wall_overlap_report;
   }
 
+  bool startup_timing_report;
+  virtual void set_startup_timing_report(const bool new_startup_timing_report_) {
+    if (initialized) {
+      throw RuntimeError("Value 'startup_timing_report' of object with name " + name + " (class " + class_name + ") "
+                         "cannot be set after model was initialized.");
+    }
+    cached_data_are_uptodate = false;
+    startup_timing_report = new_startup_timing_report_;
+  }
+  virtual bool get_startup_timing_report() const {
+    cached_data_are_uptodate = false; // arrays and other data can be modified through getters
+    return startup_timing_report;
+  }
+
   // --- methods ---
 }; // GenNotifications
 
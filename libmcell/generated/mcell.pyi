@@ -362,12 +362,25 @@ class Config():
             partition_dimension : float = 10,
             initial_partition_origin : List[float] = None,
             subpartition_dimension : float = 0.5,
+            num_partitions_per_dimension : int = 1,
             total_iterations : float = 1000000,
             check_overlapped_walls : bool = True,
             reaction_class_cleanup_periodicity : int = 500,
             species_cleanup_periodicity : int = 10000,
             molecules_order_random_shuffle_periodicity : int = 10000,
             sort_molecules : bool = False,
+            sort_molecules_in_morton_order : bool = False,
+            num_threads : int = 1,
+            use_counter_based_rng : bool = False,
+            use_async_viz_output : bool = False,
+            max_pending_viz_frames : int = 2,
+            use_async_count_output : bool = False,
+            max_pending_count_output_mb : int = 64,
+            use_bvh_for_wall_collisions : bool = False,
+            use_adaptive_subpartitions : bool = False,
+            use_batched_gaussian_rng : bool = False,
+            use_voxelized_counted_volumes : bool = False,
+            use_reaction_pathway_alias_tables : bool = False,
             memory_limit_gb : int = -1,
             initial_iteration : int = 0,
             initial_time : float = 0,
@@ -386,12 +399,25 @@ class Config():
         self.partition_dimension = partition_dimension
         self.initial_partition_origin = initial_partition_origin
         self.subpartition_dimension = subpartition_dimension
+        self.num_partitions_per_dimension = num_partitions_per_dimension
         self.total_iterations = total_iterations
         self.check_overlapped_walls = check_overlapped_walls
         self.reaction_class_cleanup_periodicity = reaction_class_cleanup_periodicity
         self.species_cleanup_periodicity = species_cleanup_periodicity
         self.molecules_order_random_shuffle_periodicity = molecules_order_random_shuffle_periodicity
         self.sort_molecules = sort_molecules
+        self.sort_molecules_in_morton_order = sort_molecules_in_morton_order
+        self.num_threads = num_threads
+        self.use_counter_based_rng = use_counter_based_rng
+        self.use_async_viz_output = use_async_viz_output
+        self.max_pending_viz_frames = max_pending_viz_frames
+        self.use_async_count_output = use_async_count_output
+        self.max_pending_count_output_mb = max_pending_count_output_mb
+        self.use_bvh_for_wall_collisions = use_bvh_for_wall_collisions
+        self.use_adaptive_subpartitions = use_adaptive_subpartitions
+        self.use_batched_gaussian_rng = use_batched_gaussian_rng
+        self.use_voxelized_counted_volumes = use_voxelized_counted_volumes
+        self.use_reaction_pathway_alias_tables = use_reaction_pathway_alias_tables
         self.memory_limit_gb = memory_limit_gb
         self.initial_iteration = initial_iteration
         self.initial_time = initial_time
@@ -1140,7 +1166,8 @@ class Notifications():
             simulation_stats_every_n_iterations : int = 0,
             rxn_probability_changed : bool = True,
             iteration_report : bool = True,
-            wall_overlap_report : bool = False
+            wall_overlap_report : bool = False,
+            startup_timing_report : bool = False
         ):
         self.bng_verbosity_level = bng_verbosity_level
         self.rxn_and_species_report = rxn_and_species_report
@@ -1148,6 +1175,7 @@ class Notifications():
         self.rxn_probability_changed = rxn_probability_changed
         self.iteration_report = iteration_report
         self.wall_overlap_report = wall_overlap_report
+        self.startup_timing_report = startup_timing_report
 
 
 class Observables():
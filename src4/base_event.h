@@ -46,6 +46,7 @@ const event_type_index_t EVENT_TYPE_INDEX_SIMULATION_END_CHECK = 301;
 const event_type_index_t EVENT_TYPE_INDEX_RXN_CLASS_CLEANUP = 400;
 const event_type_index_t EVENT_TYPE_INDEX_SPECIES_CLEANUP = 410;
 const event_type_index_t EVENT_TYPE_INDEX_SORT_MOLS_BY_SUBPART = 420;
+const event_type_index_t EVENT_TYPE_INDEX_REBALANCE_SUBPART_CELLS = 430;
 
 const event_type_index_t EVENT_TYPE_INDEX_CLAMP_RELEASE = 490;
 const event_type_index_t EVENT_TYPE_INDEX_DIFFUSE_REACT = 500;  // this event spans the whole time step
@@ -121,6 +122,23 @@ public:
     assert(false && "Only overridden variant of this method may be called.");
   }
 
+  // - events such as DiffuseReactEvent may skip iterations in which they have nothing to do,
+  //   the returned value is the time that this event would like to skip after its
+  //   execution, 0 means that no time is skipped
+  // - called after step, the scheduler then limits the value with ends_idle_time_skipping
+  //   and passes it to set_idle_time_to_skip
+  virtual double get_idle_time_to_skip() const { return 0; }
+
+  virtual void set_idle_time_to_skip(const double time) {
+    // the subclass must return a nonzero value in get_idle_time_to_skip
+    assert(false && "Only overridden variant of this method may be called.");
+  }
+
+  // events that may create molecules or make them ready for diffusion earlier
+  // end the idle time skipped by events such as DiffuseReactEvent,
+  // events that only read or reorder molecules may return false
+  virtual bool ends_idle_time_skipping() const { return true; }
+
   // used by checkpointing
   virtual bool return_from_run_n_iterations_after_execution() const {
     return false;
@@ -223,7 +223,8 @@ void ClampReleaseEvent::step() {
 
     Vec3 pos = v + w.normal * Vec3(eps);
 
-    Molecule& new_vm = p.add_volume_molecule(
+    // walls are present in all partitions, the molecule goes to the one that contains it
+    Molecule& new_vm = world->get_partition_for_pos(pos).add_volume_molecule(
           Molecule(MOLECULE_ID_INVALID, species_id, pos, event_time), 0.5 /* release delay time */
     );
     new_vm.flags |= MOLECULE_FLAG_ACT_CLAMPED | MOLECULE_FLAG_SCHEDULE_UNIMOL_RXN;
@@ -534,8 +534,7 @@ static void collide_mol_loop_body(
   // collide_mol must be inlined because many things are computed all over there
   if (collide_mol(vm, remaining_displacement, colliding_vm, radius, time, position)) {
 
-    BNG::RxnClass* rxn_class =
-        p.get_all_rxns().get_bimol_rxn_class(vm.species_id, colliding_vm.species_id);
+    BNG::RxnClass* rxn_class = p.get_bimol_rxn_class(vm.species_id, colliding_vm.species_id);
 
     if (rxn_class == nullptr) {
       // reactants are not in compartments that match
@@ -552,6 +551,69 @@ static void collide_mol_loop_body(
 }
 
 
+// number of potential reactants screened together by collide_mols_batched,
+// the inner loop has a fixed length so that compilers can vectorize it
+const uint MOL_COLLISION_BATCH_SIZE = 8;
+
+// calls collide_mol_loop_body for each molecule from colliding_vm_ids that passes
+// the distance checks of collide_mol, positions of candidates are first gathered into
+// packed arrays and the checks are evaluated for a whole batch at once,
+// uses the same arithmetic as collide_mol so that the same collisions are found in the same order
+static void collide_mols_batched(
+    Partition& p,
+    const Molecule& vm,
+    const MoleculeIdsVector& colliding_vm_ids,
+    const Vec3& remaining_displacement,
+    const pos_t radius,
+    CollisionsVector& molecule_collisions
+) {
+  const Vec3& start = vm.v.pos;
+  const Vec3& move = remaining_displacement;
+
+  pos_t movelen2 = glm::dot((glm_vec3_t)move, (glm_vec3_t)move);
+  assert(movelen2 != 0);
+  pos_t sigma2 = radius * radius;
+  pos_t movelen2_sigma2 = movelen2 * sigma2;
+
+  size_t num_ids = colliding_vm_ids.size();
+  for (size_t base = 0; base < num_ids; base += MOL_COLLISION_BATCH_SIZE) {
+    uint count = std::min((size_t)MOL_COLLISION_BATCH_SIZE, num_ids - base);
+
+    // vectors from the start of the move to the candidates,
+    // unused items point against the move so that they are always rejected
+    pos_t dir_x[MOL_COLLISION_BATCH_SIZE];
+    pos_t dir_y[MOL_COLLISION_BATCH_SIZE];
+    pos_t dir_z[MOL_COLLISION_BATCH_SIZE];
+    for (uint i = 0; i < count; i++) {
+      const Vec3& pos = p.get_m(colliding_vm_ids[base + i]).v.pos;
+      dir_x[i] = pos.x - start.x;
+      dir_y[i] = pos.y - start.y;
+      dir_z[i] = pos.z - start.z;
+    }
+    for (uint i = count; i < MOL_COLLISION_BATCH_SIZE; i++) {
+      dir_x[i] = -move.x;
+      dir_y[i] = -move.y;
+      dir_z[i] = -move.z;
+    }
+
+    bool may_collide[MOL_COLLISION_BATCH_SIZE];
+    for (uint i = 0; i < MOL_COLLISION_BATCH_SIZE; i++) {
+      pos_t d = dir_x[i] * move.x + dir_y[i] * move.y + dir_z[i] * move.z;
+      pos_t dirlen2 = dir_x[i] * dir_x[i] + dir_y[i] * dir_y[i] + dir_z[i] * dir_z[i];
+      // negated rejection conditions of collide_mol
+      may_collide[i] = (d >= 0) & (d <= movelen2) & (movelen2 * dirlen2 - d * d <= movelen2_sigma2);
+    }
+
+    for (uint i = 0; i < count; i++) {
+      if (may_collide[i]) {
+        collide_mol_loop_body(
+            p, vm, colliding_vm_ids[base + i], remaining_displacement, radius, molecule_collisions);
+      }
+    }
+  }
+}
+
+
 // ---------------------------------- wall collisions ----------------------------------
 
 
@@ -635,9 +697,15 @@ static inline CollisionType INLINE_ATTR collide_wall(
     Vec3& move,
     stime_t& collision_time, Vec3& collision_pos,
     const bool wall_exists_in_partition = true, // wall_index is ignored when this is set to false
-    const WallWithVertices* wall_outside_partition = nullptr
+    const WallWithVertices* wall_outside_partition = nullptr,
+    SimulationStats* stats = nullptr // p.stats is used when nullptr
 ) {
-  p.stats.inc_ray_polygon_tests();
+  if (stats != nullptr) {
+    stats->inc_ray_polygon_tests();
+  }
+  else {
+    p.stats.inc_ray_polygon_tests();
+  }
 
   pos_t dp, dv, dd;
   pos_t d_eps;
@@ -841,13 +909,14 @@ restart_on_redo:
   // remember which was the closest hit to update displacement
   stime_t closest_hit_time = TIME_FOREVER;
 
-  // check each wall in this subpartition
-  const WallsInSubpart& wall_indices = p.get_subpart_wall_indices(subpart_index);
+  // check each wall in this subpartition, walls whose plane is not crossed by the
+  // displacement are rejected in batches, collide_wall would reject the same walls
+  WallIndicesVector wall_indices;
+  uint num_rejected_walls = p.get_subpart_wall_batch(subpart_index).collect_candidate_walls(
+      vm.v.pos, displacement, last_hit_wall_index, wall_indices);
+  p.stats.add_ray_polygon_tests(num_rejected_walls);
 
   for (wall_index_t wall_index: wall_indices) {
-    if (wall_index == last_hit_wall_index) {
-      continue;
-    }
 
 #ifdef DEBUG_COLLISIONS_WALL_EXTRA
     SimulationStats* world = &p.stats;
@@ -914,6 +983,57 @@ restart_on_redo:
 }
 
 
+// variant of get_closest_wall_collision that uses the partition's WallBvh instead of
+// walls in subpartitions, the closest hit along the whole displacement is returned
+static inline bool INLINE_ATTR get_closest_wall_collision_using_bvh(
+    Partition& p,
+    const Molecule& vm, // molecule that we are diffusing
+    const wall_index_t last_hit_wall_index,
+    rng_state& rng,
+    // displacement can be changed in case we needed to 'REDO' the collision
+    Vec3& displacement,
+    Vec3& displacement_up_to_wall_collision, // overwritten only when there is a wall collision
+    Collision& closest_collision
+) {
+  assert(p.get_wall_bvh().is_built());
+
+restart_on_redo:
+
+  bool collision_found = false;
+  stime_t closest_hit_time = TIME_FOREVER;
+
+  WallIndicesVector wall_indices;
+  p.get_wall_bvh().collect_walls_along_segment(vm.v.pos, displacement, last_hit_wall_index, wall_indices);
+
+  for (wall_index_t wall_index: wall_indices) {
+    stime_t collision_time;
+    Vec3 collision_pos;
+    CollisionType collision_type =
+        collide_wall(p, vm.v.pos, wall_index, rng, true, true, displacement, collision_time, collision_pos);
+
+    if (collision_type == CollisionType::WALL_REDO) {
+      // displacement was changed, walls along the new displacement must be collected again
+      goto restart_on_redo;
+    }
+    else if (collision_type != CollisionType::WALL_MISS) {
+      p.stats.inc_ray_polygon_colls();
+
+      if (collision_time < closest_hit_time) {
+        collision_found = true;
+        closest_hit_time = collision_time;
+        closest_collision = Collision(collision_type, &p, vm.id, collision_time, collision_pos, wall_index);
+      }
+    }
+  }
+
+  if (collision_found) {
+    displacement_up_to_wall_collision = closest_collision.pos - vm.v.pos;
+  }
+
+  return collision_found;
+}
+
+
 // returns true if there was a collision with a wall,
 // HIT REDO is not supported
 static bool collide_wall_test(
@@ -1396,10 +1516,14 @@ static stime_t get_num_crossed_walls_per_object(
     map<geometry_object_index_t, uint>& num_crossed_walls_per_object,
     bool& must_redo_test,
     geometry_object_id_t ignored_object_id = GEOMETRY_OBJECT_ID_INVALID,
-    wall_index_t* closest_hit_wall_index = nullptr
+    wall_index_t* closest_hit_wall_index = nullptr,
+    rng_state* rng = nullptr, // p.aux_rng is used when nullptr
+    SimulationStats* stats = nullptr // p.stats is used when nullptr
 ) {
   stime_t min_collision_time = 1; // 1 - no collision
 
+  rng_state& collision_rng = (rng != nullptr) ? *rng : p.aux_rng;
+
   if (closest_hit_wall_index != nullptr) {
     *closest_hit_wall_index = WALL_INDEX_INVALID;
   }
@@ -1442,8 +1566,8 @@ static stime_t get_num_crossed_walls_per_object(
       stime_t collision_time;
       Vec3 collision_pos_ignored;
       CollisionType collision_type = collide_wall(
-            p, pos, wall_index, p.aux_rng, false, true, displacement,
-            collision_time, collision_pos_ignored);
+            p, pos, wall_index, collision_rng, false, true, displacement,
+            collision_time, collision_pos_ignored, true, nullptr, stats);
 
       if (collision_type == CollisionType::WALL_REDO) {
         must_redo_test = true;
@@ -1511,13 +1635,15 @@ static bool is_point_inside_region_no_waypoints(
 }
 
 
-// does not set res.index, the index needs to be obtained from partition
-static counted_volume_index_t compute_counted_volume_for_pos(
-    Partition& p, const Vec3& pos) {
+// does not set cv.index, the index needs to be obtained from partition
+// does not modify the partition and shared stats when rng and stats are provided,
+// so it can be called from multiple threads
+static void collect_counted_objects_for_pos(
+    const Partition& p, const Vec3& pos, CountedVolume& cv,
+    rng_state* rng = nullptr, SimulationStats* stats = nullptr) {
 
   map<geometry_object_index_t, uint> num_crossed_walls_per_object;
 
-  CountedVolume cv;
 #if 1
   // send a ray trace and collect all walls we crossed,
   // then if we hit wall of an object odd number of times, we are inside of an object
@@ -1532,7 +1658,9 @@ static counted_volume_index_t compute_counted_volume_for_pos(
   dst.y += p.config.subpart_edge_length / (pos_t)21;
 
   bool must_redo_test;
-  get_num_crossed_walls_per_object(p, pos, dst, true, num_crossed_walls_per_object, must_redo_test);
+  get_num_crossed_walls_per_object(
+      p, pos, dst, true, num_crossed_walls_per_object, must_redo_test,
+      GEOMETRY_OBJECT_ID_INVALID, nullptr, rng, stats);
   release_assert(!must_redo_test);
 
   // finally construct the set of object indices that encompass the position
@@ -1553,7 +1681,7 @@ static counted_volume_index_t compute_counted_volume_for_pos(
   // but for now let's keep it simple
 
   cv.contained_in_objects.clear();
-  for (GeometryObject& obj: p.get_geometry_objects()) {
+  for (const GeometryObject& obj: p.get_geometry_objects()) {
     if (obj.is_counted_volume_or_compartment()) {
       if (VtkUtils::is_point_inside_counted_volume(obj, pos)) {
         cv.contained_in_objects.insert(obj.index);
@@ -1561,7 +1689,14 @@ static counted_volume_index_t compute_counted_volume_for_pos(
     }
   }
 #endif
+}
+
+
+static counted_volume_index_t compute_counted_volume_for_pos(
+    Partition& p, const Vec3& pos) {
 
+  CountedVolume cv;
+  collect_counted_objects_for_pos(p, pos, cv);
   return p.find_or_add_counted_volume(cv);
 }
 
@@ -1582,6 +1717,15 @@ static counted_volume_index_t compute_counted_volume_using_waypoints(
     subpart_index_t subpart_index = p.get_subpart_index(pos);
     p.get_subpart_3d_indices_from_index(subpart_index, index3d);
 
+    // voxels are precomputed for most positions
+    if (p.get_counted_volume_voxels().is_built()) {
+      counted_volume_index_t voxel_counted_volume_index =
+          p.get_counted_volume_voxels().get_counted_volume_index(p, pos, subpart_index);
+      if (voxel_counted_volume_index != COUNTED_VOLUME_INDEX_INVALID) {
+        return voxel_counted_volume_index;
+      }
+    }
+
     // waypoint is always in the center of a subpartition
     waypoint = &p.get_waypoint(index3d);
 
@@ -1658,7 +1802,7 @@ static void update_counted_volume_id_when_crossing_wall(
 
       if (obj.counted_volume_index_outside != COUNTED_VOLUME_INDEX_INTERSECTS) {
         // no intersect - it is clear what is outside
-        vm.v.counted_volume_index = obj.counted_volume_index_outside;
+        p.set_counted_volume_index(vm, obj.counted_volume_index_outside);
       }
       else {
 
@@ -1666,7 +1810,7 @@ static void update_counted_volume_id_when_crossing_wall(
         Vec3 displacement = Vec3((pos_t)2 * bump) * w.normal;
 
         // intersect - need to check waypoints or simply recompute the counted volumes
-        vm.v.counted_volume_index = compute_counted_volume_using_waypoints(p, vm.v.pos + displacement);
+        p.set_counted_volume_index(vm, compute_counted_volume_using_waypoints(p, vm.v.pos + displacement));
       }
     }
     else if (orientation == ORIENTATION_DOWN) { // for hits - WALL_FRONT
@@ -1678,13 +1822,13 @@ static void update_counted_volume_id_when_crossing_wall(
 
       if (obj.counted_volume_index_outside != COUNTED_VOLUME_INDEX_INTERSECTS) {
         // no intersect - it is clear what is inside
-        vm.v.counted_volume_index = obj.counted_volume_index_inside;
+        p.set_counted_volume_index(vm, obj.counted_volume_index_inside);
       }
       else {
         pos_t bump = -POS_EPS; // hit from front - we go against the direction of the normal
         Vec3 displacement = Vec3((pos_t)2 * bump) * w.normal;
 
-        vm.v.counted_volume_index = compute_counted_volume_using_waypoints(p, vm.v.pos + displacement);
+        p.set_counted_volume_index(vm, compute_counted_volume_using_waypoints(p, vm.v.pos + displacement));
       }
     }
     else {
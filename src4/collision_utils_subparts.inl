@@ -34,14 +34,16 @@ namespace MCell {
 namespace CollisionUtils {
 
 // This function checks if any of the neighboring subpartitions are within radius
-// from pos and inserts them into crossed_subparition_indices
+// from pos and inserts them into crossed_subparition_indices,
+// the position is classified into one of 27 zones of its subpartition and
+// the neighbors for this zone are taken from a table precomputed by Partition
 static inline void __attribute__((always_inline)) collect_neighboring_subparts(
     const Partition& p,
     const Vec3& pos,
     const IVec3& subpart_indices,
     const pos_t rxn_radius,
     const pos_t subpart_edge_len,
-    SubpartIndicesSet& crossed_subpart_indices
+    SubpartIndicesOrderedSet& crossed_subpart_indices
 ) {
   const pos_t part_len = p.config.partition_edge_length;
 
@@ -53,71 +55,26 @@ static inline void __attribute__((always_inline)) collect_neighboring_subparts(
 
   Vec3 boundary = Vec3(subpart_indices) * Vec3(subpart_edge_len);
 
-  // left (x)
-  int x_dir_used = 0;
-  if (rel_pos_minus_radius.x < boundary.x && rel_pos_minus_radius.x > 0.0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x - 1, subpart_indices.y, subpart_indices.z));
-    x_dir_used = -1;
-  }
-  // right (x)
-  else if (rel_pos_plus_radius.x > boundary.x + subpart_edge_len && rel_pos_plus_radius.x < part_len) { // assuming that subpartitions are larger than radius
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x + 1, subpart_indices.y, subpart_indices.z));
-    x_dir_used = +1;
-  }
-
-  // upper (y)
-  int y_dir_used = 0;
-  if (rel_pos_minus_radius.y < boundary.y && rel_pos_minus_radius.y > 0.0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x, subpart_indices.y - 1, subpart_indices.z));
-    y_dir_used = -1;
-  }
-  // right (y)
-  else if (rel_pos_plus_radius.y > boundary.y + subpart_edge_len && rel_pos_plus_radius.y < part_len) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x, subpart_indices.y + 1, subpart_indices.z));
-    y_dir_used = +1;
-  }
-
-  // front (z)
-  int z_dir_used = 0;
-  if (rel_pos_minus_radius.z < boundary.z && rel_pos_minus_radius.z > 0.0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x, subpart_indices.y, subpart_indices.z - 1));
-    z_dir_used = -1;
-  }
-  // back (z)
-  else if (rel_pos_plus_radius.z > boundary.z + subpart_edge_len && rel_pos_plus_radius.z < part_len) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x, subpart_indices.y, subpart_indices.z + 1));
-    z_dir_used = +1;
-  }
-
-  // we also have to count with movement in multiple dimensions
-  // xy
-  if (x_dir_used != 0 && y_dir_used != 0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x + x_dir_used, subpart_indices.y + y_dir_used, subpart_indices.z));
-  }
-
-  // xz
-  if (x_dir_used != 0 && z_dir_used != 0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x + x_dir_used, subpart_indices.y, subpart_indices.z + z_dir_used));
+  // lower boundary has precedence, assuming that subpartitions are larger than radius
+  IVec3 zone_dirs(0);
+  for (int i = 0; i < 3; i++) {
+    if (rel_pos_minus_radius[i] < boundary[i] && rel_pos_minus_radius[i] > 0.0) {
+      zone_dirs[i] = -1;
+    }
+    else if (rel_pos_plus_radius[i] > boundary[i] + subpart_edge_len && rel_pos_plus_radius[i] < part_len) {
+      zone_dirs[i] = +1;
+    }
   }
 
-  // yz
-  if (y_dir_used != 0 && z_dir_used != 0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x, subpart_indices.y + y_dir_used, subpart_indices.z + z_dir_used));
+  const NeighborSubpartOffsets& neighbors =
+      p.get_neighbor_subpart_offsets(NeighborSubpartOffsets::get_zone_index(zone_dirs));
+  if (neighbors.count == 0) {
+    return;
   }
 
-  // xyz
-  if (x_dir_used != 0 && y_dir_used != 0 && z_dir_used != 0) {
-    crossed_subpart_indices.insert(
-        p.get_subpart_index_from_3d_indices(subpart_indices.x + x_dir_used, subpart_indices.y + y_dir_used, subpart_indices.z + z_dir_used));
+  subpart_index_t subpart_index = p.get_subpart_index_from_3d_indices(subpart_indices);
+  for (uint i = 0; i < neighbors.count; i++) {
+    crossed_subpart_indices.insert(subpart_index + neighbors.offsets[i]);
   }
 }
 
@@ -133,7 +90,7 @@ static inline subpart_index_t __attribute__((always_inline)) collect_crossed_sub
   const bool collect_for_molecules,
   const bool collect_for_walls,
   SubpartIndicesVector& crossed_subparts_for_walls, // crossed subparts considered for wall collision
-  SubpartIndicesSet& crossed_subparts_for_molecules // crossed subparts considered for molecule collisions
+  SubpartIndicesOrderedSet& crossed_subparts_for_molecules // crossed subparts considered for molecule collisions
 ) {
   subpart_index_t current_subpart_index = vm.v.subpart_index;
 
@@ -195,9 +152,9 @@ static inline subpart_index_t __attribute__((always_inline)) collect_crossed_sub
     );
   }
 
-  // collect subpartitions on the way by always finding the point where a subpartition boundary is hit
-  // we must do it even when we are crossing just one subpartition because we might hit others while
-  // moving along them
+  // collect subpartitions on the way by a 3D-DDA traversal that always steps into the subpartition
+  // whose boundary is hit first, we must do it even when we are crossing just one subpartition
+  // because we might hit others while moving along them
   subpart_index_t dest_subpart_index = p.get_subpart_index_from_3d_indices_allow_outside(dest_subpart_indices);
   if ( current_subpart_index != dest_subpart_index) {
 
@@ -207,69 +164,61 @@ static inline subpart_index_t __attribute__((always_inline)) collect_crossed_sub
         (dir_urb_direction.z == 0) ? -1 : 1
     );
 
-    Vec3 curr_pos = vm.v.pos;
-    IVec3 curr_subpart_indices = src_subpart_indices;
-
-    subpart_index_t curr_subpart_index;
-
+    // change of subpartition index when moving to the next subpartition along each axis
+    const int dim = p.config.num_subparts_per_partition_edge;
+    const IVec3 subpart_index_addend(
+        dir_urb_addend.x, dir_urb_addend.y * dim, dir_urb_addend.z * (int)p.config.num_subparts_per_partition_edge_squared);
+
+    // number of boundaries crossed along each axis, the destination may lie behind the partition boundary
+    // and rounding may place it into a subpartition that is behind the start
+    IVec3 last_subpart_indices(glm::clamp((glm_ivec3_t)dest_subpart_indices, glm_ivec3_t(0), glm_ivec3_t(dim - 1)));
+    IVec3 remaining_steps(glm::max(
+        (last_subpart_indices - src_subpart_indices) * dir_urb_addend, glm_ivec3_t(0)));
+
+    // let's assume that displacement is our speed vector and the total time to travel is 1,
+    // coll_times are times when the next subpartition boundary is hit along each axis
+    // (values may be negative due to float imprecisions) and time_deltas are times needed
+    // to cross a whole subpartition
+    Vec3 sp_len_as_vec3(sp_edge_length);
     Vec3 displacement_rcp = Vec3(1.0)/displacement_nonzero;
+    Vec3 sp_edges =
+        p.get_origin_corner()
+        + Vec3(src_subpart_indices) * sp_len_as_vec3 // llf edge
+        + Vec3(dir_urb_direction) * sp_len_as_vec3; // move if we go urb
+    Vec3 coll_times = (sp_edges - vm.v.pos) * displacement_rcp;
+    Vec3 time_deltas = sp_len_as_vec3 * Vec3(glm::abs((glm_vec3_t)displacement_rcp));
 
-    do {
-      // subpartition edges
-      // = origin + subparition index * length + is_urb * length
-
-      // NOTE: some of these computation can be moved out of the loop, not sure if it will improve performance
-      Vec3 sp_len_as_vec3(sp_edge_length);
-      Vec3 sp_edges =
-          p.get_origin_corner()
-          + Vec3(curr_subpart_indices) * sp_len_as_vec3 // llf edge
-          + Vec3(dir_urb_direction) * sp_len_as_vec3; // move if we go urb
-
-      Vec3 diff = sp_edges - curr_pos;
-
-#if POS_T_BYTES == 4
-      pos_t dist = POS_SQRT_EPS;
-#else
-      pos_t dist = POS_EPS;
-#endif	  
-
-      // compute time for the next subpartition collision, let's assume that displacemnt
-      // is our speed vector and the total time to travel is 1
-      //
-      // pos(time) = pos + displacement * time, therefore
-      // time = (pos(time) - vm.v.pos) / displacement
-      // =>
-      // time_to_subpart_edge = (subpart_edge - vm.v.pos) / displacement_speed
-      Vec3 coll_times = diff * displacement_rcp;
-      //note: one of coll_times may be negative due to float imprecisions
-
-      // which of the times is the smallest? - i.e. which boundary we hit first (values may be negative due to flt32 imprecisions)
-      if (coll_times.x < coll_times.y && coll_times.x <= coll_times.z) {
-        // new position on the edge of the subpartition
-        curr_pos += displacement * coll_times.x;
-        // and also update the xyz subpartition index
-        curr_subpart_indices.x += dir_urb_addend.x;
-        if (!p.is_subpart_index_in_range(curr_subpart_indices.x)) {
-          break;
-        }
+    IVec3 curr_subpart_indices = src_subpart_indices;
+    subpart_index_t curr_subpart_index = current_subpart_index;
+
+    int num_steps = remaining_steps.x + remaining_steps.y + remaining_steps.z;
+    for (int step = 0; step < num_steps; step++) {
+      // axes along which we already reached the destination are not considered
+      Vec3 times(
+          (remaining_steps.x > 0) ? coll_times.x : POS_GIGANTIC,
+          (remaining_steps.y > 0) ? coll_times.y : POS_GIGANTIC,
+          (remaining_steps.z > 0) ? coll_times.z : POS_GIGANTIC
+      );
+
+      // which of the times is the smallest? - i.e. which boundary we hit first
+      int axis;
+      if (times.x < times.y && times.x <= times.z) {
+        axis = 0;
       }
-      else if (coll_times.y <= coll_times.z) {
-        curr_pos += displacement * coll_times.y;
-        curr_subpart_indices.y += dir_urb_addend.y;
-        if (!p.is_subpart_index_in_range(curr_subpart_indices.y)) {
-          break;
-        }
+      else if (times.y <= times.z) {
+        axis = 1;
       }
-      else  {
-        curr_pos += displacement * coll_times.z;
-        curr_subpart_indices.z += dir_urb_addend.z;
-        if (!p.is_subpart_index_in_range(curr_subpart_indices.z)) {
-          break;
-        }
+      else {
+        axis = 2;
       }
 
+      pos_t coll_time = coll_times[axis];
+      coll_times[axis] += time_deltas[axis];
+      remaining_steps[axis]--;
+      curr_subpart_indices[axis] += dir_urb_addend[axis];
+      curr_subpart_index += subpart_index_addend[axis];
+      assert(curr_subpart_index == p.get_subpart_index_from_3d_indices(curr_subpart_indices));
 
-      curr_subpart_index = p.get_subpart_index_from_3d_indices(curr_subpart_indices);
       if (collect_for_walls) {
         crossed_subparts_for_walls.push_back(curr_subpart_index);
       }
@@ -277,15 +226,15 @@ static inline subpart_index_t __attribute__((always_inline)) collect_crossed_sub
         crossed_subparts_for_molecules.insert(curr_subpart_index);
       }
 
-      // also neighbors
+      // also neighbors, position on the edge of the subpartition
       if (collect_for_molecules && p.config.use_expanded_list) {
+        Vec3 curr_pos = vm.v.pos + displacement * Vec3(coll_time);
         collect_neighboring_subparts(
             p, curr_pos, curr_subpart_indices, rxn_radius_for_neighbors, sp_edge_length,
             crossed_subparts_for_molecules
         );
       }
-
-    } while (curr_subpart_index != dest_subpart_index);
+    }
   }
 
   // finally check also neighbors in destination
@@ -11,6 +11,7 @@
 ******************************************************************************/
 
 #include "count_buffer.h"
+#include "count_buffer_writer.h"
 
 #include <iomanip>
 #include <sstream>
@@ -62,35 +63,59 @@ static void write_gdat_value(std::ostream& outs, double d) {
 
 
 void CountBuffer::flush() {
-  if (!fout.is_open()) {
-    open(true);
+  if (background_writer != nullptr) {
+    bool all_empty = true;
+    for (const auto& column: data) {
+      all_empty = all_empty && column.empty();
+    }
+    if (all_empty) {
+      return;
+    }
+
+    // fout is used only by the writer thread
+    background_writer->submit(this, data);
+    return;
+  }
+
+  if (!write_columns(data)) {
+    mcell_error("Terminating due to error.");
+  }
+  for (auto& column: data) {
+    column.clear();
+  }
+}
+
+
+bool CountBuffer::write_columns(const std::vector<CountItemVector>& columns) {
+  if (!fout.is_open() && !open(false)) {
+    return false;
   }
 
   if (output_format == CountOutputFormat::DAT) {
     // there is a single column
-    assert(data.size() == 1);
-    for (const auto& item: data[0]) {
+    assert(columns.size() == 1);
+    for (const auto& item: columns[0]) {
       assert(item.column_index == 0);
       item.write_as_dat(fout);
     }
   }
   else {
-    assert(data.size() >= 1);
+    assert(columns.size() >= 1);
 
     // output row
     // expecting that each column has the same depth
-    size_t num_rows = data[0].size();
+    size_t num_rows = columns[0].size();
     for (size_t row = 0; row < num_rows; row++) {
 
       // simply use time from the first column
-      double time = data[0][row].time;
+      double time = columns[0][row].time;
       fout << " ";
       write_gdat_value(fout, time);
 
       // output each column
-      for (size_t col = 0; col < data.size(); col++) {
-        assert(row < data[col].size());
-        const auto& item = data[col][row];
+      for (size_t col = 0; col < columns.size(); col++) {
+        assert(row < columns[col].size());
+        const auto& item = columns[col][row];
         release_assert(cmp_eq(item.time, time, SQRT_EPS) && "Mismatch in gdat column times");
         fout << "  ";
         write_gdat_value(fout, item.value);
@@ -100,9 +125,7 @@ void CountBuffer::flush() {
   }
 
   fout.flush(); // flush the data so the user can see them
-  for (auto& column: data) {
-    column.clear();
-  }
+  return true;
 }
 
 
@@ -162,6 +185,10 @@ bool CountBuffer::open(bool error_is_fatal) {
 void CountBuffer::flush_and_close() {
 
   flush();
+  if (background_writer != nullptr) {
+    // the stream may be used from this thread again
+    background_writer->wait_until_all_written();
+  }
 
   if (fout.is_open()) {
     fout.close();
@@ -21,6 +21,8 @@ namespace MCell {
 
 using API::CountOutputFormat;
 
+class CountBufferWriter;
+
 class CountItem {
 public:
   CountItem()
@@ -60,7 +62,8 @@ public:
       filename(filename_),
       column_names(column_names_),
       buffer_size(buffer_size_),
-      open_for_append(open_for_append_) {
+      open_for_append(open_for_append_),
+      background_writer(nullptr) {
     assert(output_format != CountOutputFormat::UNSET);
     assert(!column_names.empty());
     // there is a single column
@@ -91,12 +94,23 @@ public:
     return column_names[column_index];
   }
 
-  // open file, return false if file could not be opened and error_is_fatal is false
+  // open file, return false if file could not be opened and error_is_fatal is false,
+  // must be called with error_is_fatal false from the writer thread
   bool open(bool error_is_fatal = true);
 
-  // flush buffer, open output file if needed, keep file open afterwards
+  // flush buffer, open output file if needed, keep file open afterwards,
+  // with a background writer, the data are only handed over to the writer thread
   void flush();
 
+  // columns are written by writer from now on, must be set before anything was flushed
+  void set_background_writer(CountBufferWriter* writer) {
+    background_writer = writer;
+  }
+
+  // called from flush or by CountBufferWriter in its thread,
+  // returns false if the output file could not be opened
+  bool write_columns(const std::vector<CountItemVector>& columns);
+
 private:
   void write_gdat_header();
 
@@ -120,6 +134,9 @@ private:
   std::vector<CountItemVector> data;
 
   bool open_for_append;
+
+  // owned by World, nullptr when count output is written synchronously
+  CountBufferWriter* background_writer;
 };
 
 typedef std::vector<CountBuffer> CountBufferVector;
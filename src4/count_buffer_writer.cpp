@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include "count_buffer_writer.h"
+
+#include "logging.h"
+
+using namespace std;
+
+namespace MCell {
+
+CountBufferWriter::CountBufferWriter(const size_t max_pending_bytes_)
+  : max_pending_bytes(max_pending_bytes_),
+    pending_bytes(0),
+    terminate(false) {
+
+  writer = thread(&CountBufferWriter::writer_loop, this);
+}
+
+
+CountBufferWriter::~CountBufferWriter() {
+  // errors were already reported by CountBuffer::open,
+  // the simulation ends anyway
+  wait_for_pending_columns();
+
+  {
+    lock_guard<mutex> lock(mtx);
+    terminate = true;
+  }
+  columns_submitted.notify_one();
+
+  writer.join();
+}
+
+
+void CountBufferWriter::submit(CountBuffer* buffer, std::vector<CountItemVector>& columns) {
+  assert(buffer != nullptr);
+
+  size_t num_columns = columns.size();
+  size_t num_bytes = 0;
+  for (const CountItemVector& column: columns) {
+    num_bytes += column.size() * sizeof(CountItem);
+  }
+
+  std::vector<CountItemVector> empty_columns;
+  {
+    unique_lock<mutex> lock(mtx);
+    columns_written.wait(lock,
+        [this, num_bytes] { return pending_bytes == 0 || pending_bytes + num_bytes <= max_pending_bytes; });
+
+    if (!free_columns.empty()) {
+      empty_columns.swap(free_columns.back());
+      free_columns.pop_back();
+    }
+
+    pending.push_back(PendingColumns{buffer, std::move(columns), num_bytes});
+    pending_bytes += num_bytes;
+  }
+  columns_submitted.notify_one();
+
+  // free columns may come from a buffer with a different number of columns
+  columns.swap(empty_columns);
+  columns.resize(num_columns);
+
+  terminate_if_write_failed();
+}
+
+
+void CountBufferWriter::wait_until_all_written() {
+  wait_for_pending_columns();
+  terminate_if_write_failed();
+}
+
+
+void CountBufferWriter::wait_for_pending_columns() {
+  unique_lock<mutex> lock(mtx);
+  columns_written.wait(lock, [this] { return pending.empty(); });
+}
+
+
+void CountBufferWriter::terminate_if_write_failed() {
+  string file_name;
+  {
+    lock_guard<mutex> lock(mtx);
+    file_name = failed_file_name;
+  }
+  if (file_name != "") {
+    mcell_error("Could not write count output file %s, terminating.", file_name.c_str());
+  }
+}
+
+
+void CountBufferWriter::writer_loop() {
+  while (true) {
+    PendingColumns* item;
+    {
+      unique_lock<mutex> lock(mtx);
+      columns_submitted.wait(lock, [this] { return terminate || !pending.empty(); });
+      if (pending.empty()) {
+        // terminate is set and there is nothing more to write
+        return;
+      }
+      // deque does not invalidate references to the first element on push_back
+      item = &pending.front();
+    }
+
+    bool ok = item->buffer->write_columns(item->columns);
+
+    for (CountItemVector& column: item->columns) {
+      column.clear();
+    }
+
+    {
+      lock_guard<mutex> lock(mtx);
+      if (!ok && failed_file_name == "") {
+        failed_file_name = item->buffer->get_filename();
+      }
+      pending_bytes -= item->num_bytes;
+      free_columns.push_back(std::move(item->columns));
+      pending.pop_front();
+    }
+    columns_written.notify_all();
+  }
+}
+
+} // namespace MCell
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_COUNT_BUFFER_WRITER_H_
+#define SRC4_COUNT_BUFFER_WRITER_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <string>
+
+#include "count_buffer.h"
+
+namespace MCell {
+
+/*
+ * I/O thread that formats and writes columns of CountBuffers.
+ *
+ * Once a CountBuffer uses this writer, its output stream is accessed only
+ * from the writer thread. Columns are written in the order in which they were submitted.
+ */
+class CountBufferWriter {
+public:
+  // submit blocks when data of more than max_pending_bytes_ wait to be written,
+  // a single submission larger than this limit is accepted when nothing is pending
+  CountBufferWriter(const size_t max_pending_bytes_);
+
+  // writes all pending columns
+  ~CountBufferWriter();
+
+  // takes the contents of columns and replaces them with the same number of empty columns,
+  // memory of the empty columns is reused from columns that were already written,
+  // terminates the simulation if a previous write failed
+  void submit(CountBuffer* buffer, std::vector<CountItemVector>& columns);
+
+  // blocks until all submitted columns were written,
+  // terminates the simulation if a write failed
+  void wait_until_all_written();
+
+private:
+  struct PendingColumns {
+    CountBuffer* buffer;
+    std::vector<CountItemVector> columns;
+    size_t num_bytes;
+  };
+
+  void writer_loop();
+
+  // waits without checking for errors
+  void wait_for_pending_columns();
+
+  // must be called from the simulation thread, mcell_error must not be called
+  // from the writer thread while the simulation is running
+  void terminate_if_write_failed();
+
+  size_t max_pending_bytes;
+  std::thread writer;
+
+  std::mutex mtx;
+  std::condition_variable columns_submitted;
+  std::condition_variable columns_written;
+
+  // guarded by mtx
+  std::deque<PendingColumns> pending; // includes the item being written
+  size_t pending_bytes;
+  bool terminate;
+  // written columns that were cleared and keep their capacity
+  std::vector<std::vector<CountItemVector>> free_columns;
+  // name of the first file that could not be written, empty when there was no error
+  std::string failed_file_name;
+};
+
+} // namespace MCell
+
+#endif // SRC4_COUNT_BUFFER_WRITER_H_
@@ -0,0 +1,223 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include "counted_volume_voxels.h"
+#include "partition.h"
+
+#include "wall_utils.inl"
+
+using namespace std;
+
+namespace MCell {
+
+// subpart contains no counted walls, counted volume of its waypoint is used
+const uint BLOCK_INDEX_NO_COUNTED_WALLS = UINT_INVALID - 1;
+// subpart was invalidated and waypoints must be used
+const uint BLOCK_INDEX_INVALID = UINT_INVALID;
+
+const uint VOXELS_PER_BLOCK = powu(COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE, 3);
+
+// marks voxels that were not evaluated yet while building a block
+const counted_volume_index_t COUNTED_VOLUME_INDEX_NOT_EVALUATED = COUNTED_VOLUME_INDEX_INTERSECTS;
+
+
+static uint get_voxel_index(const IVec3& voxel_indices) {
+  const int n = COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE;
+  return voxel_indices.x + voxel_indices.y * n + voxel_indices.z * n * n;
+}
+
+
+void CountedVolumeVoxels::build(Partition& p) {
+  block_index_per_subpart.clear();
+  voxels.clear();
+  free_block_indices.clear();
+  invalidated_subparts.clear();
+
+  // all subparts use waypoints until their voxels are built
+  block_index_per_subpart.resize(p.config.num_subparts, BLOCK_INDEX_INVALID);
+  for (subpart_index_t subpart_index = 0; subpart_index < p.config.num_subparts; subpart_index++) {
+    build_subpart(p, subpart_index);
+  }
+}
+
+
+void CountedVolumeVoxels::invalidate_subparts_in_box(const Partition& p, const Vec3& llf, const Vec3& urb) {
+  assert(is_built());
+
+  // the box may be partially outside of this partition
+  const Vec3& p_llf = p.get_origin_corner();
+  const Vec3& p_urb = p.get_opposite_corner();
+  if (glm::any(glm::lessThan(urb, p_llf)) || glm::any(glm::greaterThanEqual(llf, p_urb))) {
+    return;
+  }
+
+  Vec3 leeway3(POS_SQRT_EPS);
+  Vec3 llf_inside = glm::max((glm_vec3_t)(llf - leeway3), (glm_vec3_t)p_llf);
+  Vec3 urb_inside = glm::min((glm_vec3_t)(urb + leeway3), (glm_vec3_t)(p_urb - Vec3(POS_SQRT_EPS)));
+
+  IVec3 min_subpart_indices, max_subpart_indices;
+  p.get_subpart_3d_indices(llf_inside, min_subpart_indices);
+  p.get_subpart_3d_indices(urb_inside, max_subpart_indices);
+
+  for (int z = min_subpart_indices.z; z <= max_subpart_indices.z; z++) {
+    for (int y = min_subpart_indices.y; y <= max_subpart_indices.y; y++) {
+      for (int x = min_subpart_indices.x; x <= max_subpart_indices.x; x++) {
+        subpart_index_t subpart_index = p.get_subpart_index_from_3d_indices(x, y, z);
+        release_block(subpart_index);
+        block_index_per_subpart[subpart_index] = BLOCK_INDEX_INVALID;
+        invalidated_subparts.insert(subpart_index);
+      }
+    }
+  }
+}
+
+
+void CountedVolumeVoxels::update(Partition& p) {
+  assert(is_built());
+  for (subpart_index_t subpart_index: invalidated_subparts) {
+    build_subpart(p, subpart_index);
+  }
+  invalidated_subparts.clear();
+}
+
+
+counted_volume_index_t CountedVolumeVoxels::get_counted_volume_index(
+    const Partition& p, const Vec3& pos, const subpart_index_t subpart_index) const {
+
+  assert(subpart_index < block_index_per_subpart.size());
+  uint block_index = block_index_per_subpart[subpart_index];
+
+  if (block_index == BLOCK_INDEX_INVALID) {
+    return COUNTED_VOLUME_INDEX_INVALID;
+  }
+
+  if (block_index == BLOCK_INDEX_NO_COUNTED_WALLS) {
+    IVec3 subpart_indices;
+    p.get_subpart_3d_indices_from_index(subpart_index, subpart_indices);
+    return p.get_waypoint(subpart_indices).counted_volume_index;
+  }
+
+  Vec3 subpart_llf;
+  p.get_subpart_llf_point(subpart_index, subpart_llf);
+  pos_t voxels_per_length = COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE * p.config.subpart_edge_length_rcp;
+  IVec3 voxel_indices((pos - subpart_llf) * Vec3(voxels_per_length));
+  voxel_indices = IVec3(glm::clamp(
+      (glm_ivec3_t)voxel_indices, glm_ivec3_t(0), glm_ivec3_t(COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE - 1)));
+
+  return voxels[block_index * VOXELS_PER_BLOCK + get_voxel_index(voxel_indices)];
+}
+
+
+void CountedVolumeVoxels::release_block(const subpart_index_t subpart_index) {
+  uint block_index = block_index_per_subpart[subpart_index];
+  if (block_index != BLOCK_INDEX_INVALID && block_index != BLOCK_INDEX_NO_COUNTED_WALLS) {
+    free_block_indices.push_back(block_index);
+  }
+}
+
+
+void CountedVolumeVoxels::build_subpart(Partition& p, const subpart_index_t subpart_index) {
+  // the counted volumes computed here must not use this subpart's voxels
+  release_block(subpart_index);
+  block_index_per_subpart[subpart_index] = BLOCK_INDEX_INVALID;
+
+  vector<wall_index_t> counted_wall_indices;
+  for (wall_index_t wall_index: p.get_subpart_wall_indices(subpart_index)) {
+    const Wall& w = p.get_wall(wall_index);
+    if (p.get_geometry_object(w.object_index).is_counted_volume_or_compartment()) {
+      counted_wall_indices.push_back(wall_index);
+    }
+  }
+
+  if (counted_wall_indices.empty()) {
+    block_index_per_subpart[subpart_index] = BLOCK_INDEX_NO_COUNTED_WALLS;
+    return;
+  }
+
+  // each voxel is either intersected by a counted wall or not evaluated yet
+  const int n = COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE;
+  vector<counted_volume_index_t> block(VOXELS_PER_BLOCK, COUNTED_VOLUME_INDEX_NOT_EVALUATED);
+
+  Vec3 subpart_llf;
+  p.get_subpart_llf_point(subpart_index, subpart_llf);
+  Vec3 voxel_len(p.config.subpart_edge_length / n);
+  Vec3 leeway3(POS_SQRT_EPS);
+
+  for (int z = 0; z < n; z++) {
+    for (int y = 0; y < n; y++) {
+      for (int x = 0; x < n; x++) {
+        Vec3 voxel_llf = subpart_llf + Vec3(IVec3(x, y, z)) * voxel_len;
+        Vec3 voxel_urb = voxel_llf + voxel_len;
+        for (wall_index_t wall_index: counted_wall_indices) {
+          if (WallUtils::wall_in_box(p, p.get_wall(wall_index), voxel_llf - leeway3, voxel_urb + leeway3) != 0) {
+            block[get_voxel_index(IVec3(x, y, z))] = COUNTED_VOLUME_INDEX_INVALID;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // counted volume can change only when crossing a counted wall, so all voxels connected
+  // through faces of voxels that no counted wall intersects have the same counted volume,
+  // it is enough to compute it once for each such component
+  vector<IVec3> stack;
+  for (int z = 0; z < n; z++) {
+    for (int y = 0; y < n; y++) {
+      for (int x = 0; x < n; x++) {
+        IVec3 start(x, y, z);
+        if (block[get_voxel_index(start)] != COUNTED_VOLUME_INDEX_NOT_EVALUATED) {
+          continue;
+        }
+
+        Vec3 voxel_center = subpart_llf + (Vec3(start) + Vec3(0.5)) * voxel_len;
+        counted_volume_index_t counted_volume_index = p.compute_counted_volume_using_waypoints(voxel_center);
+        assert(counted_volume_index != COUNTED_VOLUME_INDEX_NOT_EVALUATED);
+
+        block[get_voxel_index(start)] = counted_volume_index;
+        stack.push_back(start);
+        while (!stack.empty()) {
+          IVec3 current = stack.back();
+          stack.pop_back();
+
+          for (int axis = 0; axis < 3; axis++) {
+            for (int dir = -1; dir <= 1; dir += 2) {
+              IVec3 neighbor = current;
+              neighbor[axis] += dir;
+              if (neighbor[axis] < 0 || neighbor[axis] >= n) {
+                continue;
+              }
+              uint neighbor_index = get_voxel_index(neighbor);
+              if (block[neighbor_index] == COUNTED_VOLUME_INDEX_NOT_EVALUATED) {
+                block[neighbor_index] = counted_volume_index;
+                stack.push_back(neighbor);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  uint block_index;
+  if (!free_block_indices.empty()) {
+    block_index = free_block_indices.back();
+    free_block_indices.pop_back();
+  }
+  else {
+    block_index = voxels.size() / VOXELS_PER_BLOCK;
+    voxels.resize(voxels.size() + VOXELS_PER_BLOCK);
+  }
+  copy(block.begin(), block.end(), voxels.begin() + block_index * VOXELS_PER_BLOCK);
+  block_index_per_subpart[subpart_index] = block_index;
+}
+
+} // namespace MCell
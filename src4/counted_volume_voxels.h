@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_COUNTED_VOLUME_VOXELS_H_
+#define SRC4_COUNTED_VOLUME_VOXELS_H_
+
+#include <vector>
+
+#include "defines.h"
+
+namespace MCell {
+
+class Partition;
+
+/*
+ * Precomputed counted volume indices for voxels of subpartitions, used to avoid
+ * ray casting from waypoints in compute_counted_volume_using_waypoints.
+ *
+ * Subpartitions that contain no walls of counted objects use the counted volume of their
+ * waypoint directly. Other subpartitions are split into voxels and each voxel that
+ * no counted wall intersects stores its counted volume index. The remaining voxels
+ * are evaluated using the waypoint of their subpartition as before.
+ *
+ * Requires waypoints with initialized counted volumes, i.e. config.has_intersecting_counted_objects.
+ */
+class CountedVolumeVoxels {
+public:
+  bool is_built() const {
+    return !block_index_per_subpart.empty();
+  }
+
+  // waypoints must be already initialized
+  void build(Partition& p);
+
+  // voxels of subparts that overlap the box cannot be used until update is called,
+  // called when walls move
+  void invalidate_subparts_in_box(const Partition& p, const Vec3& llf, const Vec3& urb);
+
+  // rebuilds voxels of subparts invalidated since the last update
+  void update(Partition& p);
+
+  // returns COUNTED_VOLUME_INDEX_INVALID when the counted volume for this position
+  // must be computed using waypoints
+  counted_volume_index_t get_counted_volume_index(
+      const Partition& p, const Vec3& pos, const subpart_index_t subpart_index) const;
+
+private:
+  void build_subpart(Partition& p, const subpart_index_t subpart_index);
+
+  void release_block(const subpart_index_t subpart_index);
+
+  // indexed by subpart_index_t, index of a block of voxels or one of the
+  // special values BLOCK_INDEX_NO_COUNTED_WALLS and BLOCK_INDEX_INVALID
+  std::vector<uint> block_index_per_subpart;
+
+  // blocks of COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE^3 voxels ordered by x, y and z,
+  // voxels intersected by a counted wall contain COUNTED_VOLUME_INDEX_INVALID
+  std::vector<counted_volume_index_t> voxels;
+
+  // blocks that were released when their subpart no longer contains counted walls
+  std::vector<uint> free_block_indices;
+
+  SubpartIndicesSet invalidated_subparts;
+};
+
+} // namespace MCell
+
+#endif // SRC4_COUNTED_VOLUME_VOXELS_H_
@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_COUNTER_BASED_RNG_H_
+#define SRC4_COUNTER_BASED_RNG_H_
+
+#include <cstring>
+
+#include "rng.h"
+
+#include "defines.h"
+
+namespace MCell {
+
+// identifies what the random numbers of a single molecule are used for,
+// each purpose has its own independent stream
+enum class RngStream {
+  VolDisplacement = 0,
+  SurfDisplacement = 1,
+  UnimolRxnTime = 2,
+  UnimolRxnPathway = 3
+};
+
+/*
+ * Philox4x32-10 counter-based generator (Salmon et al., Parallel random numbers: as easy as 1, 2, 3).
+ *
+ * Random numbers depend only on the seed, molecule id, time when the molecule
+ * started its diffusion, the stream and on how many numbers were drawn from this object,
+ * not on the order in which molecules are simulated. Used when SimulationConfig::use_counter_based_rng
+ * is set for displacements and unimolecular reactions so that these do not depend on the number
+ * of threads and partitions, other random numbers are drawn from World::rng.
+ */
+class CounterBasedRng {
+public:
+  CounterBasedRng(const uint seed, const molecule_id_t id, const double time, const RngStream stream)
+    : buffer_index(4) {
+
+    key[0] = seed;
+    key[1] = id;
+
+    uint64_t time_bits;
+    static_assert(sizeof(time_bits) == sizeof(time), "Unexpected size of double");
+    memcpy(&time_bits, &time, sizeof(time_bits));
+    counter[0] = (uint32_t)time_bits;
+    counter[1] = (uint32_t)(time_bits >> 32);
+    counter[2] = (uint32_t)stream;
+    counter[3] = 0; // block index
+  }
+
+  uint32_t next_uint() {
+    if (buffer_index == 4) {
+      generate_block();
+    }
+    return buffer[buffer_index++];
+  }
+
+  // same resolution as isaac64_dbl32
+  double next_dbl() {
+    return 2.3283064365386962890625e-10 * next_uint();
+  }
+
+private:
+  static inline void mulhilo(const uint32_t a, const uint32_t b, uint32_t& hi, uint32_t& lo) {
+    uint64_t product = (uint64_t)a * (uint64_t)b;
+    hi = (uint32_t)(product >> 32);
+    lo = (uint32_t)product;
+  }
+
+  void generate_block() {
+    const uint32_t M0 = 0xD2511F53;
+    const uint32_t M1 = 0xCD9E8D57;
+    const uint32_t W0 = 0x9E3779B9;
+    const uint32_t W1 = 0xBB67AE85;
+
+    uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+
+    for (uint round = 0; round < 10; round++) {
+      uint32_t hi0, lo0, hi1, lo1;
+      mulhilo(M0, c[0], hi0, lo0);
+      mulhilo(M1, c[2], hi1, lo1);
+
+      c[0] = hi1 ^ c[1] ^ k0;
+      c[1] = lo1;
+      c[2] = hi0 ^ c[3] ^ k1;
+      c[3] = lo0;
+
+      k0 += W0;
+      k1 += W1;
+    }
+
+    buffer[0] = c[0];
+    buffer[1] = c[1];
+    buffer[2] = c[2];
+    buffer[3] = c[3];
+    buffer_index = 0;
+
+    counter[3]++;
+  }
+
+  uint32_t key[2];
+  uint32_t counter[4];
+
+  uint32_t buffer[4];
+  uint buffer_index;
+};
+
+
+// overloads that allow code to be templated on the type of the random number generator
+static inline uint rng_next_uint(rng_state& rng) {
+  return rng_uint(&rng);
+}
+
+static inline uint rng_next_uint(CounterBasedRng& rng) {
+  return rng.next_uint();
+}
+
+static inline double rng_next_dbl(rng_state& rng) {
+  return rng_dbl(&rng);
+}
+
+static inline double rng_next_dbl(CounterBasedRng& rng) {
+  return rng.next_dbl();
+}
+
+static inline double rng_next_gauss(rng_state& rng) {
+  return rng_gauss(&rng);
+}
+
+// same ziggurat algorithm as rng_gauss in rng.c
+static inline double rng_next_gauss(CounterBasedRng& rng) {
+  double x, y;
+  double sign = 1.0;
+
+  do {
+    uint32_t bits = rng.next_uint();
+
+    sign = (bits & 0x80) ? -1.0 : 1.0;
+    uint32_t region = bits & 0x0000007f;
+    uint32_t pos_within_region = bits & 0xffffff00;
+
+    x = pos_within_region * WTAB[region];
+    if (pos_within_region < KTAB[region]) {
+      break;
+    }
+
+    if (region != 0) {
+      double yB = YTAB[region];
+      double yR = YTAB[region - 1] - yB;
+      y = yB + yR * rng.next_dbl();
+    }
+    else {
+      x = SCALE_FACTOR - log1p(-rng.next_dbl()) * RECIP_SCALE_FACTOR;
+      y = exp(-SCALE_FACTOR * (x - 0.5 * SCALE_FACTOR)) * rng.next_dbl();
+    }
+  } while (y >= exp(-0.5 * x * x));
+
+  return sign * x;
+}
+
+} // namespace MCell
+
+#endif // SRC4_COUNTER_BASED_RNG_H_
@@ -59,6 +59,12 @@ public:
     return return_from_run_n_iterations;
   }
 
+  // called functions must not create molecules, the model may be changed only
+  // after returning from run_n_iterations
+  bool ends_idle_time_skipping() const override {
+    return return_from_run_n_iterations;
+  }
+
   void dump(const std::string ind) const override {
     std::cout << ind << "Periodic Call Event:\n";
     std::string ind2 = ind + "  ";
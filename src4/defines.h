@@ -23,6 +23,7 @@
 #include <iostream>
 #include <map>
 #include <unordered_map>
+#include <algorithm>
 
 #include "mcell_structs_shared.h"
 #include "debug_config.h"
@@ -149,9 +150,29 @@ const double MESH_DISTINCTIVE_EPS = EPS;
 // ---------------------------------- configurable constants----------------------------------
 
 const uint SORT_MOLS_BY_SUBPART_PERIODICITY = 20;
+// molecules sorted in Morton order are sorted again only when a larger
+// fraction of consecutively diffused molecules is out of order
+const double SORT_MOLS_MAX_UNORDERED_FRACTION = 0.1;
 
 const uint DEFRAGMENTATION_PERIODICITY = 100;
 
+// adaptive subpartitions, a cell of the octree is split when it contains
+// more volume molecules or more wall-subpartition pairs than these limits
+const uint SUBPART_CELLS_REBALANCE_PERIODICITY = 100;
+const uint SUBPART_CELL_MAX_MOLECULES = 16;
+const uint SUBPART_CELL_MAX_WALLS = 8;
+
+// resolution of CountedVolumeVoxels
+const uint COUNTED_VOLUME_VOXELS_PER_SUBPART_EDGE = 4;
+
+// rxn classes with fewer pathways select them using cumulative probabilities
+// even when alias tables are enabled
+const uint RXN_PATHWAY_ALIAS_TABLE_MIN_PATHWAYS = 8;
+
+// limits memory used by SpeciesPairRxnClassCache, rxn classes for other species
+// are looked up in RxnContainer
+const uint SPECIES_PAIR_RXN_CLASS_CACHE_MAX_SPECIES = 512;
+
 const pos_t PARTITION_EDGE_LENGTH_DEFAULT_UM = 10; // large for now because we have just one partition
 const pos_t PARTITION_EDGE_EXTRA_MARGIN_UM = 0.01;
 const uint SUBPARTITIONS_PER_PARTITION_DIMENSION_DEFAULT = 1;
@@ -299,6 +320,8 @@ const counted_volume_index_t COUNTED_VOLUME_INDEX_INVALID = INDEX_INVALID;
 typedef std::pair<partition_id_t, wall_index_t> PartitionWallIndexPair;
 typedef std::pair<partition_id_t, region_index_t> PartitionRegionIndexPair;
 typedef std::pair<partition_id_t, vertex_index_t> PartitionVertexIndexPair;
+typedef std::pair<partition_id_t, molecule_id_t> PartitionMoleculeIdPair;
+typedef std::vector<PartitionMoleculeIdPair> PartitionMoleculeIdPairsVector;
 
 typedef std::pair<pos_t, PartitionWallIndexPair> CummAreaPWallIndexPair;
 
@@ -347,6 +370,85 @@ private:
   std::set<T> s;
 };
 
+// set of subpartition indices that keeps the insertion order,
+// when initialize_stamps was called, duplicates are found using a stamp per subpartition,
+// otherwise with a linear search that is suitable only for a few indices such as
+// the neighbors of a single subpartition
+class SubpartIndicesOrderedSet {
+public:
+  typedef SubpartIndicesVector::const_iterator const_iterator;
+
+  SubpartIndicesOrderedSet()
+    : current_stamp(1) {
+  }
+
+  void initialize_stamps(const uint num_subparts) {
+    v.clear();
+    stamps.assign(num_subparts, 0);
+    current_stamp = 1;
+  }
+
+  void insert(const subpart_index_t index) {
+    if (stamps.empty()) {
+      if (std::find(v.begin(), v.end(), index) == v.end()) {
+        v.push_back(index);
+      }
+    }
+    else {
+      assert(index < stamps.size());
+      if (stamps[index] != current_stamp) {
+        stamps[index] = current_stamp;
+        v.push_back(index);
+      }
+    }
+  }
+
+  size_t count(const subpart_index_t index) const {
+    if (stamps.empty()) {
+      return (std::find(v.begin(), v.end(), index) != v.end()) ? 1 : 0;
+    }
+    else {
+      assert(index < stamps.size());
+      return (stamps[index] == current_stamp) ? 1 : 0;
+    }
+  }
+
+  void clear() {
+    v.clear();
+    if (!stamps.empty()) {
+      current_stamp++;
+      if (current_stamp == 0) {
+        // wrapped around, stamps from the previous round must not match
+        std::fill(stamps.begin(), stamps.end(), 0);
+        current_stamp = 1;
+      }
+    }
+  }
+
+  bool empty() const {
+    return v.empty();
+  }
+
+  size_t size() const {
+    return v.size();
+  }
+
+  const_iterator begin() const {
+    return v.begin();
+  }
+
+  const_iterator end() const {
+    return v.end();
+  }
+
+private:
+  SubpartIndicesVector v;
+
+  // indexed by subpart_index_t, stamps[i] == current_stamp when subpart i is in the set
+  std::vector<uint> stamps;
+  uint current_stamp;
+};
+
 // ---------------------------------- vector types ----------------------------------
 
 #if POS_T_BYTES == 8
@@ -42,10 +42,13 @@ void DefragmentationEvent::step() {
     auto& schedulable_mol_ids = p.get_schedulable_molecule_ids();
     auto it_new_end = remove_if(schedulable_mol_ids.begin(), schedulable_mol_ids.end(),
         [&p](const molecule_id_t id) -> bool { return p.get_m(id).is_defunct(); });
-    schedulable_mol_ids.erase(it_new_end, schedulable_mol_ids.end());
+    if (it_new_end != schedulable_mol_ids.end()) {
+      schedulable_mol_ids.erase(it_new_end, schedulable_mol_ids.end());
+      p.reset_diffusion_calendar();
+    }
 
     // remove defunct molecules in the molecules array
-    vector<molecule_index_t>& molecule_id_to_index_mapping = p.get_molecule_id_to_index_mapping();
+    MoleculeIdToIndexMap& molecule_id_to_index_mapping = p.get_molecule_id_to_index_mapping();
 
 #ifdef DEBUG_DEFRAGMENTATION
     cout << "Defragmentation before sort:\n";
@@ -69,15 +72,14 @@ void DefragmentationEvent::step() {
       // then again, find following defunct molecule
       vmit_t it_second_defunct = find_if(it_next_funct, it_end, [](const Molecule & m) -> bool { return m.is_defunct(); });
 
-      // items between it_first_defunct and it_next_funct will be removed
-      // for debug mode, we will set their ids in volume_molecules_id_to_index_mapping as invalid
-#ifndef NDEBUG
+      // items between it_first_defunct and it_next_funct will be removed,
+      // their ids are removed from the mapping so that its unused pages can be released
       for (vmit_t it_update_mapping = it_first_defunct; it_update_mapping != it_next_funct; it_update_mapping++) {
         const Molecule& vm = *it_update_mapping;
         assert(vm.is_defunct());
-        molecule_id_to_index_mapping[vm.id] = MOLECULE_INDEX_INVALID;
+        molecule_id_to_index_mapping.erase(vm.id);
+        p.release_reactant_slots(vm.id);
       }
-#endif
 
       // move data: from, to, into position
       std::copy(it_next_funct, it_second_defunct, it_copy_destination);
@@ -108,7 +110,11 @@ void DefragmentationEvent::step() {
         break;
       }
       // correct index because the molecule could have been moved
-      molecule_id_to_index_mapping[vm.id] = i;
+      molecule_id_to_index_mapping.set(vm.id, i);
+    }
+
+    if (removed != 0) {
+      p.release_unused_id_mapping_memory();
     }
   }
 }
@@ -27,6 +27,8 @@
 #include "diffuse_react_event.h"
 #include "defines.h"
 #include "world.h"
+#include "thread_pool.h"
+#include "counter_based_rng.h"
 #include "partition.h"
 #include "geometry.h"
 #include "grid_position.h"
@@ -51,7 +53,6 @@ using namespace BNG;
 namespace MCell {
 
 void DiffuseReactEvent::step() {
-  assert(world->get_partitions().size() == 1 && "Must extend cache to handle multiple partitions");
   assert(cmp_eq(event_time, (double)world->stats.get_current_iteration()) &&
   	"DiffuseReactEvent is expected to be run exactly at iteration starts");
 
@@ -61,11 +62,47 @@ void DiffuseReactEvent::step() {
     p.get_molecules_ready_for_diffusion(molecules_ready_array);
     diffuse_molecules(p, molecules_ready_array);
   }
+
+  // finish molecules that moved to another partition and did not use up their time,
+  // processing may move them again
+  while (!diffuse_actions_in_other_partitions.empty()) {
+    std::vector<std::pair<partition_id_t, DiffuseAction>> actions;
+    actions.swap(diffuse_actions_in_other_partitions);
+
+    for (const auto& partition_and_action: actions) {
+      Partition& p = world->get_partition(partition_and_action.first);
+      // the molecule might have been already diffused when its new partition was processed
+      if (!p.does_molecule_exist(partition_and_action.second.id) ||
+          !needs_diffusion_in_this_iteration(p.get_m(partition_and_action.second.id))) {
+        continue;
+      }
+      assert(new_diffuse_actions.empty());
+      new_diffuse_actions.push_back(partition_and_action.second);
+      diffuse_molecules(p, MoleculeIdsVector());
+    }
+  }
+
+  // when no molecule can be ready in the next iterations, the scheduler may
+  // skip them up to an event that may create molecules
+  uint64_t next_check_iteration = ITERATION_NEVER;
+  for (const Partition& p: world->get_partitions()) {
+    next_check_iteration = min(next_check_iteration, p.get_next_diffusion_check_iteration());
+  }
+  uint64_t current_iteration = world->stats.get_current_iteration();
+  assert(next_check_iteration > current_iteration);
+  if (next_check_iteration - current_iteration > 1) {
+    idle_time_to_skip = min((double)(next_check_iteration - current_iteration), DIFFUSION_TIME_UPPER_LIMIT);
+  }
+  else {
+    idle_time_to_skip = 0;
+  }
 }
 
 
 void DiffuseReactEvent::diffuse_molecules(Partition& p, const MoleculeIdsVector& molecule_ids) {
 
+  partition_being_diffused = p.id;
+
   // we need to strictly follow the ordering in mcell3, therefore steps 2) and 3) do not use the time
   // for which they were scheduled but rather simply the order in which these "microevents" were created
 
@@ -73,10 +110,18 @@ void DiffuseReactEvent::diffuse_molecules(Partition& p, const MoleculeIdsVector&
 
 #ifndef MCELL3_4_ALWAYS_SORT_MOLS_BY_TIME_AND_ID
 
-  // 1) first diffuse already existing molecules
-  uint existing_mols_count = molecule_ids.size();
+  // 1) first diffuse already existing molecules,
+  // when enabled, molecules that cannot interact with anything are diffused in parallel first
+  const MoleculeIdsVector* existing_mol_ids = &molecule_ids;
+  MoleculeIdsVector serial_molecule_ids;
+  if (world->get_thread_pool() != nullptr && molecule_ids.size() >= PARALLEL_DIFFUSION_MIN_MOLECULES) {
+    diffuse_molecules_in_parallel(p, molecule_ids, serial_molecule_ids);
+    existing_mol_ids = &serial_molecule_ids;
+  }
+
+  uint existing_mols_count = existing_mol_ids->size();
   for (size_t i = 0; i < existing_mols_count; i++) {
-    molecule_id_t id = molecule_ids[i];
+    molecule_id_t id = (*existing_mol_ids)[i];
 
     // here we compute both release delay and also partially sort molecules to be diffused
     // so that molecules not scheduled for he beginning of the event are diffused later
@@ -122,6 +167,12 @@ void DiffuseReactEvent::diffuse_molecules(Partition& p, const MoleculeIdsVector&
   for (size_t i = 0; i < new_diffuse_actions.size(); i++) {
 
     DiffuseAction& action = new_diffuse_actions[i];
+    if (!p.does_molecule_exist(action.id)) {
+      // defunct, actions of molecules that moved to another partition are forwarded
+      // directly to that partition in diffuse_single_molecule
+      continue;
+    }
+
     diffuse_single_molecule(
         p, action.id,
         action.where_created_this_iteration // making a copy of this pair
@@ -158,6 +209,7 @@ void DiffuseReactEvent::diffuse_molecules(Partition& p, const MoleculeIdsVector&
 #endif
 
   new_diffuse_actions.clear();
+  partition_being_diffused = PARTITION_ID_INVALID;
 }
 
 
@@ -265,9 +317,12 @@ void DiffuseReactEvent::diffuse_single_molecule(
 
   // max_time is the time for which we should simulate the diffusion
   double max_time = get_max_time(p, m);
-  
+
+  // a volume molecule may move to another partition, surface molecules stay in
+  // the single partition that is allowed for models with surface molecules
+  Partition* p_after_diffusion = &p;
   if (m.is_vol()) {
-    diffuse_vol_molecule(
+    p_after_diffusion = &diffuse_vol_molecule(
         p, m,
         max_time,
         diffusion_start_time,
@@ -281,59 +336,315 @@ void DiffuseReactEvent::diffuse_single_molecule(
   }
 
   // update time for which the molecule should be scheduled next
-  Molecule& m_for_sched_update = p.get_m(m_id);
+  Molecule& m_for_sched_update = p_after_diffusion->get_m(m_id);
   if (!m_for_sched_update.is_defunct()) {
-    double event_end_time = p.stats.get_current_iteration() + 1;
-
-    const Species& species = world->get_all_species().get(m_for_sched_update.species_id);
-
-    // TODO: for some reason, MCell3 calls diffusion of non-diffusible surface molecules,
-    //       this is not needed since they cannot react but for compatibility we must keep this behavior
-    if (species.can_diffuse() || species.has_flag(SPECIES_FLAG_CAN_SURFSURF)) {
-      m_for_sched_update.diffusion_time += max_time;
-      // - for MCell3 compatibility purposes, we must not keep any unimol rxn for the next iteration
-      //   so we use precise comparison here
-      // - on the other hand, we do not want to simulate diffusion for a tiny amount of time,
-      //   so we use tolerance when checking whether we should keep diffusion itself for
-      //   the next time, the error accumulation can be quite big, therefore we are using SQRT_EPS
-      if (
-          ( m_for_sched_update.unimol_rxn_time != TIME_INVALID &&
-              m_for_sched_update.unimol_rxn_time < event_end_time
-          ) ||
-          before_this_iterations_end(m_for_sched_update.diffusion_time)
-      ) {
-        // reschedule molecule for this iteration because we did not use up all its time
-        DiffuseAction diffuse_action(m_for_sched_update.id);
-        new_diffuse_actions.push_back(diffuse_action);
-      }
-      else {
-        // round diffusion_time to a whole number if it is close to it,
-        // this did not give any error for the test that were available when this
-        // code was implemented
-        double rounded_dt = round_f(m_for_sched_update.diffusion_time);
-        if (cmp_eq(m_for_sched_update.diffusion_time, rounded_dt, SQRT_EPS)) {
-          m_for_sched_update.diffusion_time = rounded_dt;
-        }
+    if (update_diffusion_time(m_for_sched_update, max_time)) {
+      // reschedule molecule for this iteration
+      DiffuseAction diffuse_action(m_for_sched_update.id);
+      add_diffuse_action(p_after_diffusion->id, diffuse_action);
+    }
+  }
+}
+
+
+bool DiffuseReactEvent::update_diffusion_time(Molecule& m, const double max_time) {
+  double event_end_time = world->stats.get_current_iteration() + 1;
+
+  const Species& species = world->get_all_species().get(m.species_id);
+
+  // TODO: for some reason, MCell3 calls diffusion of non-diffusible surface molecules,
+  //       this is not needed since they cannot react but for compatibility we must keep this behavior
+  if (species.can_diffuse() || species.has_flag(SPECIES_FLAG_CAN_SURFSURF)) {
+    m.diffusion_time += max_time;
+    // - for MCell3 compatibility purposes, we must not keep any unimol rxn for the next iteration
+    //   so we use precise comparison here
+    // - on the other hand, we do not want to simulate diffusion for a tiny amount of time,
+    //   so we use tolerance when checking whether we should keep diffusion itself for
+    //   the next time, the error accumulation can be quite big, therefore we are using SQRT_EPS
+    if (
+        ( m.unimol_rxn_time != TIME_INVALID &&
+            m.unimol_rxn_time < event_end_time
+        ) ||
+        before_this_iterations_end(m.diffusion_time)
+    ) {
+      // we did not use up all its time
+      return true;
+    }
+    else {
+      // round diffusion_time to a whole number if it is close to it,
+      // this did not give any error for the test that were available when this
+      // code was implemented
+      double rounded_dt = round_f(m.diffusion_time);
+      if (cmp_eq(m.diffusion_time, rounded_dt, SQRT_EPS)) {
+        m.diffusion_time = rounded_dt;
       }
+      return false;
+    }
+  }
+  else {
+    // cannot diffuse
+    if (m.unimol_rxn_time != TIME_INVALID) {
+      // schedule for its unimol rxn
+      m.diffusion_time = m.unimol_rxn_time;
+
+      // reschedule molecule for unimol rxn this iteration
+      return m.unimol_rxn_time < event_end_time;
     }
     else {
-      // cannot diffuse
-      if (m_for_sched_update.unimol_rxn_time != TIME_INVALID) {
-        // schedule for its unimol rxn
-        m_for_sched_update.diffusion_time = m_for_sched_update.unimol_rxn_time;
-
-        // reschedule molecule for unimol rxn this iteration
-        if (m_for_sched_update.unimol_rxn_time < event_end_time) {
-          DiffuseAction diffuse_action(m_for_sched_update.id);
-          new_diffuse_actions.push_back(diffuse_action);
-        }
+      // no need to schedule at all
+      m.diffusion_time = TIME_FOREVER;
+      return false;
+    }
+  }
+}
+
+
+// ---------------------------------- parallel diffusion ----------------------------------
+
+bool DiffuseReactEvent::can_be_diffused_in_parallel(Partition& p, const Molecule& m) {
+  // molecules released during this iteration or those that have a pending unimol rxn
+  // or whose unimol rxn is not scheduled yet are diffused serially
+  if (!m.is_vol() || m.is_defunct() ||
+      !cmp_eq(m.diffusion_time, event_time) ||
+      (m.flags & (MOLECULE_FLAG_ACT_CLAMPED |
+                  MOLECULE_FLAG_SCHEDULE_UNIMOL_RXN |
+                  MOLECULE_FLAG_RESCHEDULE_UNIMOL_RXN_ON_NEXT_RXN_RATE_UPDATE)) != 0 ||
+      (m.unimol_rxn_time != TIME_INVALID && m.unimol_rxn_time <= m.diffusion_time)) {
+    return false;
+  }
+  return p.get_species(m.species_id).can_diffuse();
+}
+
+
+// - subpartitions are split into 27 colors according to their 3D indices modulo 3,
+//   subpartitions of the same color are at least 2 subpartitions apart so their neighborhoods
+//   (the subpartition and its 26 neighbors) do not overlap
+// - colors are processed one by one, in each color, molecules of a single subpartition are
+//   handled by a single thread in their original order, subpartitions are assigned to threads
+//   in a round-robin manner so the results depend only on the seed and number of threads
+// - a molecule is moved only when its whole diffusion step extended by the reaction radius stays in
+//   its neighborhood and there are no walls or molecules it could react with,
+//   the only shared data modified are the reactant maps of the subpartitions in the neighborhood
+void DiffuseReactEvent::diffuse_molecules_in_parallel(
+    Partition& p, const MoleculeIdsVector& molecule_ids, MoleculeIdsVector& serial_molecule_ids) {
+
+  ThreadPool* thread_pool = world->get_thread_pool();
+  assert(thread_pool != nullptr);
+  uint num_threads = thread_pool->get_num_threads();
+
+  if (parallel_diffusion_thread_data.size() != num_threads) {
+    parallel_diffusion_thread_data.resize(num_threads);
+    for (uint i = 0; i < num_threads; i++) {
+      rng_init(&parallel_diffusion_thread_data[i].rng, p.config.initial_seed + i + 1);
+    }
+  }
+
+  // sort molecules by color and subpartition, stable sort keeps their original order
+  // within each subpartition
+  std::vector<std::pair<uint64_t, uint>> color_subpart_and_index;
+  color_subpart_and_index.reserve(molecule_ids.size());
+  std::vector<uint> serial_molecule_indices;
+  uint_set<species_id_t> prepared_species;
+  for (uint i = 0; i < molecule_ids.size(); i++) {
+    const Molecule& m = p.get_m(molecule_ids[i]);
+    if (!can_be_diffused_in_parallel(p, m)) {
+      serial_molecule_indices.push_back(i);
+      continue;
+    }
+
+    if (prepared_species.count(m.species_id) == 0) {
+      p.prepare_reactants_map_for_concurrent_updates(m.species_id);
+      prepared_species.insert(m.species_id);
+    }
+
+    IVec3 indices;
+    p.get_subpart_3d_indices_from_index(m.v.subpart_index, indices);
+    uint64_t color = (indices.x % 3) + (indices.y % 3) * 3 + (indices.z % 3) * 9;
+    color_subpart_and_index.push_back(make_pair(color * p.config.num_subparts + m.v.subpart_index, i));
+  }
+  stable_sort(color_subpart_and_index.begin(), color_subpart_and_index.end(),
+      [](const std::pair<uint64_t, uint>& a, const std::pair<uint64_t, uint>& b) {
+        return a.first < b.first;
       }
-      else {
-        // no need to schedule at all
-        m_for_sched_update.diffusion_time = TIME_FOREVER;
+  );
+
+  // ranges of color_subpart_and_index that belong to a single subpartition, for each color
+  std::vector<std::pair<uint, uint>> subpart_ranges_per_color[27];
+  uint range_begin = 0;
+  for (uint i = 1; i <= color_subpart_and_index.size(); i++) {
+    if (i == color_subpart_and_index.size() ||
+        color_subpart_and_index[i].first != color_subpart_and_index[range_begin].first) {
+      uint color = color_subpart_and_index[range_begin].first / p.config.num_subparts;
+      subpart_ranges_per_color[color].push_back(make_pair(range_begin, i));
+      range_begin = i;
+    }
+  }
+
+  for (uint color = 0; color < 27; color++) {
+    const std::vector<std::pair<uint, uint>>& ranges = subpart_ranges_per_color[color];
+    if (ranges.empty()) {
+      continue;
+    }
+
+    thread_pool->run_on_all_threads(
+        [this, &p, &ranges, &color_subpart_and_index, &molecule_ids, num_threads](const uint thread_index) {
+          ParallelDiffusionThreadData& data = parallel_diffusion_thread_data[thread_index];
+          for (uint r = thread_index; r < ranges.size(); r += num_threads) {
+            for (uint i = ranges[r].first; i < ranges[r].second; i++) {
+              uint index = color_subpart_and_index[i].second;
+              if (!diffuse_vol_molecule_without_interactions(p, molecule_ids[index], data)) {
+                data.serial_molecule_indices.push_back(index);
+              }
+            }
+          }
+        }
+    );
+  }
+
+  // merge results of all threads
+  for (ParallelDiffusionThreadData& data: parallel_diffusion_thread_data) {
+    serial_molecule_indices.insert(
+        serial_molecule_indices.end(), data.serial_molecule_indices.begin(), data.serial_molecule_indices.end());
+    data.serial_molecule_indices.clear();
+
+    new_diffuse_actions.insert(
+        new_diffuse_actions.end(), data.new_diffuse_actions.begin(), data.new_diffuse_actions.end());
+    data.new_diffuse_actions.clear();
+
+    p.stats.add_parallel_diffusion_stats(data.diffuse_3d_calls, data.diffusion_number, data.diffusion_cummtime);
+    data.diffuse_3d_calls = 0;
+    data.diffusion_number = 0;
+    data.diffusion_cummtime = 0;
+  }
+
+  // remaining molecules are diffused serially in their original order
+  sort(serial_molecule_indices.begin(), serial_molecule_indices.end());
+  serial_molecule_ids.clear();
+  for (uint index: serial_molecule_indices) {
+    serial_molecule_ids.push_back(molecule_ids[index]);
+  }
+}
+
+
+// checks that subparts in the box given by llf_indices and urb_indices contain no walls
+// and no molecules that vm can react with, start_indices are indices of the subpart of vm
+static bool are_subparts_free_for_vol_molecule(
+    const Partition& p, const Molecule& vm, const BNG::Species& species,
+    const IVec3& start_indices, const IVec3& llf_indices, const IVec3& urb_indices) {
+
+  // no need to check walls of each subpart when the box is within the wall-free radius
+  int wall_free_radius = p.get_wall_free_radius(vm.v.subpart_index);
+  bool check_walls =
+      max3_i(IVec3(start_indices - llf_indices)) > wall_free_radius ||
+      max3_i(IVec3(urb_indices - start_indices)) > wall_free_radius;
+
+  bool can_vol_react = species.can_vol_react();
+  if (!check_walls && !can_vol_react) {
+    return true;
+  }
+
+  for (int z = llf_indices.z; z <= urb_indices.z; z++) {
+    for (int y = llf_indices.y; y <= urb_indices.y; y++) {
+      for (int x = llf_indices.x; x <= urb_indices.x; x++) {
+        subpart_index_t subpart_index = p.get_subpart_index_from_3d_indices(IVec3(x, y, z));
+
+        if (check_walls && !p.get_subpart_wall_indices(subpart_index).empty()) {
+          return false;
+        }
+
+        if (can_vol_react) {
+          const MoleculeIdsVector& sp_reactants = p.get_volume_molecule_reactants(subpart_index, vm.species_id);
+          for (molecule_id_t reactant_id: sp_reactants) {
+            if (reactant_id != vm.id) {
+              return false;
+            }
+          }
+        }
       }
     }
   }
+  return true;
+}
+
+
+bool DiffuseReactEvent::diffuse_vol_molecule_without_interactions(
+    Partition& p, const molecule_id_t vm_id, ParallelDiffusionThreadData& thread_data) {
+
+  Molecule& vm = p.get_m(vm_id);
+  const BNG::Species& species = p.get_species(vm.species_id);
+
+  // get_max_time may set the molecule as mature, keep the flags in case we need to revert it
+  uint orig_flags = vm.flags;
+  double max_time = get_max_time(p, vm);
+
+  Vec3 displacement;
+  double steps = 1.0;
+  double t_steps = 1.0;
+  double rate_factor = 1.0;
+  double r_rate_factor = 1.0;
+  if (p.config.use_counter_based_rng) {
+    // same random numbers as when diffused serially
+    CounterBasedRng rng(p.config.initial_seed, vm_id, vm.diffusion_time, RngStream::VolDisplacement);
+    DiffusionUtils::compute_vol_displacement_no_stats(
+        p, species, vm, max_time, rng,
+        displacement, rate_factor, r_rate_factor, steps, t_steps
+    );
+  }
+  else if (p.config.use_batched_gauss_rng) {
+    BufferedGaussRng rng(thread_data.rng, thread_data.gauss_buffer);
+    DiffusionUtils::compute_vol_displacement_no_stats(
+        p, species, vm, max_time, rng,
+        displacement, rate_factor, r_rate_factor, steps, t_steps
+    );
+  }
+  else {
+    DiffusionUtils::compute_vol_displacement_no_stats(
+        p, species, vm, max_time, thread_data.rng,
+        displacement, rate_factor, r_rate_factor, steps, t_steps
+    );
+  }
+
+  // bounding box of the whole move extended by reaction radius
+  Vec3 new_pos = vm.v.pos + displacement;
+  Vec3 radius(p.config.rxn_radius_3d * POS_RXN_RADIUS_MULTIPLIER);
+  Vec3 llf = Vec3(glm::min((glm_vec3_t)vm.v.pos, (glm_vec3_t)new_pos)) - radius;
+  Vec3 urb = Vec3(glm::max((glm_vec3_t)vm.v.pos, (glm_vec3_t)new_pos)) + radius;
+
+  bool no_interactions = p.in_this_partition(llf) && p.in_this_partition(urb);
+
+  IVec3 start_indices, llf_indices, urb_indices;
+  if (no_interactions) {
+    p.get_subpart_3d_indices_from_index(vm.v.subpart_index, start_indices);
+    p.get_subpart_3d_indices(llf, llf_indices);
+    p.get_subpart_3d_indices(urb, urb_indices);
+
+    no_interactions =
+        llf_indices.x >= start_indices.x - 1 && urb_indices.x <= start_indices.x + 1 &&
+        llf_indices.y >= start_indices.y - 1 && urb_indices.y <= start_indices.y + 1 &&
+        llf_indices.z >= start_indices.z - 1 && urb_indices.z <= start_indices.z + 1;
+  }
+
+  if (no_interactions) {
+    no_interactions = are_subparts_free_for_vol_molecule(p, vm, species, start_indices, llf_indices, urb_indices);
+  }
+
+  if (!no_interactions) {
+    vm.flags = orig_flags;
+    return false;
+  }
+
+  vm.v.pos = new_pos;
+  vm.v.subpart_index = p.get_subpart_index(new_pos);
+  p.update_molecule_reactants_map(vm);
+
+  thread_data.diffuse_3d_calls++;
+  thread_data.diffusion_number++;
+  thread_data.diffusion_cummtime += steps;
+
+  if (update_diffusion_time(vm, max_time)) {
+    thread_data.new_diffuse_actions.push_back(DiffuseAction(vm_id));
+  }
+  return true;
 }
 
 // ---------------------------------- volume diffusion ----------------------------------
@@ -364,21 +675,21 @@ void sort_collisions_by_time(CollisionsVector& molecule_collisions) {
 }
 
 
-void DiffuseReactEvent::diffuse_vol_molecule(
-    Partition& p,
+Partition& DiffuseReactEvent::diffuse_vol_molecule(
+    Partition& p_start,
     Molecule& vm,
     double& max_time,
     const double diffusion_start_time,
     WallTileIndexPair& wall_tile_pair_where_created_this_iteration
 ) {
   molecule_id_t vm_id = vm.id;
-  const BNG::Species& species = p.get_species(vm.species_id);
+  const BNG::Species& species = p_start.get_species(vm.species_id);
 
   if (!species.can_diffuse()) {
-    return;
+    return p_start;
   }
 
-  p.stats.inc_diffuse_3d_calls();
+  p_start.stats.inc_diffuse_3d_calls();
 
   // diffuse each molecule - get information on position change
   Vec3 remaining_displacement;
@@ -387,16 +698,32 @@ void DiffuseReactEvent::diffuse_vol_molecule(
   double t_steps = 1.0;
   double rate_factor = 1.0;
   double r_rate_factor = 1.0;
-  DiffusionUtils::compute_vol_displacement(
-      p, species, vm, max_time, world->rng,
-      remaining_displacement, rate_factor, r_rate_factor, steps, t_steps
-  );
+  if (p_start.config.use_counter_based_rng) {
+    CounterBasedRng rng(p_start.config.initial_seed, vm_id, diffusion_start_time, RngStream::VolDisplacement);
+    DiffusionUtils::compute_vol_displacement(
+        p_start, species, vm, max_time, rng,
+        remaining_displacement, rate_factor, r_rate_factor, steps, t_steps
+    );
+  }
+  else if (p_start.config.use_batched_gauss_rng) {
+    BufferedGaussRng rng(world->rng, world->gauss_buffer);
+    DiffusionUtils::compute_vol_displacement(
+        p_start, species, vm, max_time, rng,
+        remaining_displacement, rate_factor, r_rate_factor, steps, t_steps
+    );
+  }
+  else {
+    DiffusionUtils::compute_vol_displacement(
+        p_start, species, vm, max_time, world->rng,
+        remaining_displacement, rate_factor, r_rate_factor, steps, t_steps
+    );
+  }
 
 #ifdef DEBUG_TIMING
   DUMP_CONDITION4(
       vm_id,
       dump_vol_mol_timing(
-          "- Timing vm", p.stats.get_current_iteration(), vm_id,
+          "- Timing vm", p_start.stats.get_current_iteration(), vm_id,
           diffusion_start_time, max_time, vm.unimol_rxn_time,
           rate_factor, r_rate_factor, steps, t_steps
       );
@@ -413,6 +740,19 @@ void DiffuseReactEvent::diffuse_vol_molecule(
   );
 #endif
 
+  // molecule that stays in subparts without walls and reactants only changes its position,
+  // this gives the same result as ray_trace_vol that would find no collisions
+  if (move_vol_molecule_in_free_subparts(p_start, vm, species, remaining_displacement)) {
+#ifdef DEBUG_DIFFUSION
+    DUMP_CONDITION4(
+        vm_id,
+        vm.dump(p_start, "", "- Final vm position:", world->get_current_iteration(), 0);
+    );
+#endif
+    p_start.update_molecule_reactants_map(vm);
+    return p_start;
+  }
+
   RayTraceState state;
   CollisionsVector molecule_collisions;
   bool was_defunct = false;
@@ -420,7 +760,13 @@ void DiffuseReactEvent::diffuse_vol_molecule(
 
   double elapsed_molecule_time = diffusion_start_time; // == vm->t
   bool can_vol_react = species.can_vol_react();
+
+  // partition that contains the molecule, changes when the molecule crosses a partition boundary
+  Partition* current_p = &p_start;
   do {
+    Partition& p = *current_p;
+    Vec3 ray_trace_start_pos = p.get_m(vm_id).v.pos;
+
     state =
         ray_trace_vol(
             p, world->rng,
@@ -483,6 +829,7 @@ void DiffuseReactEvent::diffuse_vol_molecule(
           // prepare part of information
           shared_ptr<API::MolWallHitInfo> info = make_shared<API::MolWallHitInfo>();
           info->molecule_id = vm_new_ref.id;
+          info->partition_id = p.id;
           info->geometry_object_id = colliding_wall.object_id; // I would need Model to be accessible here
           info->partition_wall_index = colliding_wall.index; // here as well
           info->time = elapsed_molecule_time + t_steps * collision.time;
@@ -569,8 +916,14 @@ void DiffuseReactEvent::diffuse_vol_molecule(
 
     assert(p.get_m(vm_id).v.subpart_index == p.get_subpart_index(p.get_m(vm_id).v.pos));
 
+    if (state == RayTraceState::RAY_TRACE_HIT_PARTITION_BOUNDARY && !was_defunct) {
+      current_p = &move_vol_molecule_to_neighbor_partition(
+          p, vm_id, ray_trace_start_pos, remaining_displacement, t_steps, elapsed_molecule_time);
+    }
+
   } while (unlikely(state != RayTraceState::FINISHED && !was_defunct));
 
+  Partition& p = *current_p;
   if (!was_defunct) {
     // need to get a new reference
     Molecule& m_new_ref = p.get_m(vm_id);
@@ -588,33 +941,113 @@ void DiffuseReactEvent::diffuse_vol_molecule(
       );
 #endif
 
-      // are we still in the same partition or do we need to move?
-      bool move_to_another_partition = !p.in_this_partition(m_new_ref.v.pos);
-      if (move_to_another_partition) {
-        Vec3 pos_um = m_new_ref.v.pos * p.config.length_unit;
-        Vec3 origin_um = p.get_origin_corner() * p.config.length_unit;
-        Vec3 opposite_um = p.get_opposite_corner() * p.config.length_unit;
-        const BNG::Species& s = p.get_species(m_new_ref.species_id);
-        world->fatal_error(
-            "Molecule with species " + s.name + " (id: " + to_string(m_new_ref.id) + ") "
-            "escaped the simulation area defined by partition size.\n"
-            "Diffused molecule reached position (" +
-            to_string(pos_um.x) + ", " + to_string(pos_um.y) + ", " + to_string(pos_um.z) + "). "
-            "MCell4 requires a fixed-size simulation 3D space compared to MCell3 that allows unlimited space.\n"
-            "One can create a geometry object box that keeps all molecules within a given area.\n"
-            "This box can either reflect molecules (by default) or destroy the molecules with an absorptive surface class.\n"
-            "Another option is to increase the partition size through CellBlender settings Partitions or "
-            "through Model.config.partition_dimension.\n"
-            "Partition is a cube with these corner points: "
-            "(" + to_string(origin_um.x) + ", " + to_string(origin_um.y) + ", " + to_string(origin_um.z) + ") and " +
-            "(" + to_string(opposite_um.x) + ", " + to_string(opposite_um.z) + ", " + to_string(opposite_um.z) + ")."
-        );
-      }
-
       // change subpartition
       p.update_molecule_reactants_map(m_new_ref);
     }
   }
+
+  return p;
+}
+
+
+bool DiffuseReactEvent::move_vol_molecule_in_free_subparts(
+    Partition& p, Molecule& vm, const BNG::Species& species, const Vec3& displacement) {
+
+  int wall_free_radius = p.get_wall_free_radius(vm.v.subpart_index);
+  if (wall_free_radius < 0) {
+    return false;
+  }
+
+  // bounding box of the whole move extended by reaction radius,
+  // contains all subparts that ray_trace_vol would check
+  Vec3 new_pos = vm.v.pos + displacement;
+  Vec3 radius(p.config.rxn_radius_3d * POS_RXN_RADIUS_MULTIPLIER);
+  Vec3 llf = Vec3(glm::min((glm_vec3_t)vm.v.pos, (glm_vec3_t)new_pos)) - radius;
+  Vec3 urb = Vec3(glm::max((glm_vec3_t)vm.v.pos, (glm_vec3_t)new_pos)) + radius;
+  if (!p.in_this_partition(llf) || !p.in_this_partition(urb)) {
+    return false;
+  }
+
+  IVec3 start_indices, llf_indices, urb_indices;
+  p.get_subpart_3d_indices_from_index(vm.v.subpart_index, start_indices);
+  p.get_subpart_3d_indices(llf, llf_indices);
+  p.get_subpart_3d_indices(urb, urb_indices);
+
+  // long moves through empty space are limited by the wall-free radius,
+  // short moves next to walls are still checked subpart by subpart
+  int max_distance = max(wall_free_radius, 1);
+  if (max3_i(IVec3(start_indices - llf_indices)) > max_distance ||
+      max3_i(IVec3(urb_indices - start_indices)) > max_distance) {
+    return false;
+  }
+
+  if (!are_subparts_free_for_vol_molecule(p, vm, species, start_indices, llf_indices, urb_indices)) {
+    return false;
+  }
+
+  vm.v.pos = new_pos;
+  vm.v.subpart_index = p.get_subpart_index(new_pos);
+  return true;
+}
+
+
+Partition& DiffuseReactEvent::move_vol_molecule_to_neighbor_partition(
+    Partition& p,
+    const molecule_id_t vm_id,
+    const Vec3& ray_trace_start_pos,
+    Vec3& remaining_displacement,
+    double& t_steps,
+    double& elapsed_molecule_time
+) {
+  const Molecule& vm = p.get_m(vm_id);
+
+  // ray_trace_vol moved the molecule only up to the partition boundary
+  Vec3 displacement_left = ray_trace_start_pos + remaining_displacement - vm.v.pos;
+
+  partition_id_t neighbor_index = world->get_neighbor_partition_index(p, vm.v.pos, displacement_left);
+  if (neighbor_index == PARTITION_ID_INVALID) {
+    Vec3 pos_um = (vm.v.pos + displacement_left) * p.config.length_unit;
+    Vec3 origin_um = p.config.partition0_llf * p.config.length_unit;
+    Vec3 opposite_um =
+        (p.config.partition0_llf +
+            Vec3(p.config.partition_edge_length * p.config.num_partitions_per_world_edge)) * p.config.length_unit;
+    const BNG::Species& s = p.get_species(vm.species_id);
+    world->fatal_error(
+        "Molecule with species " + s.name + " (id: " + to_string(vm.id) + ") "
+        "escaped the simulation area defined by partition size.\n"
+        "Diffused molecule reached position (" +
+        to_string(pos_um.x) + ", " + to_string(pos_um.y) + ", " + to_string(pos_um.z) + "). "
+        "MCell4 requires a fixed-size simulation 3D space compared to MCell3 that allows unlimited space.\n"
+        "One can create a geometry object box that keeps all molecules within a given area.\n"
+        "This box can either reflect molecules (by default) or destroy the molecules with an absorptive surface class.\n"
+        "Another option is to increase the partition size through CellBlender settings Partitions or "
+        "through Model.config.partition_dimension.\n"
+        "Partition is a cube with these corner points: "
+        "(" + to_string(origin_um.x) + ", " + to_string(origin_um.y) + ", " + to_string(origin_um.z) + ") and " +
+        "(" + to_string(opposite_um.x) + ", " + to_string(opposite_um.y) + ", " + to_string(opposite_um.z) + ")."
+    );
+  }
+  Partition& neighbor = world->get_partition(neighbor_index);
+
+  // update time in the same way as when a molecule is reflected
+  pos_t remaining_len = len3(remaining_displacement);
+  double t_traveled = (remaining_len > 0) ? len3(vm.v.pos - ray_trace_start_pos) / remaining_len : 0;
+  elapsed_molecule_time += t_steps * t_traveled;
+  t_steps *= (1.0 - t_traveled);
+  remaining_displacement = displacement_left;
+
+  // the molecule is just before the boundary, place it just after it,
+  // the shift is negligible compared to the diffusion step
+  Vec3 dst_pos = glm::clamp(
+      (glm_vec3_t)vm.v.pos,
+      (glm_vec3_t)neighbor.get_origin_corner(),
+      (glm_vec3_t)(neighbor.get_opposite_corner() - Vec3(POS_SQRT_EPS))
+  );
+
+  world->migrate_volume_molecule(p, vm_id, neighbor, dst_pos);
+  p.stats.inc_mol_partition_crossings();
+
+  return neighbor;
 }
 
 
@@ -644,8 +1077,12 @@ RayTraceState ray_trace_vol(
   // if we would get out of this partition, cut off the displacement
   // so we check collisions just here
   Vec3 partition_displacement;
-  if (!p.in_this_partition(vm.v.pos + remaining_displacement)) {
+  bool leaving_partition = !p.in_this_partition(vm.v.pos + remaining_displacement);
+  stime_t partition_crossing_time = 1; // relative to remaining_displacement
+  if (leaving_partition) {
     partition_displacement = CollisionUtils::get_displacement_up_to_partition_boundary(p, vm.v.pos, remaining_displacement);
+    pos_t remaining_len = len3(remaining_displacement);
+    partition_crossing_time = (remaining_len > 0) ? len3(partition_displacement) / remaining_len : 0;
   }
   else {
     partition_displacement = remaining_displacement;
@@ -653,20 +1090,23 @@ RayTraceState ray_trace_vol(
 
   // first get what subpartitions might be relevant
   SubpartIndicesVector crossed_subparts_for_walls;
-  SubpartIndicesSet crossed_subparts_for_molecules;
-#ifdef NDEBUG
-  crossed_subparts_for_molecules.resize(16);
-#endif
-
-  subpart_index_t last_subpart_index = CollisionUtils::collect_crossed_subparts(
-      p, vm, partition_displacement,
-      radius, p.config.subpart_edge_length,
-      can_vol_react, true,
-      crossed_subparts_for_walls, crossed_subparts_for_molecules
-  );
+  SubpartIndicesOrderedSet& crossed_subparts_for_molecules = p.get_crossed_subparts_for_molecules();
+  crossed_subparts_for_molecules.clear();
+
+  // with BVH, subparts are needed only to find molecule collisions
+  bool use_wall_bvh = p.config.use_wall_bvh;
+  subpart_index_t last_subpart_index = SUBPART_INDEX_INVALID;
+  if (can_vol_react || !use_wall_bvh) {
+    last_subpart_index = CollisionUtils::collect_crossed_subparts(
+        p, vm, partition_displacement,
+        radius, p.config.subpart_edge_length,
+        can_vol_react, !use_wall_bvh,
+        crossed_subparts_for_walls, crossed_subparts_for_molecules
+    );
+  }
 
 #ifndef NDEBUG
-  if (can_vol_react) {
+  if (can_vol_react && !use_wall_bvh) {
     // crossed subparts must contain our own subpart
     assert(crossed_subparts_for_molecules.count(vm.v.subpart_index) == 1);
     bool debug_found = false;
@@ -688,9 +1128,27 @@ RayTraceState ray_trace_vol(
   // changed when wall was hit
   Vec3 displacement_up_to_wall_collision = remaining_displacement;
 
-  // check wall collisions in the crossed subparitions
   bool wall_hit_in_last_subpart = false;
-  if (!crossed_subparts_for_walls.empty()) {
+  if (use_wall_bvh) {
+    Collision closest_collision;
+    bool collision_found =
+        CollisionUtils::get_closest_wall_collision_using_bvh(
+            p,
+            vm,
+            last_hit_wall_index,
+            rng,
+            remaining_displacement,
+            displacement_up_to_wall_collision,
+            closest_collision
+        );
+    // wall_hit_in_last_subpart stays false so that subparts for molecules are collected again
+    if (collision_found) {
+      collisions.push_back(closest_collision);
+      res_state = RayTraceState::RAY_TRACE_HIT_WALL;
+    }
+  }
+  else if (!crossed_subparts_for_walls.empty()) {
+    // check wall collisions in the crossed subparitions
     Collision closest_collision;
 #if POS_T_BYTES == 4
     CollisionsVector tentative_collisions;
@@ -733,16 +1191,22 @@ RayTraceState ray_trace_vol(
 #endif    
   }
 
+  // a wall behind the partition boundary is hit later when the molecule
+  // continues in the neighboring partition
+  if (res_state == RayTraceState::RAY_TRACE_HIT_WALL && leaving_partition &&
+      collisions[0].time > partition_crossing_time) {
+    collisions.clear();
+    res_state = RayTraceState::FINISHED;
+    wall_hit_in_last_subpart = false;
+    displacement_up_to_wall_collision = remaining_displacement;
+  }
+
   if (can_vol_react) {
     if (res_state == RayTraceState::RAY_TRACE_HIT_WALL && !wall_hit_in_last_subpart) {
       // recompute collect_crossed_subparts if there was a wall collision
       // however, do not recompute if we would get practically the same result because we hit a wall in the last subpart
       // NOTE: this can be in theory done more efficiently if we knew the order of subpartitions that we hit in the previous call
-#ifdef NDEBUG
-      crossed_subparts_for_molecules.clear_no_resize();
-#else
       crossed_subparts_for_molecules.clear();
-#endif
       crossed_subparts_for_walls.clear();
       CollisionUtils::collect_crossed_subparts(
           p, vm, displacement_up_to_wall_collision,
@@ -752,26 +1216,48 @@ RayTraceState ray_trace_vol(
       );
     }
 
+    // with adaptive subpartitions, multiple crossed subparts may share a cell and its reactants
+    bool check_visited_cells = p.get_subpart_cells().has_merged_subparts();
+    SubpartIndicesVector visited_cells;
+
     // check molecule collisions for each SP
     for (subpart_index_t subpart_index: crossed_subparts_for_molecules) {
-      // get cached reacting molecules for this SP
-      const MoleculeIdsSet& sp_reactants = p.get_volume_molecule_reactants(subpart_index, vm.species_id);
-
-      // for each molecule in this SP
-      for (molecule_id_t colliding_vm_id: sp_reactants) {
-        CollisionUtils::collide_mol_loop_body(
-            p,
-            vm,
-            colliding_vm_id,
-            remaining_displacement,// needs the full displacement to compute reaction time displacement_up_to_wall_collision,
-            radius,
-            collisions
-        );
+      if (check_visited_cells) {
+        uint cell_index = p.get_subpart_cells().get_cell_index(subpart_index);
+        if (std::find(visited_cells.begin(), visited_cells.end(), cell_index) != visited_cells.end()) {
+          continue;
+        }
+        visited_cells.push_back(cell_index);
       }
+
+      // get cached reacting molecules for this SP
+      const MoleculeIdsVector& sp_reactants = p.get_volume_molecule_reactants(subpart_index, vm.species_id);
+
+      // for each molecule in this SP, distance checks are done in batches
+      CollisionUtils::collide_mols_batched(
+          p,
+          vm,
+          sp_reactants,
+          remaining_displacement,// needs the full displacement to compute reaction time displacement_up_to_wall_collision,
+          radius,
+          collisions
+      );
     }
   }
 
-  if (res_state == RayTraceState::FINISHED) {
+  if (res_state == RayTraceState::FINISHED && leaving_partition) {
+    // collisions with molecules behind the boundary are checked in the neighboring partition
+    collisions.erase(
+        remove_if(collisions.begin(), collisions.end(),
+            [partition_crossing_time](const Collision& c) { return c.time > partition_crossing_time; }),
+        collisions.end()
+    );
+
+    vm.v.pos = vm.v.pos + partition_displacement;
+    vm.v.subpart_index = p.get_subpart_index(vm.v.pos);
+    res_state = RayTraceState::RAY_TRACE_HIT_PARTITION_BOUNDARY;
+  }
+  else if (res_state == RayTraceState::FINISHED) {
     vm.v.pos = vm.v.pos + remaining_displacement;
     vm.v.subpart_index = p.get_subpart_index(vm.v.pos);
   }
@@ -886,7 +1372,7 @@ int DiffuseReactEvent::collide_and_react_with_surf_mol(
 
   RxnClassesVector matching_rxn_classes;
   RxnUtils::trigger_bimolecular(
-    p.bng_engine,
+    p,
     diffused_molecule, colliding_molecule,
     collision_orientation, colliding_molecule.s.orientation,
     matching_rxn_classes
@@ -1034,10 +1520,10 @@ inline WallRxnResult DiffuseReactEvent::collide_and_react_with_walls(
 
   if (matching_rxn_classes.size() == 1) {
     rxn_class_index = 0;
-    pathway_index = RxnUtils::test_intersect(matching_rxn_classes[0], r_rate_factor, current_time, world->rng);
+    pathway_index = RxnUtils::test_intersect(p, matching_rxn_classes[0], r_rate_factor, current_time, world->rng);
   } else {
     pathway_index = RxnUtils::test_many_intersect(
-        matching_rxn_classes, r_rate_factor, current_time, rxn_class_index, world->rng);
+        p, matching_rxn_classes, r_rate_factor, current_time, rxn_class_index, world->rng);
   }
 
   if (rxn_class_index != BNG::RNX_CLASS_INDEX_INVALID && pathway_index >= BNG::PATHWAY_INDEX_LEAST_VALID) {
@@ -1124,11 +1610,19 @@ inline void DiffuseReactEvent::diffuse_surf_molecule(
   );
 #endif
 
+    // used only when config.use_counter_based_rng is set, all retries draw from the same stream
+    CounterBasedRng counter_based_rng(p.config.initial_seed, sm_id, diffusion_start_time, RngStream::SurfDisplacement);
+
     for (int find_new_position = (SURFACE_DIFFUSION_RETRIES + 1);
          find_new_position > 0; find_new_position--) {
 
       Vec2 displacement;
-      DiffusionUtils::compute_surf_displacement(species, space_factor, world->rng, displacement);
+      if (p.config.use_counter_based_rng) {
+        DiffusionUtils::compute_surf_displacement(species, space_factor, counter_based_rng, displacement);
+      }
+      else {
+        DiffusionUtils::compute_surf_displacement(species, space_factor, world->rng, displacement);
+      }
 
 #ifdef DEBUG_DIFFUSION
       DUMP_CONDITION4(
@@ -1266,7 +1760,7 @@ bool DiffuseReactEvent::react_2D_all_neighbors(
   const Wall& wall = p.get_wall(sm.s.wall_index);
 
   TileNeighborVector neighbors;
-  GridUtils::find_neighbor_tiles(p, &sm, wall, sm.s.grid_tile_index, false, true, neighbors);
+  GridUtils::find_neighbor_tiles_for_reactant(p, sm, wall, neighbors);
 
   if (neighbors.empty()) {
     return true;
@@ -1323,7 +1817,7 @@ bool DiffuseReactEvent::react_2D_all_neighbors(
     // returns value >=1 if there can be a reaction
     size_t orig_num_rxsn = matching_rxn_classes.size();
     RxnUtils::trigger_bimolecular_orientation_from_mols(
-        p.bng_engine,
+        p,
         sm, nsm,
         matching_rxn_classes
     );
@@ -1436,7 +1930,7 @@ bool DiffuseReactEvent::react_2D_intermembrane(
 
   // get neighboring subparts - this is necessary because
   // subpartitioning can put a boundary right between membranes
-  SubpartIndicesSet subpart_indices_set;
+  SubpartIndicesOrderedSet subpart_indices_set;
   CollisionUtils::collect_neighboring_subparts(
       p, reac1_pos3d, subpart_indices, p.config.intermembrane_rxn_radius_3d, p.config.subpart_edge_length,
       subpart_indices_set
@@ -1513,7 +2007,7 @@ bool DiffuseReactEvent::react_2D_intermembrane(
     // also the rxn rule's pattern expects UP
     RxnClassesVector matching_rxn_classes;
     RxnUtils::trigger_bimolecular(
-        p.bng_engine, sm, sm2, sm.s.orientation, sm2.s.orientation, matching_rxn_classes);
+        p, sm, sm2, sm.s.orientation, sm2.s.orientation, matching_rxn_classes);
 
     if (matching_rxn_classes.empty()) {
       assert(false && "We already filtered-out molecules that can react");
@@ -1742,13 +2236,14 @@ void DiffuseReactEvent::pick_unimol_rxn_class_and_set_rxn_time(
     return;
   }
 
-  uint idx = 0;
-  if (rxn_classes.size() > 1) {
-    idx = RxnUtils::test_many_unimol(rxn_classes, world->rng);
+  double time_from_now;
+  if (p.config.use_counter_based_rng) {
+    CounterBasedRng rng(p.config.initial_seed, m.id, current_time, RngStream::UnimolRxnTime);
+    time_from_now = RxnUtils::pick_unimol_rxn_class_and_lifetime(p, rng, rxn_classes, current_time, m);
+  }
+  else {
+    time_from_now = RxnUtils::pick_unimol_rxn_class_and_lifetime(p, world->rng, rxn_classes, current_time, m);
   }
-
-  // there is a check when computing the reaction rate to make sure that the time is reasonably higher than 0
-  double time_from_now = RxnUtils::compute_unimol_lifetime(p, world->rng, rxn_classes[idx], current_time, m);
 
   double scheduled_time = current_time + time_from_now;
 
@@ -1801,12 +2296,15 @@ bool DiffuseReactEvent::react_unimol_single_molecule(
       return true;
     }
 
-    uint idx = 0;
-    if (rxn_classes.size() > 1) {
-      idx = RxnUtils::test_many_unimol(rxn_classes, world->rng);
+    uint idx;
+    BNG::rxn_class_pathway_index_t pi;
+    if (p.config.use_counter_based_rng) {
+      CounterBasedRng rng(p.config.initial_seed, m.id, scheduled_time, RngStream::UnimolRxnPathway);
+      RxnUtils::pick_unimol_rxn_class_and_pathway(p, m, rng, rxn_classes, idx, pi);
+    }
+    else {
+      RxnUtils::pick_unimol_rxn_class_and_pathway(p, m, world->rng, rxn_classes, idx, pi);
     }
-
-    BNG::rxn_class_pathway_index_t pi = RxnUtils::which_unimolecular(m, rxn_classes[idx], world->rng);
 
     if (rxn_classes[idx]->is_unimol()) {
       // standard unimolecular rxn
@@ -2780,6 +3278,16 @@ int DiffuseReactEvent::outcome_products_random(
             p, *wall, product_orientation, vm_initialization);
       }
 
+      // a surface reactant may lie on a part of a wall that extends to a neighboring partition,
+      // the product is kept in this partition
+      if (!p.in_this_partition(vm_initialization.v.pos)) {
+        vm_initialization.v.pos = glm::clamp(
+            (glm_vec3_t)vm_initialization.v.pos,
+            (glm_vec3_t)p.get_origin_corner(),
+            (glm_vec3_t)(p.get_opposite_corner() - Vec3(POS_SQRT_EPS))
+        );
+      }
+
       // adding molecule might invalidate references of already existing molecules and also of species
       Molecule& new_vm = p.add_volume_molecule(vm_initialization);
 
@@ -3105,6 +3613,7 @@ void DiffuseReactEvent::dump(const std::string ind) const {
   std::string ind2 = ind + "  ";
   BaseEvent::dump(ind2);
   cout << ind2 << "barrier_time_from_event_time: \t\t" << time_up_to_next_barrier << " [double] (may be unset initally)\t\t\n";
+  cout << ind2 << "idle_time_to_skip: \t\t" << idle_time_to_skip << " [double]\t\t\n";
 }
 
 
@@ -20,6 +20,7 @@
 #include "base_event.h"
 #include "partition.h"
 #include "collision_structs.h"
+#include "gauss_buffer.h"
 
 
 namespace MCell {
@@ -36,10 +37,14 @@ const double DIFFUSE_REACT_EVENT_PERIODICITY = 1.0;
 // to find the next barrier
 const double DIFFUSION_TIME_UPPER_LIMIT = 100.0;
 
+// parallel diffusion is not worth the synchronization overhead for a small number of molecules
+const uint PARALLEL_DIFFUSION_MIN_MOLECULES = 1024;
+
 enum class RayTraceState {
   UNDEFINED,
   HIT_SUBPARTITION,
   RAY_TRACE_HIT_WALL,
+  RAY_TRACE_HIT_PARTITION_BOUNDARY, // molecule was moved up to the boundary, continues in a neighboring partition
   FINISHED
 };
 
@@ -99,6 +104,28 @@ public:
 };
 
 
+// data used by a single thread when molecules are diffused in parallel
+struct ParallelDiffusionThreadData {
+  ParallelDiffusionThreadData()
+    : diffuse_3d_calls(0), diffusion_number(0), diffusion_cummtime(0) {
+  }
+
+  rng_state rng;
+  GaussBuffer gauss_buffer; // used with rng when config.use_batched_gauss_rng is set
+
+  // molecules that were diffused but did not use up their time in this iteration
+  std::vector<DiffuseAction> new_diffuse_actions;
+
+  // indices of molecules that must be diffused serially
+  std::vector<uint> serial_molecule_indices;
+
+  // stats, merged into SimulationStats after each parallel diffusion
+  uint64_t diffuse_3d_calls;
+  uint64_t diffusion_number;
+  double diffusion_cummtime;
+};
+
+
 /**
  * Diffuse all molecules with a given time step.
  * When a molecule is diffused, it is checked for collisions and reactions
@@ -109,7 +136,8 @@ class DiffuseReactEvent : public BaseEvent {
 public:
   DiffuseReactEvent(World* world_) :
     BaseEvent(EVENT_TYPE_INDEX_DIFFUSE_REACT),
-    world(world_), time_up_to_next_barrier(FLT_INVALID) {
+    world(world_), time_up_to_next_barrier(FLT_INVALID), idle_time_to_skip(0),
+    partition_being_diffused(PARTITION_ID_INVALID) {
 
     // repeat this event each iteration
     periodicity_interval = DIFFUSE_REACT_EVENT_PERIODICITY;
@@ -124,12 +152,26 @@ public:
     if (time_up_to_next_barrier < periodicity_interval) {
       event_time = event_time + time_up_to_next_barrier;
     }
+    else if (idle_time_to_skip > periodicity_interval) {
+      // no molecule can be ready before the next barrier or the end of the idle time
+      event_time = event_time + std::min(idle_time_to_skip, time_up_to_next_barrier);
+    }
     else {
       event_time = event_time + periodicity_interval;
     }
     return true;
   }
 
+  double get_idle_time_to_skip() const override {
+    return idle_time_to_skip;
+  }
+
+  void set_idle_time_to_skip(const double idle_time_to_skip_) override {
+    assert(cmp_eq(idle_time_to_skip_, round_f(idle_time_to_skip_)) &&
+        "Idle time to skip is expected to be a whole number");
+    idle_time_to_skip = idle_time_to_skip_;
+  }
+
   bool may_be_blocked_by_barrier_and_needs_set_time_step() const override {
     // DiffuseReactEvent must execute only up to a barrier such as CountEvent
     return true;
@@ -149,8 +191,14 @@ public:
     time_up_to_next_barrier = time_up_to_next_barrier_;
   }
 
-  void add_diffuse_action(const DiffuseAction& action) {
-    new_diffuse_actions.push_back(action);
+  // partition_id is the partition that contains the molecule
+  void add_diffuse_action(const partition_id_t partition_id, const DiffuseAction& action) {
+    if (partition_id == partition_being_diffused) {
+      new_diffuse_actions.push_back(action);
+    }
+    else {
+      diffuse_actions_in_other_partitions.push_back(std::make_pair(partition_id, action));
+    }
   }
 
   bool before_this_iterations_end(const double time) const {
@@ -186,6 +234,10 @@ public:
   double time_up_to_next_barrier;
 
 private:
+  // number of time steps until the first iteration in which a molecule may be ready,
+  // set in step and then limited by the scheduler, 0 if no time is skipped
+  double idle_time_to_skip;
+
   // auxiliary array used to store result from Partition::get_molecules_ready_for_diffusion
   // using the same array every iteration in order not to reallocate it every iteration
   MoleculeIdsVector molecules_ready_array;
@@ -193,10 +245,45 @@ private:
   // internal event's schedule of molecules newly created in reactions that must be diffused
   std::vector<DiffuseAction> new_diffuse_actions;
 
+  // partition whose molecules are being diffused in diffuse_molecules,
+  // new_diffuse_actions belong to this partition
+  partition_id_t partition_being_diffused;
+
+  // one item per thread, used only when config.num_threads > 1
+  std::vector<ParallelDiffusionThreadData> parallel_diffusion_thread_data;
+
+  // actions for molecules that moved to a different partition than the one being processed,
+  // they are handled after all partitions were processed
+  std::vector<std::pair<partition_id_t, DiffuseAction>> diffuse_actions_in_other_partitions;
+
+  bool needs_diffusion_in_this_iteration(const Molecule& m) const {
+    return !m.is_defunct() &&
+        (before_this_iterations_end(m.diffusion_time) ||
+         (m.unimol_rxn_time != TIME_INVALID && m.unimol_rxn_time < event_time + periodicity_interval));
+  }
+
   double get_max_time(Partition& p, Molecule& m);
 
+  // sets the next diffusion time after the molecule was diffused for max_time,
+  // returns true if the molecule must be diffused again in this iteration
+  bool update_diffusion_time(Molecule& m, const double max_time);
+
   void diffuse_molecules(Partition& p, const MoleculeIdsVector& indices);
 
+  // ---------------------------------- parallel diffusion ----------------------------------
+  // diffuses volume molecules that cannot interact with anything during their diffusion step
+  // using multiple threads, ids of molecules that must be diffused serially are
+  // returned in serial_molecule_ids in their original order
+  void diffuse_molecules_in_parallel(
+      Partition& p, const MoleculeIdsVector& molecule_ids, MoleculeIdsVector& serial_molecule_ids);
+
+  bool can_be_diffused_in_parallel(Partition& p, const Molecule& m);
+
+  // called from worker threads, returns false and keeps the molecule unchanged when
+  // the molecule might interact with a wall or molecule or leave neighboring subpartitions
+  bool diffuse_vol_molecule_without_interactions(
+      Partition& p, const molecule_id_t vm_id, ParallelDiffusionThreadData& thread_data);
+
   void diffuse_single_molecule(
       Partition& p,
       const molecule_id_t vm_id,
@@ -204,7 +291,8 @@ private:
   );
 
   // ---------------------------------- volume molecules ----------------------------------
-  void diffuse_vol_molecule(
+  // returns partition that contains the molecule after diffusion
+  Partition& diffuse_vol_molecule(
       Partition& p,
       Molecule& vm,
       double& max_time,
@@ -212,6 +300,24 @@ private:
       WallTileIndexPair& where_created_this_iteration
   );
 
+  // moves the molecule by displacement and returns true when its whole move is within
+  // subparts that contain no walls and no molecules it can react with,
+  // returns false and keeps the molecule unchanged otherwise
+  bool move_vol_molecule_in_free_subparts(
+      Partition& p, Molecule& vm, const BNG::Species& species, const Vec3& displacement);
+
+  // called when ray_trace_vol stopped the molecule at the boundary of partition p,
+  // moves the molecule to the neighboring partition and updates remaining displacement and time,
+  // terminates simulation if there is no neighboring partition
+  Partition& move_vol_molecule_to_neighbor_partition(
+      Partition& p,
+      const molecule_id_t vm_id,
+      const Vec3& ray_trace_start_pos,
+      Vec3& remaining_displacement,
+      double& t_steps,
+      double& elapsed_molecule_time
+  );
+
   bool collide_and_react_with_vol_mol(
       Partition& p,
       const Collision& collision,
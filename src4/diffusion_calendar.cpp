@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include <algorithm>
+
+#include "diffusion_calendar.h"
+
+using namespace std;
+
+namespace MCell {
+
+void DiffusionCalendar::collect_positions_to_check(
+    const uint64_t iteration, const uint num_positions, std::vector<uint>& positions) {
+
+  positions.clear();
+
+  if (!initialized) {
+    positions_per_iteration.clear();
+    ready_positions.clear();
+    positions.resize(num_positions);
+    for (uint i = 0; i < num_positions; i++) {
+      positions[i] = i;
+    }
+    num_known_positions = num_positions;
+    initialized = true;
+    return;
+  }
+
+  assert(num_positions >= num_known_positions && "Calendar must be reset when molecules are removed");
+
+  positions.swap(ready_positions);
+
+  // iterations may be skipped, so all filed molecules up to this iteration are collected
+  auto it = positions_per_iteration.begin();
+  while (it != positions_per_iteration.end() && it->first <= iteration) {
+    positions.insert(positions.end(), it->second.begin(), it->second.end());
+    it = positions_per_iteration.erase(it);
+  }
+
+  for (uint i = num_known_positions; i < num_positions; i++) {
+    positions.push_back(i);
+  }
+  num_known_positions = num_positions;
+
+  // molecules must be diffused in the order of schedulable_molecule_ids
+  sort(positions.begin(), positions.end());
+}
+
+} // namespace MCell
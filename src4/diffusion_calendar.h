@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_DIFFUSION_CALENDAR_H_
+#define SRC4_DIFFUSION_CALENDAR_H_
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "defines.h"
+
+namespace MCell {
+
+// molecules that are not scheduled at all, e.g. with diffusion time TIME_FOREVER,
+// are filed under this iteration
+const uint64_t ITERATION_NEVER = UINT64_MAX;
+
+/*
+ * Tells which schedulable molecules of a partition must be checked whether they are ready
+ * for diffusion in a given iteration, used by Partition::get_molecules_ready_for_diffusion.
+ *
+ * Molecules are identified by their position in Partition::schedulable_molecule_ids.
+ * A molecule that is not ready is filed under the first iteration in which it can be ready
+ * and it is not checked until then. Molecules that were ready in the previous check and
+ * molecules added since the previous check are always checked because their diffusion time
+ * changes while they are being diffused.
+ *
+ * Must be reset when schedulable_molecule_ids is reordered or shrunk or when the diffusion time
+ * of a molecule changes while the molecule is not being diffused, all molecules are then
+ * checked again.
+ */
+class DiffusionCalendar {
+public:
+  DiffusionCalendar()
+    : initialized(false), num_known_positions(0) {
+  }
+
+  void reset() {
+    initialized = false;
+    positions_per_iteration.clear();
+    ready_positions.clear();
+    num_known_positions = 0;
+  }
+
+  // sets positions to a sorted array of positions that must be checked in this iteration,
+  // each of them must be then passed either to file_ready or to file_not_ready
+  void collect_positions_to_check(
+      const uint64_t iteration, const uint num_positions, std::vector<uint>& positions);
+
+  // molecule is ready in the current iteration
+  void file_ready(const uint position) {
+    assert(ready_positions.empty() || ready_positions.back() < position);
+    ready_positions.push_back(position);
+  }
+
+  // molecule cannot be ready before next_check_iteration
+  void file_not_ready(const uint position, const uint64_t next_check_iteration) {
+    positions_per_iteration[next_check_iteration].push_back(position);
+  }
+
+  // returns the first iteration after the given iteration in which a molecule may be ready,
+  // ITERATION_NEVER if there is no such molecule,
+  // num_positions is the current number of schedulable molecules
+  uint64_t get_next_iteration_to_check(const uint64_t iteration, const uint num_positions) const {
+    if (!initialized || !ready_positions.empty() || num_positions != num_known_positions) {
+      return iteration + 1;
+    }
+    if (positions_per_iteration.empty()) {
+      return ITERATION_NEVER;
+    }
+    return std::max(positions_per_iteration.begin()->first, iteration + 1);
+  }
+
+private:
+  // when false, all positions are checked
+  bool initialized;
+
+  // filed molecules, key is the iteration when they must be checked again
+  std::map<uint64_t, std::vector<uint>> positions_per_iteration;
+
+  // molecules that were ready in the last check, sorted
+  std::vector<uint> ready_positions;
+
+  // number of schedulable molecules during the last check,
+  // positions starting from this value belong to molecules that were added since then
+  uint num_known_positions;
+};
+
+} // namespace MCell
+
+#endif // SRC4_DIFFUSION_CALENDAR_H_
@@ -28,6 +28,8 @@
 #include "geometry.h"
 #include "simulation_config.h"
 #include "debug_config.h"
+#include "counter_based_rng.h"
+#include "gauss_buffer.h"
 
 #include "grid_utils.inl"
 #include "rxn_utils.inl"
@@ -57,7 +59,8 @@ pick_2D_displacement:
          distance chosen from the probability distribution of a diffusing
          2D molecule, scaled by the scaling factor.
 *************************************************************************/
-static void pick_surf_displacement(Vec2& v, const double scale, rng_state& rng) {
+template<class RNG>
+static void pick_surf_displacement(Vec2& v, const double scale, RNG& rng) {
   const pos_t one_over_2_to_16th = 1.52587890625e-5f;
   Vec2 a;
 
@@ -71,7 +74,7 @@ static void pick_surf_displacement(Vec2& v, const double scale, rng_state& rng)
    */
   pos_t f;
   do {
-    unsigned int n = rng_uint(&rng);
+    unsigned int n = rng_next_uint(rng);
 
     a.u = 2 * one_over_2_to_16th * (n & 0xFFFF) - 1;
     a.v = 2 * one_over_2_to_16th * (n >> 16) - 1;
@@ -92,10 +95,11 @@ static void pick_surf_displacement(Vec2& v, const double scale, rng_state& rng)
 }
 
 
+template<class RNG>
 static void compute_surf_displacement(
     const BNG::Species& sp,
     const double scale,
-    rng_state& rng,
+    RNG& rng,
     Vec2& v
 ) {
   if (sp.can_diffuse()) {
@@ -110,12 +114,13 @@ static void compute_surf_displacement(
 // ---------------------------------- volume mol diffusion ----------------------------------
 
 // get displacement based on scale (related to diffusion constant) and gauss random number
-static inline void pick_vol_displacement(const BNG::Species& sp, const double scale, rng_state& rng, Vec3& displacement) {
+template<class RNG>
+static inline void pick_vol_displacement(const BNG::Species& sp, const double scale, RNG& rng, Vec3& displacement) {
 
   assert(sp.can_diffuse());
-  displacement.x = scale * rng_gauss(&rng) * 0.70710678118654752440;
-  displacement.y = scale * rng_gauss(&rng) * 0.70710678118654752440;
-  displacement.z = scale * rng_gauss(&rng) * 0.70710678118654752440;
+  displacement.x = scale * rng_next_gauss(rng) * 0.70710678118654752440;
+  displacement.y = scale * rng_next_gauss(rng) * 0.70710678118654752440;
+  displacement.z = scale * rng_next_gauss(rng) * 0.70710678118654752440;
 }
 
 
@@ -210,7 +215,7 @@ static inline double get_safe_diffusion_step(
   if (sp.has_flag(BNG::SPECIES_FLAG_CAN_VOLVOL) && !sp.has_flag(BNG::SPECIES_MOL_FLAG_CANT_INITIATE) ) {
 
     // get the closest distance to any molecule that can react
-    const MoleculeIdsSet& sp_reactants = p.get_volume_molecule_reactants(vm.v.subpart_index, vm.species_id);
+    const MoleculeIdsVector& sp_reactants = p.get_volume_molecule_reactants(vm.v.subpart_index, vm.species_id);
     for (molecule_id_t subpart_vm_id: sp_reactants) {
       const Molecule& subpart_vm = p.get_m(subpart_vm_id);
       assert(subpart_vm.is_vol());
@@ -333,11 +338,12 @@ pick_clamped_displacement:
   Note: vm->previous_wall points to the wall we're coming from, and
         vm->index is the orientation we came off with
 *************************************************************************/
+template<class RNG>
 static void pick_clamped_displacement(
     const Partition& p,
     const BNG::Species& sp,
     const Molecule& vm,
-    rng_state& rng,
+    RNG& rng,
     Vec3& displacement) {
 
   const double one_over_2_to_20th = 9.5367431640625e-7;
@@ -345,7 +351,7 @@ static void pick_clamped_displacement(
   assert(vm.v.previous_wall_index != WALL_INDEX_INVALID);
   const Wall& w = p.get_wall(vm.v.previous_wall_index);
 
-  uint n = rng_uint(&rng);
+  uint n = rng_next_uint(rng);
 
   /* Correct distribution along normal from surface (from lookup table) */
   double r_n = p.config.radial_2d_step[n & (p.config.num_radial_subdivisions - 1)];
@@ -363,12 +369,14 @@ static void pick_clamped_displacement(
 
 // - determine how far will our diffused molecule move
 // - called compute_displacement in MCell3
-static void compute_vol_displacement(
+// does not update simulation stats so that it can be used when diffusing in parallel
+template<class RNG>
+static void compute_vol_displacement_no_stats(
     const Partition& p,
     const BNG::Species& sp,
     Molecule& vm,
     double& max_time, // gets updated to t_steps
-    rng_state& rng,
+    RNG& rng,
     Vec3& displacement,
     double& rate_factor,
     double& r_rate_factor,
@@ -427,6 +435,26 @@ static void compute_vol_displacement(
 
   // update max_time
   max_time = t_steps;
+}
+
+
+template<class RNG>
+static void compute_vol_displacement(
+    const Partition& p,
+    const BNG::Species& sp,
+    Molecule& vm,
+    double& max_time, // gets updated to t_steps
+    RNG& rng,
+    Vec3& displacement,
+    double& rate_factor,
+    double& r_rate_factor,
+    double& steps, // number of steps
+    double& t_steps // time of steps
+) {
+  compute_vol_displacement_no_stats(
+      p, sp, vm, max_time, rng,
+      displacement, rate_factor, r_rate_factor, steps, t_steps
+  );
 
   p.stats.inc_diffusion_cummtime(steps);
 }
@@ -540,7 +568,7 @@ static bool move_sm_to_new_triangle(
   grid.reset_molecule_tile(sm.s.grid_tile_index);
   new_grid.set_molecule_tile(new_tile_index, sm.id);
   sm.s.grid_tile_index = new_tile_index;
-  sm.s.wall_index = new_wall_index;
+  p.set_surf_mol_wall_index(sm, new_wall_index);
 
   sm.s.pos = new_loc;
 
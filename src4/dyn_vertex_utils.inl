@@ -121,7 +121,7 @@ static void move_surface_molecule_to_closest_wall_point(
   assert(found_tile_index != TILE_INDEX_INVALID);
   assert(found_pos2d != Vec2(FLT_INVALID));
 
-  sm.s.wall_index = found_wall_index;
+  p.set_surf_mol_wall_index(sm, found_wall_index);
   sm.s.grid_tile_index = found_tile_index;
   sm.s.pos = found_pos2d;
   Wall& w = p.get_wall(found_wall_index);
@@ -0,0 +1,147 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_GAUSS_BUFFER_H_
+#define SRC4_GAUSS_BUFFER_H_
+
+#include <stdint.h>
+
+#include "rng.h"
+
+#include "defines.h"
+
+namespace MCell {
+
+// number of normally distributed numbers generated at once by GaussBuffer
+const uint GAUSS_BUFFER_SIZE = 256;
+
+/*
+ * Buffer of normally distributed random numbers that is refilled in bulk.
+ *
+ * Uses the same ziggurat tables as rng_gauss, a block of uniform random numbers
+ * is drawn first and the fast path of the ziggurat method, that accepts ~99% of samples,
+ * is evaluated over the whole block in a loop without function calls or branches on random data,
+ * rejected samples continue with the slow path of rng_gauss.
+ * Produces the same distribution as rng_gauss, but a different sequence of numbers.
+ *
+ * The loops are scalar code, drawing from the ISAAC generator is sequential and
+ * the table lookups are gathers, so the compiler vectorizes at most the fast path loop.
+ *
+ * Values in the buffer are not checkpointed, the buffer must be discarded whenever
+ * the state of the rng it was filled from is saved or replaced.
+ */
+class GaussBuffer {
+public:
+  GaussBuffer()
+    : next_index(GAUSS_BUFFER_SIZE) {
+  }
+
+  double next_gauss(rng_state& rng) {
+    if (next_index == GAUSS_BUFFER_SIZE) {
+      refill(rng);
+    }
+    return values[next_index++];
+  }
+
+  // the next call of next_gauss refills the buffer from rng
+  void discard() {
+    next_index = GAUSS_BUFFER_SIZE;
+  }
+
+private:
+  void refill(rng_state& rng) {
+    uint32_t bits[GAUSS_BUFFER_SIZE];
+    for (uint i = 0; i < GAUSS_BUFFER_SIZE; i++) {
+      bits[i] = rng_uint(&rng);
+    }
+
+    // bits 0..6 select a region under the curve, bit 7 is the sign bit,
+    // bits 8..31 pick a point within the region
+    bool accepted[GAUSS_BUFFER_SIZE];
+    for (uint i = 0; i < GAUSS_BUFFER_SIZE; i++) {
+      uint32_t region = bits[i] & 0x0000007f;
+      uint32_t pos_within_region = bits[i] & 0xffffff00;
+      double sign = (bits[i] & 0x80) ? -1.0 : 1.0;
+      values[i] = sign * (pos_within_region * WTAB[region]);
+      accepted[i] = pos_within_region < KTAB[region];
+    }
+
+    for (uint i = 0; i < GAUSS_BUFFER_SIZE; i++) {
+      if (!accepted[i]) {
+        values[i] = finish_rejected_sample(rng, bits[i]);
+      }
+    }
+
+    next_index = 0;
+  }
+
+  // continuation of the loop in rng_gauss for a sample that did not pass the fast check
+  static double finish_rejected_sample(rng_state& rng, const uint32_t bits) {
+    uint32_t region = bits & 0x0000007f;
+    uint32_t pos_within_region = bits & 0xffffff00;
+    double sign = (bits & 0x80) ? -1.0 : 1.0;
+
+    double x = pos_within_region * WTAB[region];
+    double y;
+    if (region != 0) {
+      double yB = YTAB[region];
+      double yR = YTAB[region - 1] - yB;
+      y = yB + yR * rng_dbl(&rng);
+    }
+    else {
+      x = SCALE_FACTOR - log1p(-rng_dbl(&rng)) * RECIP_SCALE_FACTOR;
+      y = exp(-SCALE_FACTOR * (x - 0.5 * SCALE_FACTOR)) * rng_dbl(&rng);
+    }
+
+    if (y < exp(-0.5 * x * x)) {
+      return sign * x;
+    }
+    else {
+      // start over with new bits
+      return rng_gauss(&rng);
+    }
+  }
+
+  double values[GAUSS_BUFFER_SIZE];
+  uint next_index;
+};
+
+
+// generator used when SimulationConfig::use_batched_gauss_rng is set,
+// uniform numbers are drawn directly from rng and normal numbers from its buffer
+class BufferedGaussRng {
+public:
+  BufferedGaussRng(rng_state& rng_, GaussBuffer& buffer_)
+    : rng(rng_), buffer(buffer_) {
+  }
+
+  rng_state& rng;
+  GaussBuffer& buffer;
+};
+
+
+// overloads that allow code to be templated on the type of the random number generator,
+// see also counter_based_rng.h
+static inline uint rng_next_uint(BufferedGaussRng& rng) {
+  return rng_uint(&rng.rng);
+}
+
+static inline double rng_next_dbl(BufferedGaussRng& rng) {
+  return rng_dbl(&rng.rng);
+}
+
+static inline double rng_next_gauss(BufferedGaussRng& rng) {
+  return rng.buffer.next_gauss(rng.rng);
+}
+
+} // namespace MCell
+
+#endif // SRC4_GAUSS_BUFFER_H_
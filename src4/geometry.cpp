@@ -1003,9 +1003,10 @@ void Region::initialize_region_waypoints_if_needed(Partition& p) {
   // get initial waypoint
   waypoints_in_this_region.clear();
 
-  IVec3 llf_waypoint_index;
-  subpart_index_t subpart_index = p.get_subpart_index(bounding_box_llf);
-  p.get_subpart_3d_indices_from_index(subpart_index, llf_waypoint_index);
+  // with multiple partitions, the region may start outside of this partition,
+  // waypoints that are outside are skipped in initialize_region_waypoint
+  IVec3 llf_waypoint_index =
+      floor3((bounding_box_llf - p.get_origin_corner()) * Vec3(p.config.subpart_edge_length_rcp));
 
   // then compute how many waypoints in each dimension we need to check
   Vec3 region_dims = bounding_box_urb - bounding_box_llf;
@@ -1304,6 +1305,11 @@ void update_moved_walls(
     }
   }
 
+  // tile neighbors of walls that did not move may lie on moved walls
+  for (Wall& w: p.get_walls()) {
+    w.grid.clear_tile_neighbors();
+  }
+
 
   // edges need to be fixed after all wall have been moved
   // otherwise the edge initialization would be using
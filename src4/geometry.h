@@ -330,6 +330,15 @@ public:
 
   bool is_point_inside(Partition& p, const Vec3& pos);
 
+  // subpartition and waypoint caches are specific for a partition,
+  // must be reset when a region is copied into another partition
+  void reset_partition_specific_caches() {
+    walls_per_subpart_initialized = false;
+    walls_per_subpart.clear();
+    region_waypoints_initialized = false;
+    waypoints_in_this_region.clear();
+  }
+
   // covers whole region
   bool name_has_suffix_ALL() const {
     std::string all(REGION_ALL_SUFFIX_W_COMMA);
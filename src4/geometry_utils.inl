@@ -102,7 +102,7 @@ static inline void get_wall_bounding_box(
 
 /***************************************************************************
 distribute_wall:
-  In: a wall 'w' that fully fits into partition 'p'
+  In: a wall 'w', parts of the wall outside of partition 'p' are ignored
   Out: colliding_subparts - indices of all the subpartitions in a given partition
         where the wall is located
 ***************************************************************************/
@@ -145,6 +145,17 @@ static void wall_subparts_collision_test(
   llf = llf - leeway3;
   urb = urb + leeway3;
 
+  // with multiple partitions, a wall may be only partially in this partition or not at all,
+  // limit the bounding box to the partition
+  const Vec3& p_llf = p.get_origin_corner();
+  const Vec3& p_urb = p.get_opposite_corner();
+  if (glm::any(glm::lessThan(urb, p_llf)) || glm::any(glm::greaterThanEqual(llf, p_urb))) {
+    return;
+  }
+  Vec3 p_urb_inside = p_urb - Vec3(p.config.subpart_edge_length / 2);
+  llf = glm::max((glm_vec3_t)llf, (glm_vec3_t)p_llf);
+  urb = glm::min((glm_vec3_t)urb, (glm_vec3_t)p_urb_inside);
+
   // let's assume for now that we are placing a cube with corners llf and urb,
   // fing what are the min and max parition indices
   IVec3 min_subpart_indices, max_subpart_indices;
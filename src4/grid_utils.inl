@@ -1801,6 +1801,84 @@ static void find_neighbor_tiles(
 }
 
 
+// computes neighbors of all tiles of the wall's grid for molecules that are not restricted
+// by region borders and stores them into the grid
+static void build_tile_neighbors(Partition& p, const Wall& wall) {
+  Grid& grid = p.get_wall(wall.index).grid;
+  assert(grid.is_initialized());
+  grid.clear_tile_neighbors();
+
+  // all walls that share at least one vertex with this wall may contain neighbor tiles,
+  // those without grid were skipped
+  for (uint i = 0; i < VERTICES_IN_TRIANGLE; i++) {
+    for (wall_index_t wi: p.get_walls_using_vertex(wall.vertex_indices[i])) {
+      if (wi != wall.index && !p.get_wall(wi).has_initialized_grid() &&
+          std::find(grid.tile_neighbors_walls_without_grid.begin(), grid.tile_neighbors_walls_without_grid.end(), wi) ==
+              grid.tile_neighbors_walls_without_grid.end()) {
+        grid.tile_neighbors_walls_without_grid.push_back(wi);
+      }
+    }
+  }
+
+  grid.tile_neighbors_offsets.reserve(grid.num_tiles + 1);
+  grid.tile_neighbors_offsets.push_back(0);
+  TileNeighborVector neighbors;
+  for (tile_index_t tile_index = 0; tile_index < grid.num_tiles; tile_index++) {
+    neighbors.clear();
+    find_neighbor_tiles(p, nullptr, wall, tile_index, false, true, neighbors);
+    grid.tile_neighbors.insert(grid.tile_neighbors.end(), neighbors.begin(), neighbors.end());
+    grid.tile_neighbors_offsets.push_back(grid.tile_neighbors.size());
+  }
+}
+
+
+static bool has_valid_tile_neighbors(const Partition& p, const Grid& grid) {
+  if (!grid.has_tile_neighbors()) {
+    return false;
+  }
+  for (wall_index_t wi: grid.tile_neighbors_walls_without_grid) {
+    if (p.get_wall(wi).has_initialized_grid()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// same as find_neighbor_tiles(p, &sm, wall, sm.s.grid_tile_index, false, true, neighbors)
+// but uses neighbors precomputed for the wall's grid when the molecule
+// cannot be restricted by region borders
+static void find_neighbor_tiles_for_reactant(
+    Partition& p,
+    const Molecule& sm,
+    const Wall& wall,
+    TileNeighborVector& neighbors
+) {
+  assert(sm.is_surf() && sm.s.wall_index == wall.index);
+
+  if (p.get_species(sm.species_id).can_interact_with_border()) {
+    find_neighbor_tiles(p, &sm, wall, sm.s.grid_tile_index, false, true, neighbors);
+    return;
+  }
+
+  if (!has_valid_tile_neighbors(p, wall.grid)) {
+    build_tile_neighbors(p, wall);
+  }
+
+  const Grid& grid = wall.grid;
+  assert(sm.s.grid_tile_index + 1 < grid.tile_neighbors_offsets.size());
+  neighbors.insert(
+      neighbors.begin(),
+      grid.tile_neighbors.begin() + grid.tile_neighbors_offsets[sm.s.grid_tile_index],
+      grid.tile_neighbors.begin() + grid.tile_neighbors_offsets[sm.s.grid_tile_index + 1]
+  );
+
+#ifdef DEBUG_GRIDS
+  neighbors.dump(__FUNCTION__, "  ");
+#endif
+}
+
+
 /*************************************************************************
 nearest_free:
   In: a surface grid
@@ -44,16 +44,16 @@ uint MolOrRxnCountTerm::get_num_pattern_matches(const species_id_t species_id) c
 
 
 uint MolOrRxnCountTerm::get_num_molecule_matches(
-    const Molecule& m,
+    const species_id_t mol_species_id, const bool is_vol,
     const species_id_t all_mol_id, const species_id_t all_vol_id, const species_id_t all_surf_id) const {
   assert(is_mol_count());
   if (species_pattern_type == SpeciesPatternType::SpeciesId) {
     assert(species_id != SPECIES_ID_INVALID);
     if (
-        species_id == m.species_id ||
+        species_id == mol_species_id ||
         species_id == all_mol_id ||
-       (species_id == all_vol_id && m.is_vol()) ||
-       (species_id == all_surf_id && m.is_surf())
+       (species_id == all_vol_id && is_vol) ||
+       (species_id == all_surf_id && !is_vol)
     ) {
       return 1;
     }
@@ -63,7 +63,7 @@ uint MolOrRxnCountTerm::get_num_molecule_matches(
   }
   else {
     assert(!species_molecules_pattern.elem_mols.empty());
-    return get_num_pattern_matches(m.species_id);
+    return get_num_pattern_matches(mol_species_id);
   }
 }
 
@@ -498,7 +498,11 @@ static bool wall_matches_region_expr_recursively(
 void MolOrRxnCountEvent::compute_mol_count_item(
     const Partition& p,
     const MolOrRxnCountItem& item,
-    const Molecule& m,
+    const species_id_t species_id,
+    const bool is_vol,
+    const counted_volume_index_t counted_volume_index,
+    const wall_index_t wall_index,
+    const uint num_molecules,
     CountItemVector& count_items
 ) {
   species_id_t all_mol_id = world->get_all_species().get_all_molecules_species_id();
@@ -511,27 +515,28 @@ void MolOrRxnCountEvent::compute_mol_count_item(
     if (term.is_mol_count()) {
 
       // num_matches may be > 1 when molecules pattern is used for matching
-      uint num_matches = term.get_num_molecule_matches(m, all_mol_id, all_vol_id, all_surf_id);
+      uint num_matches = term.get_num_molecule_matches(species_id, is_vol, all_mol_id, all_vol_id, all_surf_id);
       if (num_matches == 0) {
         continue;
       }
+      num_matches *= num_molecules;
 
       if (term.type == CountType::EnclosedInWorld) {
         // count the molecule
         count_items[item.index].inc_or_dec(term.sign_in_expression, num_matches);
       }
-      else if (m.is_vol() && term.type == CountType::EnclosedInVolumeRegion) {
+      else if (is_vol && term.type == CountType::EnclosedInVolumeRegion) {
 
         // is the molecule inside of the object/volume region expression that we are checking?
-        const CountedVolume& enclosing_volumes = p.get_counted_volume(m.v.counted_volume_index);
+        const CountedVolume& enclosing_volumes = p.get_counted_volume(counted_volume_index);
         if (counted_volume_matches_region_expr_recursively(enclosing_volumes, term.region_expr.root)) {
           count_items[item.index].inc_or_dec(term.sign_in_expression, num_matches);
         }
       }
-      else if (m.is_surf() && term.type == CountType::PresentOnSurfaceRegion) {
+      else if (!is_vol && term.type == CountType::PresentOnSurfaceRegion) {
 
         // does the molecule's wall match the region expression?
-        if (wall_matches_region_expr_recursively(p, m.s.wall_index, term.region_expr.root)) {
+        if (wall_matches_region_expr_recursively(p, wall_index, term.region_expr.root)) {
           count_items[item.index].inc_or_dec(term.sign_in_expression, num_matches);
         }
       }
@@ -552,8 +557,11 @@ void MolOrRxnCountEvent::compute_rxn_count_item(
     // does the current reaction match?
     if (term.is_rxn_count() && term.rxn_rule_id == rxn->id) {
 
-      // use initial_reactions_count (from previous checkpoint)
-      count_items[item.index].value += term.initial_reactions_count;
+      // use initial_reactions_count (from previous checkpoint),
+      // counts from partitions are summed so add it only once
+      if (p.id == PARTITION_ID_INITIAL) {
+        count_items[item.index].value += term.initial_reactions_count;
+      }
 
       // get counts from partition
       const CountInGeomObjectMap& counts_in_objects = p.get_rxn_in_volume_count_map(term.rxn_rule_id);
@@ -604,6 +612,97 @@ void MolOrRxnCountEvent::compute_rxn_count_item(
 }
 
 
+void MolOrRxnCountEvent::compute_mol_counts_for_partition(
+    const Partition& p,
+    const uint_set<uint>& processed_item_indices,
+    CountItemVector& count_items
+) {
+  const vector<CountInGeomObjectMap>& vol_counts = p.get_vol_mol_counts_per_counted_volume();
+  const vector<CountOnWallMap>& surf_counts = p.get_surf_mol_counts_per_wall();
+
+  for (species_id_t species_id = 0; species_id < max(vol_counts.size(), surf_counts.size()); species_id++) {
+    bool has_vol_mols = species_id < vol_counts.size() && !vol_counts[species_id].empty();
+    bool has_surf_mols = species_id < surf_counts.size() && !surf_counts[species_id].empty();
+    if (!has_vol_mols && !has_surf_mols) {
+      continue;
+    }
+
+    // check whether we are counting these species at all
+    const CountSpeciesInfo& species_info = get_or_compute_count_species_info(species_id);
+    if (species_info.type != CountSpeciesInfoType::Counted) {
+      assert(species_info.type == CountSpeciesInfoType::NotCounted);
+      continue;
+    }
+
+    // for each counting info
+    for (uint i = 0; i < mol_rxn_count_items.size(); i++) {
+      // skip already processed count items
+      if (processed_item_indices.count(i) != 0) {
+        continue;
+      }
+
+      if (has_vol_mols) {
+        for (const auto& counted_volume_and_count: vol_counts[species_id]) {
+          compute_mol_count_item(
+              p, mol_rxn_count_items[i], species_id, true,
+              counted_volume_and_count.first, WALL_INDEX_INVALID, counted_volume_and_count.second,
+              count_items);
+        }
+      }
+      if (has_surf_mols) {
+        for (const auto& wall_and_count: surf_counts[species_id]) {
+          compute_mol_count_item(
+              p, mol_rxn_count_items[i], species_id, false,
+              COUNTED_VOLUME_INDEX_INVALID, wall_and_count.first, wall_and_count.second,
+              count_items);
+        }
+      }
+    }
+  }
+}
+
+
+#ifdef DEBUG_EXTRA_CHECKS
+void MolOrRxnCountEvent::check_mol_counts_for_partition(
+    const Partition& p,
+    const uint_set<uint>& processed_item_indices,
+    const CountItemVector& count_items
+) {
+  CountItemVector counts_from_molecules(count_items.size());
+
+  for (const Molecule& m: p.get_molecules()) {
+    if (m.is_defunct()) {
+      continue;
+    }
+
+    const CountSpeciesInfo& species_info = get_or_compute_count_species_info(m.species_id);
+    if (species_info.type != CountSpeciesInfoType::Counted) {
+      continue;
+    }
+
+    for (uint i = 0; i < mol_rxn_count_items.size(); i++) {
+      if (processed_item_indices.count(i) != 0) {
+        continue;
+      }
+      compute_mol_count_item(
+          p, mol_rxn_count_items[i], m.species_id, m.is_vol(),
+          m.is_vol() ? m.v.counted_volume_index : COUNTED_VOLUME_INDEX_INVALID,
+          m.is_surf() ? m.s.wall_index : WALL_INDEX_INVALID,
+          1, counts_from_molecules);
+    }
+  }
+
+  CountItemVector counts_from_partition(count_items.size());
+  compute_mol_counts_for_partition(p, processed_item_indices, counts_from_partition);
+
+  for (uint i = 0; i < count_items.size(); i++) {
+    release_assert(counts_from_molecules[i].value == counts_from_partition[i].value &&
+        "Incrementally maintained molecule counts do not match");
+  }
+}
+#endif
+
+
 void MolOrRxnCountEvent::compute_counts(CountItemVector& count_items) {
 
   // go through all molecules and count them
@@ -621,8 +720,11 @@ void MolOrRxnCountEvent::compute_counts(CountItemVector& count_items) {
 
   // to improve performance, first process the species that we are counting in the whole world,
   // but only if there is less species than molecules (very crude heuristics)
-  if (world->get_all_species().get_species_vector().size() <
-      world->get_partition(PARTITION_ID_INITIAL).get_molecules().size()) {
+  size_t num_molecules = 0;
+  for (const Partition& p: partitions) {
+    num_molecules += p.get_molecules().size();
+  }
+  if (world->get_all_species().get_species_vector().size() < num_molecules) {
 
     for (const BNG::Species* species: world->get_all_species().get_species_vector()) {
       if (species->is_defunct() || species->get_num_instantiations() == 0) {
@@ -655,31 +757,12 @@ void MolOrRxnCountEvent::compute_counts(CountItemVector& count_items) {
   // for each partition
   for (Partition& p: partitions) {
 
-    // for each molecule (if we are counting them and we did not process all of them already)
+    // molecules (if we are counting them and we did not process all of them already)
     if (count_mols && processed_item_indices.size() != mol_rxn_count_items.size()) {
-      for (const Molecule& m: p.get_molecules()) {
-
-        if (m.is_defunct()) {
-          continue;
-        }
-
-        // check whether we are counting these species at all
-        const CountSpeciesInfo& species_info = get_or_compute_count_species_info(m.species_id);
-        if (species_info.type != CountSpeciesInfoType::Counted) {
-          assert(species_info.type == CountSpeciesInfoType::NotCounted);
-          continue;
-        }
-
-        // for each counting info
-        for (uint i = 0; i < mol_rxn_count_items.size(); i++) {
-          // skip already processed count items
-          if (processed_item_indices.count(i) != 0) {
-            continue;
-          }
-
-          compute_mol_count_item(p, mol_rxn_count_items[i], m, count_items);
-        }
-      } // for molecules
+#ifdef DEBUG_EXTRA_CHECKS
+      check_mol_counts_for_partition(p, processed_item_indices, count_items);
+#endif
+      compute_mol_counts_for_partition(p, processed_item_indices, count_items);
     }
 
     if (count_rxns) {
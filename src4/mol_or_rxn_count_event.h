@@ -66,7 +66,7 @@ public:
   uint get_num_pattern_matches(const species_id_t species_id) const;
 
   uint get_num_molecule_matches(
-      const Molecule& m,
+      const species_id_t species_id, const bool is_vol,
       const species_id_t all_mol_id, const species_id_t all_vol_id, const species_id_t all_surf_id
   ) const;
 
@@ -236,10 +236,16 @@ private:
   const CountSpeciesInfo& get_or_compute_count_species_info(const species_id_t species_id);
   void compute_count_species_info(const species_id_t species_id);
 
+  // counts num_molecules molecules of species species_id located in a given counted volume
+  // (volume molecules) or on a given wall (surface molecules)
   void compute_mol_count_item(
       const Partition& p,
       const MolOrRxnCountItem& item,
-      const Molecule& m,
+      const species_id_t species_id,
+      const bool is_vol,
+      const counted_volume_index_t counted_volume_index,
+      const wall_index_t wall_index,
+      const uint num_molecules,
       CountItemVector& count_items
   );
 
@@ -250,6 +256,24 @@ private:
       CountItemVector& count_items
   );
 
+  // uses molecule counts per counted volume and per wall maintained by partition,
+  // the time needed does not depend on the number of molecules
+  void compute_mol_counts_for_partition(
+      const Partition& p,
+      const uint_set<uint>& processed_item_indices,
+      CountItemVector& count_items
+  );
+
+#ifdef DEBUG_EXTRA_CHECKS
+  // checks the results of compute_mol_counts_for_partition against counts obtained
+  // by going through all molecules
+  void check_mol_counts_for_partition(
+      const Partition& p,
+      const uint_set<uint>& processed_item_indices,
+      const CountItemVector& count_items
+  );
+#endif
+
   void compute_counts(CountItemVector& count_items);
 
   // index to this array is species_id
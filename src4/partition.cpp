@@ -18,6 +18,7 @@
 #include "datamodel_defines.h"
 
 #include "wall_utils.h"
+#include "thread_pool.h"
 #include "dyn_vertex_utils.inl"
 #include "collision_utils.inl"
 #include "wall_utils.inl"
@@ -36,13 +37,14 @@ static void zero_out_lowest_bits_pos(pos_t* val) {
 Partition::Partition(
     const partition_id_t id_,
     const Vec3& origin_corner_,
+    molecule_id_t& next_molecule_id_,
     const SimulationConfig& config_,
     BNG::BNGEngine& bng_engine_,
     SimulationStats& stats_
 )
   : origin_corner(origin_corner_),
-    next_molecule_id(0),
-    volume_molecule_reactants_per_reactant_class(config_.num_subparts),
+    next_molecule_id(next_molecule_id_),
+    volume_molecule_reactants_per_reactant_class(&subpart_cells),
     id(id_),
     config(config_),
     bng_engine(bng_engine_),
@@ -65,8 +67,16 @@ Partition::Partition(
       "Partition is not aligned to the subpartition grid."
   );
 
+  // each subpart is its own cell until rebalance_subpart_cells is called
+  subpart_cells.init(config.num_subparts_per_partition_edge);
+
+  init_neighbor_subpart_offsets();
+
+  crossed_subparts_for_molecules.initialize_stamps(config.num_subparts);
+
   // pre-allocate volume_molecules arrays and also volume_molecule_indices_per_time_step
   walls_per_subpart.resize(config.num_subparts);
+  wall_batches_per_subpart.resize(config.num_subparts);
 
   // create an empty counted volume
   CountedVolume counted_volume_outside_all;
@@ -88,7 +98,16 @@ Partition::~Partition() {
 // when a wall is added with add_uninitialized_wall,
 // its type and vertices are not know yet, we must include the walls
 // into subvolumes and also for other purposes
-void Partition::finalize_walls() {
+void Partition::finalize_walls(ThreadPool* thread_pool) {
+  // collision tests of walls with subpartitions are independent, the results
+  // are then inserted in the order of walls
+  vector<SubpartIndicesVector> colliding_subparts_per_wall(walls.size());
+  ThreadPool::run_for_each_index(thread_pool, walls.size(),
+      [&](const uint i) {
+        GeometryUtils::wall_subparts_collision_test(*this, walls[i], colliding_subparts_per_wall[i]);
+      }
+  );
+
   for (Wall& w: walls) {
     wall_index_t wall_index = w.index;
 
@@ -99,13 +118,12 @@ void Partition::finalize_walls() {
     w.present_in_subparts.clear();
 
     // also insert this triangle into walls per subpartition
-    SubpartIndicesVector colliding_subparts;
-    GeometryUtils::wall_subparts_collision_test(*this, w, colliding_subparts);
-    for (subpart_index_t subpart_index: colliding_subparts) {
-      assert(subpart_index < walls_per_subpart.size());
+    for (subpart_index_t subpart_index: colliding_subparts_per_wall[wall_index]) {
+      uint cell_index = subpart_cells.get_cell_index(subpart_index);
+      assert(cell_index < walls_per_subpart.size());
 
       // mapping subpart->wall
-      walls_per_subpart[subpart_index].insert(wall_index);
+      walls_per_subpart[cell_index].insert(wall_index);
 
       // mapping wall->subpart
       w.present_in_subparts.insert(subpart_index); // TODO: use insert_unique
@@ -115,10 +133,64 @@ void Partition::finalize_walls() {
     assert(wall_collision_rejection_data.size() == wall_index);
     wall_collision_rejection_data.push_back(w);
   }
+
+  ThreadPool::run_for_each_index(thread_pool, walls_per_subpart.size(),
+      [&](const uint i) {
+        wall_batches_per_subpart[i].update(walls_per_subpart[i], wall_collision_rejection_data);
+      }
+  );
+
+  if (config.use_wall_bvh) {
+    wall_bvh.build(*this);
+  }
+
+  update_wall_free_radius_per_subpart();
 }
 
+
+void Partition::copy_geometry_from(const Partition& src, ThreadPool* thread_pool) {
+  assert(walls.empty() && geometry_objects.empty() && "Geometry can be copied only into an empty partition");
+
+  geometry_vertices = src.geometry_vertices;
+  geometry_objects = src.geometry_objects;
+
+  // shared wall data are owned by partition, make copies and update pointers
+  map<const WallSharedData*, WallSharedData*> wall_shared_data_mapping;
+  for (const WallSharedData* src_data: src.wall_shared_data) {
+    WallSharedData* data_copy = new WallSharedData(*src_data);
+    wall_shared_data.insert(data_copy);
+    wall_shared_data_mapping[src_data] = data_copy;
+  }
+
+  walls = src.walls;
+  for (Wall& w: walls) {
+    if (w.wall_shared_data != nullptr) {
+      assert(wall_shared_data_mapping.count(w.wall_shared_data) != 0);
+      w.wall_shared_data = wall_shared_data_mapping[w.wall_shared_data];
+    }
+    // molecules on the grid belong to the source partition
+    if (w.has_initialized_grid()) {
+      w.grid.reset_all_tiles();
+    }
+  }
+
+  regions = src.regions;
+  for (Region& reg: regions) {
+    reg.reset_partition_specific_caches();
+  }
+
+  counted_volumes_vector = src.counted_volumes_vector;
+  counted_volumes_set = src.counted_volumes_set;
+  counted_volume_index_to_compartment_id_cache = src.counted_volume_index_to_compartment_id_cache;
+
+  // fills walls_per_subpart, walls_using_vertex_mapping and wall_collision_rejection_data
+  finalize_walls(thread_pool);
+}
+
+
 // remove items when 'insert' is false
 void Partition::update_walls_per_subpart(const WallsWithTheirMovesMap& walls_with_their_moves, const bool insert) {
+  SubpartIndicesSet changed_cells;
   for (auto it: walls_with_their_moves) {
     wall_index_t wall_index = it.first;
     SubpartIndicesVector colliding_subparts;
@@ -127,17 +199,167 @@ void Partition::update_walls_per_subpart(const WallsWithTheirMovesMap& walls_wit
     assert(insert || SubpartIndicesSet(colliding_subparts.begin(), colliding_subparts.end()) == w.present_in_subparts);
 
     for (subpart_index_t subpart_index: colliding_subparts) {
-      assert(subpart_index < walls_per_subpart.size());
+      uint cell_index = subpart_cells.get_cell_index(subpart_index);
+      assert(cell_index < walls_per_subpart.size());
       if (insert) {
-        walls_per_subpart[subpart_index].insert_unique(wall_index);
+        if (subpart_cells.has_merged_subparts()) {
+          // the wall may be already present in this cell through another subpart
+          walls_per_subpart[cell_index].insert(wall_index);
+        }
+        else {
+          walls_per_subpart[cell_index].insert_unique(wall_index);
+        }
         w.present_in_subparts.insert(subpart_index);
       }
       else {
-        walls_per_subpart[subpart_index].erase_existing(wall_index);
         w.present_in_subparts.erase(subpart_index);
+
+        // keep the wall in its cell while it is present in another subpart of this cell
+        bool present_in_cell = false;
+        for (subpart_index_t other_subpart_index: w.present_in_subparts) {
+          if (subpart_cells.get_cell_index(other_subpart_index) == cell_index) {
+            present_in_cell = true;
+            break;
+          }
+        }
+        if (!present_in_cell) {
+          walls_per_subpart[cell_index].erase_existing(wall_index);
+        }
+      }
+      changed_cells.insert(cell_index);
+    }
+  }
+
+  // wall collision rejection data of moved walls were already updated when inserting
+  for (uint cell_index: changed_cells) {
+    wall_batches_per_subpart[cell_index].update(
+        walls_per_subpart[cell_index], wall_collision_rejection_data);
+  }
+}
+
+
+void Partition::init_neighbor_subpart_offsets() {
+  const IVec3 strides(
+      1, config.num_subparts_per_partition_edge, config.num_subparts_per_partition_edge_squared);
+
+  // axes that must be close to a boundary for each neighbor, the order x, y, z, xy, xz, yz, xyz
+  // is the same as in which the neighbors were collected by per-axis checks
+  const IVec3 neighbor_axes[] = {
+      IVec3(1, 0, 0), IVec3(0, 1, 0), IVec3(0, 0, 1),
+      IVec3(1, 1, 0), IVec3(1, 0, 1), IVec3(0, 1, 1), IVec3(1, 1, 1)
+  };
+
+  for (int z = -1; z <= 1; z++) {
+    for (int y = -1; y <= 1; y++) {
+      for (int x = -1; x <= 1; x++) {
+        IVec3 zone_dirs(x, y, z);
+        NeighborSubpartOffsets& neighbors =
+            neighbor_subpart_offsets_per_zone[NeighborSubpartOffsets::get_zone_index(zone_dirs)];
+        neighbors.count = 0;
+
+        for (const IVec3& axes: neighbor_axes) {
+          IVec3 dirs(zone_dirs * axes);
+          if (dirs * dirs == axes) {
+            neighbors.offsets[neighbors.count] = dirs.x * strides.x + dirs.y * strides.y + dirs.z * strides.z;
+            neighbors.count++;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+void Partition::update_wall_free_radius_per_subpart() {
+  // breadth-first search over all 26 neighbors from subparts that contain walls
+  // computes the Chebyshev distance in subparts to the closest wall
+  const int dim = config.num_subparts_per_partition_edge;
+  vector<int> distance_to_wall(config.num_subparts, INT_MAX);
+  vector<subpart_index_t> queue;
+  for (const Wall& w: walls) {
+    for (subpart_index_t subpart_index: w.present_in_subparts) {
+      if (distance_to_wall[subpart_index] != 0) {
+        distance_to_wall[subpart_index] = 0;
+        queue.push_back(subpart_index);
+      }
+    }
+  }
+
+  for (uint head = 0; head < queue.size(); head++) {
+    IVec3 indices;
+    get_subpart_3d_indices_from_index(queue[head], indices);
+    int next_distance = distance_to_wall[queue[head]] + 1;
+
+    for (int z = max(indices.z - 1, 0); z <= min(indices.z + 1, dim - 1); z++) {
+      for (int y = max(indices.y - 1, 0); y <= min(indices.y + 1, dim - 1); y++) {
+        for (int x = max(indices.x - 1, 0); x <= min(indices.x + 1, dim - 1); x++) {
+          subpart_index_t neighbor_index = get_subpart_index_from_3d_indices(x, y, z);
+          if (distance_to_wall[neighbor_index] == INT_MAX) {
+            distance_to_wall[neighbor_index] = next_distance;
+            queue.push_back(neighbor_index);
+          }
+        }
+      }
+    }
+  }
+
+  // the partition boundary limits the radius in the same way as a wall behind it
+  wall_free_radius_per_subpart.resize(config.num_subparts);
+  for (subpart_index_t i = 0; i < config.num_subparts; i++) {
+    IVec3 indices;
+    get_subpart_3d_indices_from_index(i, indices);
+    int distance_to_boundary = min(min3_i(indices), dim - 1 - max3_i(indices));
+
+    if (distance_to_wall[i] == INT_MAX) {
+      wall_free_radius_per_subpart[i] = distance_to_boundary;
+    }
+    else {
+      wall_free_radius_per_subpart[i] = min(distance_to_wall[i] - 1, distance_to_boundary);
+    }
+  }
+}
+
+
+void Partition::rebalance_subpart_cells() {
+  vector<uint> molecule_count_per_subpart(config.num_subparts, 0);
+  for (const Molecule& m: molecules) {
+    if (m.is_vol() && !m.is_defunct()) {
+      assert(m.v.subpart_index < config.num_subparts);
+      molecule_count_per_subpart[m.v.subpart_index]++;
+    }
+  }
+
+  vector<uint> wall_count_per_subpart(config.num_subparts, 0);
+  for (const Wall& w: walls) {
+    for (subpart_index_t subpart_index: w.present_in_subparts) {
+      wall_count_per_subpart[subpart_index]++;
+    }
+  }
+
+  if (!subpart_cells.rebuild(molecule_count_per_subpart, wall_count_per_subpart)) {
+    return;
+  }
+
+  // reactants are stored under the subpart where they were registered,
+  // this subpart may differ from their current subpart
+  volume_molecule_reactants_per_reactant_class.rebuild_cells(
+      [this](const molecule_id_t id) -> subpart_index_t {
+        return get_m(id).v.reactant_subpart_index;
       }
+  );
+
+  uint num_cells = subpart_cells.get_num_cells();
+  vector<WallsInSubpart>(num_cells).swap(walls_per_subpart);
+  for (const Wall& w: walls) {
+    for (subpart_index_t subpart_index: w.present_in_subparts) {
+      walls_per_subpart[subpart_cells.get_cell_index(subpart_index)].insert(w.index);
     }
   }
+
+  vector<SubpartWallBatch>(num_cells).swap(wall_batches_per_subpart);
+  for (uint i = 0; i < num_cells; i++) {
+    wall_batches_per_subpart[i].update(walls_per_subpart[i], wall_collision_rejection_data);
+  }
 }
 
 
@@ -217,6 +439,17 @@ void Partition::apply_vertex_moves(
           colliding_walls, vertex_moves_due_to_paired_molecules);
     }
   }
+
+  // topology of the tree is kept, only bounding boxes are updated
+  if (wall_bvh.is_built()) {
+    wall_bvh.refit(*this);
+  }
+
+  update_wall_free_radius_per_subpart();
+
+  if (counted_volume_voxels.is_built()) {
+    counted_volume_voxels.update(*this);
+  }
 }
 
 
@@ -311,6 +544,26 @@ void Partition::apply_vertex_moves_per_object(
   // 5) update subpartition info for the walls
   update_walls_per_subpart(walls_with_their_moves, true);
 
+  // 5.1) voxels swept by the moved walls must not be used until they are rebuilt
+  if (counted_volume_voxels.is_built()) {
+    for (const auto& it: walls_with_their_moves) {
+      const Wall& w = get_wall(it.first);
+      Vec3 llf = get_wall_vertex(w, 0);
+      Vec3 urb = llf;
+      for (uint i = 1; i < VERTICES_IN_TRIANGLE; i++) {
+        llf = glm::min((glm_vec3_t)llf, (glm_vec3_t)get_wall_vertex(w, i));
+        urb = glm::max((glm_vec3_t)urb, (glm_vec3_t)get_wall_vertex(w, i));
+      }
+      // also include the original position of the moved vertices
+      for (const VertexMoveInfo* vertex_move_info: it.second.vertex_moves) {
+        Vec3 orig_pos = get_geometry_vertex(vertex_move_info->vertex_index) - vertex_move_info->displacement;
+        llf = glm::min((glm_vec3_t)llf, (glm_vec3_t)orig_pos);
+        urb = glm::max((glm_vec3_t)urb, (glm_vec3_t)orig_pos);
+      }
+      counted_volume_voxels.invalidate_subparts_in_box(*this, llf, urb);
+    }
+  }
+
   // 6) move volume molecules
   for (const VolumeMoleculeMoveInfo& move_info: volume_molecule_moves) {
     DynVertexUtils::move_volume_molecule_to_closest_wall_point(*this, move_info);
@@ -650,15 +903,16 @@ void Partition::dump(const bool with_geometry) {
 
 #ifndef NDEBUG
   if (with_geometry) {
-    for (size_t i = 0; i < walls_per_subpart.size(); i++) {
-      if (!walls_per_subpart[i].empty()) {
+    for (subpart_index_t i = 0; i < config.num_subparts; i++) {
+      const WallsInSubpart& subpart_wall_indices = get_subpart_wall_indices(i);
+      if (!subpart_wall_indices.empty()) {
         Vec3 llf, urb;
         get_subpart_llf_point(i, llf);
         urb = llf + Vec3(config.subpart_edge_length);
 
         cout << "subpart: " << i << ", llf: " << llf << ", urb: " << urb << "\n  ";
 
-        for (wall_index_t wi: walls_per_subpart[i]) {
+        for (wall_index_t wi: subpart_wall_indices) {
           cout << wi << ", ";
         }
         cout << "\n";
@@ -674,30 +928,37 @@ void Partition::dump(const bool with_geometry) {
 // therefore it cannot be safely determined where it belongs
 // waypoints are used as an optimization so we can place them anywhere we like
 void Partition::move_waypoint_because_positioned_on_wall(
-    const IVec3& waypoint_index, const bool reinitialize) {
+    const IVec3& waypoint_index, const bool reinitialize, rng_state* rng) {
+  rng_state& waypoint_rng = (rng != nullptr) ? *rng : aux_rng;
+
   Waypoint& waypoint = get_waypoint(waypoint_index);
   // rng_dbl when used in Vec3 ctor causes compiler to print warnings
   // that a constant is subtracted from uint
-  double r1 = rng_dbl(&aux_rng);
-  double r2 = rng_dbl(&aux_rng);
-  double r3 = rng_dbl(&aux_rng);
+  double r1 = rng_dbl(&waypoint_rng);
+  double r2 = rng_dbl(&waypoint_rng);
+  double r3 = rng_dbl(&waypoint_rng);
 
   Vec3 random_displacement = Vec3(POS_SQRT_EPS * r1, POS_SQRT_EPS * r2, POS_SQRT_EPS * r3);
 
   waypoint.pos = waypoint.pos + random_displacement;
   if (reinitialize) {
-    initialize_waypoint(waypoint_index, false, IVec3(0), true);
+    initialize_waypoint(waypoint_index, false, IVec3(0), true, rng);
   }
 }
 
 
 // keep_pos is false by default, when true, the waypoint position is reused and
-// this function only updates the counted_volume_index for the new position
-void Partition::initialize_waypoint(
+// this function only updates the counted_volume_index for the new position,
+// when deferred_counted_volume is set, the counted volume is not added to this partition,
+// see declaration in partition.h
+bool Partition::initialize_waypoint(
     const IVec3& waypoint_index,
     const bool use_previous_waypoint,
     const IVec3& previous_waypoint_index,
-    const bool keep_pos
+    const bool keep_pos,
+    rng_state* rng,
+    CountedVolume* deferred_counted_volume,
+    SimulationStats* thread_stats
 ) {
   // array was allocated
   Waypoint& waypoint = get_waypoint(waypoint_index);
@@ -718,7 +979,7 @@ void Partition::initialize_waypoint(
     dist2 = WallUtils::find_closest_wall_any_object(
         *this, waypoint.pos, POS_SQRT_EPS, false, wall_index_ignored, wall_pos2d_ignored);
     if (dist2 < POS_EPS) {
-       move_waypoint_because_positioned_on_wall(waypoint_index, false);
+       move_waypoint_because_positioned_on_wall(waypoint_index, false, rng);
     }
   } while (dist2 < POS_EPS);
 
@@ -733,11 +994,12 @@ void Partition::initialize_waypoint(
 
       CollisionUtils::get_num_crossed_walls_per_object(
           *this, waypoint.pos, previous_waypoint_pos, false, // all walls
-          num_crossed_walls_per_object, redo
+          num_crossed_walls_per_object, redo,
+          GEOMETRY_OBJECT_ID_INVALID, nullptr, rng, thread_stats
       );
 
       if (redo) {
-         move_waypoint_because_positioned_on_wall(waypoint_index, false);
+         move_waypoint_because_positioned_on_wall(waypoint_index, false, rng);
 
          if (num_attempts >= 5) {
            // give up because we are getting redos due to the previous waypoint,
@@ -760,33 +1022,41 @@ void Partition::initialize_waypoint(
       bool must_redo_test = false;
       CollisionUtils::get_num_crossed_walls_per_object(
           *this, waypoint.pos, previous_waypoint.pos, true, // only counted objects
-          num_crossed_walls_per_object, must_redo_test
+          num_crossed_walls_per_object, must_redo_test,
+          GEOMETRY_OBJECT_ID_INVALID, nullptr, rng, thread_stats
       );
       if (must_redo_test) {
         // updates values referenced by waypoint
         // the redo can be also due to the previous waypoint, so we
         // will check whether the waypoint is contained without the previous waypoint
         // do not call reinitialize to avoid recursion
-        move_waypoint_because_positioned_on_wall(waypoint_index, false);
+        move_waypoint_because_positioned_on_wall(waypoint_index, false, rng);
       }
       // ok, test passed safely
       else if (num_crossed_walls_per_object.empty()) {
         // ok, we can simply copy counted volume from the previous waypoint
         waypoint.counted_volume_index = previous_waypoint.counted_volume_index;
-        return;
+        return false;
       }
     }
 
     // figure out in which counted volumes is this waypoint present
+    if (deferred_counted_volume != nullptr) {
+      CollisionUtils::collect_counted_objects_for_pos(
+          *this, waypoint.pos, *deferred_counted_volume, rng, thread_stats);
+      waypoint.counted_volume_index = COUNTED_VOLUME_INDEX_INVALID;
+      return true;
+    }
     waypoint.counted_volume_index = compute_counted_volume_from_scratch(waypoint.pos);
   }
   else {
     waypoint.counted_volume_index = COUNTED_VOLUME_INDEX_OUTSIDE_ALL;
   }
+  return false;
 }
 
 
-void Partition::initialize_all_waypoints() {
+void Partition::initialize_all_waypoints(ThreadPool* thread_pool) {
   // we need waypoints to be initialized all the time because they
   // are used not just when dealing with counted volumes, but also
   // by regions when detecting whether a point is inside
@@ -796,23 +1066,84 @@ void Partition::initialize_all_waypoints() {
 
   mcell_log("Initializing %d waypoints... ", powu(num_waypoints_per_dimension, 3));
 
-  bool use_previous_waypoint = false;
-  IVec3 previous_waypoint_index;
+  waypoints.clear();
+  waypoints.resize(powu(num_waypoints_per_dimension, 3));
 
-  waypoints.resize(num_waypoints_per_dimension);
-  for (uint x = 0; x < num_waypoints_per_dimension; x++) {
-    waypoints[x].resize(num_waypoints_per_dimension);
-    for (uint y = 0; y < num_waypoints_per_dimension; y++) {
-      waypoints[x][y].resize(num_waypoints_per_dimension);
-      for (uint z = 0; z < num_waypoints_per_dimension; z++) {
-        initialize_waypoint(IVec3(x, y, z), use_previous_waypoint, previous_waypoint_index);
+  if (thread_pool == nullptr || thread_pool->get_num_threads() == 1) {
+    for (uint x = 0; x < num_waypoints_per_dimension; x++) {
+      initialize_waypoints_slab(x);
+    }
+    return;
+  }
 
-        use_previous_waypoint = true;
-        previous_waypoint_index = IVec3(x, y, z);
+  // each thread processes whole slabs with a fixed x index, the lines along z in them
+  // are independent, counted volumes are added in the same order as in the serial variant
+  // once all slabs are done because find_or_add_counted_volume modifies this partition
+  vector<CountedVolume> deferred_counted_volumes(waypoints.size());
+  vector<uint8_t> is_deferred(waypoints.size(), 0);
+  uint num_threads = thread_pool->get_num_threads();
+  // shared stats must not be updated from multiple threads
+  vector<SimulationStats> thread_stats(num_threads);
+
+  thread_pool->run_on_all_threads(
+      [&](const uint thread_index) {
+        for (uint x = thread_index; x < num_waypoints_per_dimension; x += num_threads) {
+          // the result must not depend on the number of threads, so each slab has its own generator
+          rng_state slab_rng;
+          rng_init(&slab_rng, config.initial_seed + x);
+          initialize_waypoints_slab(
+              x, &slab_rng, &deferred_counted_volumes, &is_deferred, &thread_stats[thread_index]);
+        }
       }
+  );
 
-      // starting a new line - start from scratch
-      use_previous_waypoint = false;
+  for (const SimulationStats& s: thread_stats) {
+    stats.add_ray_stats(s);
+  }
+
+  for (uint i = 0; i < waypoints.size(); i++) {
+    if (is_deferred[i]) {
+      waypoints[i].counted_volume_index = find_or_add_counted_volume(deferred_counted_volumes[i]);
+    }
+    else if (waypoints[i].counted_volume_index == COUNTED_VOLUME_INDEX_INVALID) {
+      // copied from a previous waypoint in the same line whose counted volume was deferred,
+      // lines are ordered by z, so the previous waypoint was already resolved
+      assert(i > 0 && waypoints[i - 1].counted_volume_index != COUNTED_VOLUME_INDEX_INVALID);
+      waypoints[i].counted_volume_index = waypoints[i - 1].counted_volume_index;
+    }
+  }
+}
+
+
+void Partition::initialize_waypoints_slab(
+    const uint x,
+    rng_state* rng,
+    vector<CountedVolume>* deferred_counted_volumes,
+    vector<uint8_t>* is_deferred,
+    SimulationStats* thread_stats
+) {
+  uint num_waypoints_per_dimension = config.num_subparts_per_partition_edge;
+
+  for (uint y = 0; y < num_waypoints_per_dimension; y++) {
+    // each line starts from scratch
+    bool use_previous_waypoint = false;
+    IVec3 previous_waypoint_index;
+
+    for (uint z = 0; z < num_waypoints_per_dimension; z++) {
+      IVec3 waypoint_index(x, y, z);
+
+      if (deferred_counted_volumes == nullptr) {
+        initialize_waypoint(waypoint_index, use_previous_waypoint, previous_waypoint_index);
+      }
+      else {
+        uint i = get_waypoint_array_index(waypoint_index);
+        (*is_deferred)[i] = initialize_waypoint(
+            waypoint_index, use_previous_waypoint, previous_waypoint_index, false,
+            rng, &(*deferred_counted_volumes)[i], thread_stats);
+      }
+
+      use_previous_waypoint = true;
+      previous_waypoint_index = waypoint_index;
     }
   }
 }
@@ -931,6 +1262,68 @@ void Partition::remove_reactant_class_usage(const BNG::reactant_class_id_t react
 }
 
 
+// diffusion_time of a molecule that is not ready is at least the returned iteration
+static uint64_t get_next_diffusion_check_iteration(const double diffusion_time, const uint64_t current_iteration) {
+  if (diffusion_time >= (double)ITERATION_NEVER) {
+    return ITERATION_NEVER;
+  }
+  return max((uint64_t)floor_f(diffusion_time), current_iteration + 1);
+}
+
+
+void Partition::get_molecules_ready_for_diffusion(MoleculeIdsVector& ready_vector) {
+  ready_vector.clear();
+  uint64_t current_iteration = stats.get_current_iteration();
+  double time_it_end = current_iteration + 1;
+
+  diffusion_calendar.collect_positions_to_check(
+      current_iteration, schedulable_molecule_ids.size(), schedulable_positions_to_check);
+
+  for (uint position: schedulable_positions_to_check) {
+    const Molecule& m = get_m(schedulable_molecule_ids[position]);
+    assert(!m.has_flag(MOLECULE_FLAG_NO_NEED_TO_SCHEDULE));
+
+    if (m.is_defunct()) {
+      // will be removed from schedulable_molecule_ids in defragmentation
+      continue;
+    }
+
+    // new products may have been scheduled for the previous iteration
+    if (cmp_lt(m.diffusion_time, time_it_end, EPS)) {
+      ready_vector.push_back(m.id);
+      diffusion_calendar.file_ready(position);
+    }
+    else {
+      diffusion_calendar.file_not_ready(
+          position, get_next_diffusion_check_iteration(m.diffusion_time, current_iteration));
+    }
+  }
+
+#ifndef NDEBUG
+  // the calendar must select the same molecules as checking all of them
+  MoleculeIdsVector all_checked;
+  for (molecule_id_t id: schedulable_molecule_ids) {
+    const Molecule& m = get_m(id);
+    if (!m.is_defunct() && cmp_lt(m.diffusion_time, time_it_end, EPS)) {
+      all_checked.push_back(m.id);
+    }
+  }
+  assert(all_checked == ready_vector && "Diffusion calendar was not reset after a change of diffusion times");
+#endif
+}
+
+
+void Partition::order_molecule_ids_by_molecule_index() {
+  auto comp = [this](const molecule_id_t id1, const molecule_id_t id2) -> bool {
+    return molecule_id_to_index_mapping.get(id1) < molecule_id_to_index_mapping.get(id2);
+  };
+
+  sort(schedulable_molecule_ids.begin(), schedulable_molecule_ids.end(), comp);
+  volume_molecule_reactants_per_reactant_class.sort_ids(comp);
+  diffusion_calendar.reset();
+}
+
+
 void Partition::shuffle_schedulable_molecule_ids() {
 
   size_t n = schedulable_molecule_ids.size();
@@ -950,11 +1343,12 @@ void Partition::shuffle_schedulable_molecule_ids() {
     schedulable_molecule_ids[i] = schedulable_molecule_ids[rand_index];
     schedulable_molecule_ids[rand_index] = tmp;
   }
+  diffusion_calendar.reset();
 }
 
 
 static std::string check_is_valid_surface_molecule(const Partition& p, const molecule_id_t id, const char* name) {
-  if (id == MOLECULE_ID_INVALID || id >= p.get_molecule_id_to_index_mapping().size()) {
+  if (id == MOLECULE_ID_INVALID || p.get_molecule_id_to_index_mapping().get(id) == MOLECULE_INDEX_INVALID) {
     return string("Molecule with id '") + name + "' is invalid.";
   }
   const Molecule& m = p.get_m(id);
@@ -1079,7 +1473,7 @@ void Partition::to_data_model(Json::Value& mcell, std::set<rgba_t>& used_colors)
 void Partition::print_periodic_stats() const {
   std::cout <<
       "Partition: molecules.size() = " << molecules.size() << "\n" <<
-      "Partition: molecule_id_to_index_mapping.size() = " << molecule_id_to_index_mapping.size() << "\n" <<
+      "Partition: molecule_id_to_index_mapping pages = " << molecule_id_to_index_mapping.get_num_allocated_pages() << "\n" <<
       "Partition: next_molecule_id = " << next_molecule_id << "\n" <<
       "Partition: known_vol_species.size() = " << known_vol_species.size() << "\n";
 }
@@ -13,11 +13,20 @@
 #define SRC4_PARTITION_H_
 
 #include <set>
+#include <algorithm>
 
 #include "bng/rxn_container.h"
 #include "defines.h"
 #include "dyn_vertex_structs.h"
 #include "molecule.h"
+#include "sparse_id_map.h"
+#include "subpart_cells.h"
+#include "subpart_wall_batch.h"
+#include "wall_bvh.h"
+#include "counted_volume_voxels.h"
+#include "diffusion_calendar.h"
+#include "rxn_pathway_alias_tables.h"
+#include "species_pair_rxn_class_cache.h"
 #include "scheduler.h"
 #include "geometry.h"
 #include "simulation_stats.h"
@@ -32,107 +41,293 @@ class Value;
 
 namespace MCell {
 
+class ThreadPool;
 
 typedef std::map<counted_volume_index_t, uint> CountInGeomObjectMap;
 typedef std::map<wall_index_t, uint> CountOnWallMap;
 typedef uint_set<wall_index_t> WallsInSubpart; 
+typedef SparseIdMap<molecule_index_t, MOLECULE_INDEX_INVALID> MoleculeIdToIndexMap;
 
-// class used to hold potential reactants of given species in a single subpart
-// performance critical, therefore we are using a vector for now,
-// we will probably need to change it in the future by deriving it from
-//   std::map<species_id_t, uint_set<molecule_id_t> >,
+// each axis of a position in a subpartition is either close to the lower boundary (-1),
+// to the upper boundary (+1), or to neither of them (0), this gives 27 zones
+const uint NUM_SUBPART_ZONES = 27;
+
+// differences of subpartition indices of neighbors that must be checked
+// for a position in a given zone, see CollisionUtils::collect_neighboring_subparts
+struct NeighborSubpartOffsets {
+  static uint get_zone_index(const IVec3& zone_dirs) {
+    return (zone_dirs.x + 1) + 3 * (zone_dirs.y + 1) + 9 * (zone_dirs.z + 1);
+  }
+
+  uint count;
+  int offsets[7];
+};
+
+// positions of molecules in SubpartReactantsSets of all reactant classes of a partition,
+// a single map from molecule ids is shared by all reactant classes so that its memory
+// does not grow with the number of reactant classes,
+// a molecule is stored only for a few reactant classes so these are searched linearly
+class ReactantSlotMap {
+public:
+  // returns UINT_INVALID if the molecule is not stored for this reactant class
+  uint get(const molecule_id_t id, const BNG::reactant_class_id_t reactant_class_id) const {
+    uint record_index = record_index_by_molecule_id.get(id);
+    if (record_index == UINT_INVALID) {
+      return UINT_INVALID;
+    }
+    for (const ReactantClassAndSlot& item: records[record_index]) {
+      if (item.reactant_class_id == reactant_class_id) {
+        return item.slot;
+      }
+    }
+    return UINT_INVALID;
+  }
+
+  // may be called concurrently for different molecules only if each of them
+  // is already stored for some reactant class, a new record is allocated otherwise
+  void set(const molecule_id_t id, const BNG::reactant_class_id_t reactant_class_id, const uint slot) {
+    uint record_index = record_index_by_molecule_id.get(id);
+    if (record_index == UINT_INVALID) {
+      record_index = allocate_record();
+      record_index_by_molecule_id.set(id, record_index);
+    }
+    ReactantClassAndSlotVector& record = records[record_index];
+    for (ReactantClassAndSlot& item: record) {
+      if (item.reactant_class_id == reactant_class_id) {
+        item.slot = slot;
+        return;
+      }
+    }
+    record.push_back(ReactantClassAndSlot{reactant_class_id, slot});
+  }
+
+  // the record of the molecule is kept even when it becomes empty,
+  // it is released by release_molecule
+  void erase(const molecule_id_t id, const BNG::reactant_class_id_t reactant_class_id) {
+    uint record_index = record_index_by_molecule_id.get(id);
+    if (record_index == UINT_INVALID) {
+      return;
+    }
+    ReactantClassAndSlotVector& record = records[record_index];
+    for (uint i = 0; i < record.size(); i++) {
+      if (record[i].reactant_class_id == reactant_class_id) {
+        record[i] = record.back();
+        record.pop_back();
+        return;
+      }
+    }
+  }
+
+  // called when a molecule was removed from the partition
+  void release_molecule(const molecule_id_t id) {
+    uint record_index = record_index_by_molecule_id.get(id);
+    if (record_index == UINT_INVALID) {
+      return;
+    }
+    records[record_index].clear();
+    free_record_indices.push_back(record_index);
+    record_index_by_molecule_id.erase(id);
+  }
+
+  // set may be called concurrently only for molecules with ids lower than num_ids
+  void reserve_molecule_ids(const molecule_id_t num_ids) {
+    record_index_by_molecule_id.reserve(num_ids);
+  }
+
+  void release_unused_memory() {
+    record_index_by_molecule_id.release_empty_pages();
+  }
+
+private:
+  struct ReactantClassAndSlot {
+    BNG::reactant_class_id_t reactant_class_id;
+    uint slot;
+  };
+  typedef boost::container::small_vector<ReactantClassAndSlot, 2> ReactantClassAndSlotVector;
+
+  uint allocate_record() {
+    if (!free_record_indices.empty()) {
+      uint res = free_record_indices.back();
+      free_record_indices.pop_back();
+      return res;
+    }
+    records.push_back(ReactantClassAndSlotVector());
+    return records.size() - 1;
+  }
+
+  // UINT_INVALID if the molecule has no record
+  SparseIdMap<uint, UINT_INVALID> record_index_by_molecule_id;
+
+  // reactant classes and slots of a single molecule
+  std::vector<ReactantClassAndSlotVector> records;
+  std::vector<uint> free_record_indices;
+};
+
+
+// class used to hold potential reactants of given reactant class in each subpart
+// performance critical, ids of molecules in a subpart are stored in a contiguous array
+// so that iterating over them is a linear scan, a molecule is removed by moving the last
+// id of the array into its slot, the shared ReactantSlotMap provides the position of each molecule
+//
+// ids are stored per cell of SubpartCells, when a cell covers multiple subparts,
+// all methods that take a subpart index operate on all molecules of its cell
 class SubpartReactantsSet {
 public:
-  SubpartReactantsSet(const uint num_subparts) {
-    sets_per_subpart.resize(num_subparts, nullptr);
+  // cells and slots may be nullptr only for an empty set that is never modified
+  SubpartReactantsSet(
+      const SubpartCells* cells_, ReactantSlotMap* slots_, const BNG::reactant_class_id_t reactant_class_id_)
+    : cells(cells_), slots(slots_), reactant_class_id(reactant_class_id_) {
+    if (cells != nullptr) {
+      ids_per_cell.resize(cells->get_num_cells());
+    }
   }
 
   ~SubpartReactantsSet() {
-    for (MoleculeIdsSet* s: sets_per_subpart) {
-      // check for nullptr is really not needed, mainly to show that
-      // some items are not allocated
-      if (s != nullptr) {
-        delete s;
+    // the shared map must not keep slots of a removed reactant class
+    if (slots != nullptr) {
+      for (const MoleculeIdsVector& ids: ids_per_cell) {
+        for (molecule_id_t id: ids) {
+          slots->erase(id, reactant_class_id);
+        }
       }
     }
   }
 
   // subpart must exist
   void erase_existing(const subpart_index_t subpart_index, const molecule_id_t id) {
-    assert(subpart_index < sets_per_subpart.size());
-    assert(sets_per_subpart[subpart_index] != nullptr);
-    sets_per_subpart[subpart_index]->erase_existing(id);
+    assert(contains(subpart_index, id));
+    erase_from_slot(get_cell_index(subpart_index), id);
   }
 
   void erase(const subpart_index_t subpart_index, const molecule_id_t id) {
-    assert(subpart_index < sets_per_subpart.size());
-    if (sets_per_subpart[subpart_index] == nullptr) {
+    if (!contains(subpart_index, id)) {
       return;
     }
-    sets_per_subpart[subpart_index]->erase(id);
+    erase_from_slot(get_cell_index(subpart_index), id);
   }
 
-  // key is created if it does not exist
+  // molecule must not be present
   void insert_unique(const subpart_index_t subpart_index, const molecule_id_t id) {
-    assert(subpart_index < sets_per_subpart.size());
-    allocate_set_if_needed(subpart_index);
-    sets_per_subpart[subpart_index]->insert_unique(id);
+    assert(!contains(subpart_index, id));
+    append(get_cell_index(subpart_index), id);
   }
 
   void insert(const subpart_index_t subpart_index, const molecule_id_t id) {
-    assert(subpart_index < sets_per_subpart.size());
-    allocate_set_if_needed(subpart_index);
-    sets_per_subpart[subpart_index]->insert(id);
+    if (contains(subpart_index, id)) {
+      return;
+    }
+    append(get_cell_index(subpart_index), id);
   }
 
   bool contains(const subpart_index_t subpart_index, const molecule_id_t id) const {
-    assert(subpart_index < sets_per_subpart.size());
-    if (sets_per_subpart[subpart_index] == nullptr) {
-      return false;
-    }
-    return sets_per_subpart[subpart_index]->count(id) != 0;
+    uint slot = slots->get(id, reactant_class_id);
+    const MoleculeIdsVector& ids = ids_per_cell[get_cell_index(subpart_index)];
+    return slot < ids.size() && ids[slot] == id;
   }
 
-  const MoleculeIdsSet& get_contained_set(const subpart_index_t subpart_index) const {
+  // returns ids of all molecules in the cell that contains this subpart
+  const MoleculeIdsVector& get_contained_ids(const subpart_index_t subpart_index) const {
     // when calling this method, this container may be empty, i.e. initialized with 0 subparts
-    if (subpart_index >= sets_per_subpart.size() || sets_per_subpart[subpart_index] == nullptr) {
-      return empty_set;
+    if (ids_per_cell.empty()) {
+      return empty_ids;
     }
     else {
-      return *sets_per_subpart[subpart_index];
+      return ids_per_cell[get_cell_index(subpart_index)];
     }
   }
 
   void clear_set(const subpart_index_t subpart_index) {
-    assert(subpart_index < sets_per_subpart.size());
-    if (sets_per_subpart[subpart_index] == nullptr) {
-      return;
+    MoleculeIdsVector& ids = ids_per_cell[get_cell_index(subpart_index)];
+    for (molecule_id_t id: ids) {
+      slots->erase(id, reactant_class_id);
+    }
+    // release memory
+    MoleculeIdsVector().swap(ids);
+  }
+
+  // must be called when cells changed, get_subpart_index provides the subpart under which
+  // a molecule id should be stored
+  template<class GetSubpartIndex>
+  void rebuild_cells(const GetSubpartIndex& get_subpart_index) {
+    assert(cells != nullptr);
+    std::vector<MoleculeIdsVector> old_ids_per_cell;
+    old_ids_per_cell.swap(ids_per_cell);
+    ids_per_cell.resize(cells->get_num_cells());
+
+    for (const MoleculeIdsVector& ids: old_ids_per_cell) {
+      for (molecule_id_t id: ids) {
+        slots->erase(id, reactant_class_id);
+        append(get_cell_index(get_subpart_index(id)), id);
+      }
     }
-    delete sets_per_subpart[subpart_index];
-    sets_per_subpart[subpart_index] = nullptr;
   }
 
-private:
-  void allocate_set_if_needed(const subpart_index_t subpart_index) {
-    assert(subpart_index < sets_per_subpart.size());
-    if (sets_per_subpart[subpart_index] == nullptr) {
-      sets_per_subpart[subpart_index] = new MoleculeIdsSet();
+  // reorders ids in each cell, comp is a less-than comparator of molecule ids
+  template<class Compare>
+  void sort_ids(const Compare& comp) {
+    for (MoleculeIdsVector& ids: ids_per_cell) {
+      if (ids.size() < 2) {
+        continue;
+      }
+      std::sort(ids.begin(), ids.end(), comp);
+      for (uint slot = 0; slot < ids.size(); slot++) {
+        slots->set(ids[slot], reactant_class_id, slot);
+      }
     }
   }
 
-  // vector is indexed by subpart_index_t
-  std::vector<MoleculeIdsSet*> sets_per_subpart;
+private:
+  uint get_cell_index(const subpart_index_t subpart_index) const {
+    assert(cells != nullptr);
+    uint cell_index = cells->get_cell_index(subpart_index);
+    assert(cell_index < ids_per_cell.size());
+    return cell_index;
+  }
+
+  void append(const uint cell_index, const molecule_id_t id) {
+    // a molecule may be present only in a single cell
+    assert(slots->get(id, reactant_class_id) == UINT_INVALID);
+
+    MoleculeIdsVector& ids = ids_per_cell[cell_index];
+    slots->set(id, reactant_class_id, ids.size());
+    ids.push_back(id);
+  }
+
+  void erase_from_slot(const uint cell_index, const molecule_id_t id) {
+    MoleculeIdsVector& ids = ids_per_cell[cell_index];
+    uint slot = slots->get(id, reactant_class_id);
+    assert(slot < ids.size() && ids[slot] == id);
+
+    molecule_id_t last_id = ids.back();
+    ids[slot] = last_id;
+    slots->set(last_id, reactant_class_id, slot);
+    ids.pop_back();
+
+    slots->erase(id, reactant_class_id);
+  }
+
+  // owned by Partition
+  const SubpartCells* cells;
+
+  // shared by all reactant classes, owned by ReactantClassSubpartReactantsSet,
+  // provides index into ids_per_cell[cell] where the molecule is stored
+  ReactantSlotMap* slots;
 
-  MoleculeIdsSet empty_set;
+  BNG::reactant_class_id_t reactant_class_id;
+
+  // vector is indexed by cell index
+  std::vector<MoleculeIdsVector> ids_per_cell;
+
+  MoleculeIdsVector empty_ids;
 };
 
 
 // container that holds SubpartReactantsSet for each species
 class ReactantClassSubpartReactantsSet {
 public:
-  ReactantClassSubpartReactantsSet(const uint num_subparts_) :
-    empty_subpart_reactants_set(0),
-    num_subparts(num_subparts_) {
+  ReactantClassSubpartReactantsSet(const SubpartCells* cells_) :
+    empty_subpart_reactants_set(nullptr, nullptr, BNG::REACTANT_CLASS_ID_INVALID),
+    cells(cells_) {
   }
 
   ~ReactantClassSubpartReactantsSet() {
@@ -158,11 +353,45 @@ public:
       subparts_reactant_sets_per_reactant_class.resize(id + 1, nullptr);
     }
     if (subparts_reactant_sets_per_reactant_class[id] == nullptr) {
-      subparts_reactant_sets_per_reactant_class[id] = new SubpartReactantsSet(num_subparts);
+      subparts_reactant_sets_per_reactant_class[id] = new SubpartReactantsSet(cells, &slots, id);
     }
     return *subparts_reactant_sets_per_reactant_class[id];
   }
 
+  // insert and erase may be called concurrently for disjoint subparts
+  // only for molecules with ids lower than num_ids
+  void reserve_molecule_ids(const molecule_id_t num_ids) {
+    slots.reserve_molecule_ids(num_ids);
+  }
+
+  // called when a molecule was removed from the partition,
+  // it must not be present in any set
+  void release_molecule(const molecule_id_t id) {
+    slots.release_molecule(id);
+  }
+
+  void release_unused_memory() {
+    slots.release_unused_memory();
+  }
+
+  template<class Compare>
+  void sort_ids(const Compare& comp) {
+    for (SubpartReactantsSet* subpart_sets: subparts_reactant_sets_per_reactant_class) {
+      if (subpart_sets != nullptr) {
+        subpart_sets->sort_ids(comp);
+      }
+    }
+  }
+
+  template<class GetSubpartIndex>
+  void rebuild_cells(const GetSubpartIndex& get_subpart_index) {
+    for (SubpartReactantsSet* subpart_sets: subparts_reactant_sets_per_reactant_class) {
+      if (subpart_sets != nullptr) {
+        subpart_sets->rebuild_cells(get_subpart_index);
+      }
+    }
+  }
+
   const SubpartReactantsSet& get_subparts_reactants_for_reactant_class(const BNG::reactant_class_id_t id) const {
     if (id >= subparts_reactant_sets_per_reactant_class.size() ||
         subparts_reactant_sets_per_reactant_class[id] == nullptr) {
@@ -180,12 +409,16 @@ private:
 
   SubpartReactantsSet empty_subpart_reactants_set;
 
-  // used when constructing SubpartReactantsSet
-  uint num_subparts;
+  // used when constructing SubpartReactantsSet, owned by Partition
+  const SubpartCells* cells;
+
+  // shared by all SubpartReactantsSets
+  ReactantSlotMap slots;
 };
 
 
-struct Waypoint {
+// aligned so that a waypoint in the waypoints array never spans two cache lines
+struct alignas(32) Waypoint {
   Vec3 pos;
   counted_volume_index_t counted_volume_index;
 };
@@ -200,6 +433,7 @@ public:
   Partition(
       const partition_id_t id_,
       const Vec3& origin_corner_,
+      molecule_id_t& next_molecule_id_,
       const SimulationConfig& config_,
       BNG::BNGEngine& bng_engine_,
       SimulationStats& stats_
@@ -209,40 +443,39 @@ public:
 
   Molecule& get_m(const molecule_id_t id) {
     assert(id != MOLECULE_ID_INVALID);
-    assert(id < molecule_id_to_index_mapping.size());
 
     // code works with molecule ids, but they need to be converted to indices to the volume_molecules vector
     // because we need to defragment the contents
-    molecule_index_t vm_vec_index = molecule_id_to_index_mapping[id];
+    molecule_index_t vm_vec_index = molecule_id_to_index_mapping.get(id);
     assert(vm_vec_index != MOLECULE_INDEX_INVALID);
     return molecules[vm_vec_index];
   }
 
   const Molecule& get_m(const molecule_id_t id) const {
     assert(id != MOLECULE_ID_INVALID);
-    assert(id < molecule_id_to_index_mapping.size());
 
     // code works with molecule ids, but they need to be converted to indices to the volume_molecules vector
     // because we need to defragment the contents
-    molecule_index_t vm_vec_index = molecule_id_to_index_mapping[id];
+    molecule_index_t vm_vec_index = molecule_id_to_index_mapping.get(id);
     assert(vm_vec_index != MOLECULE_INDEX_INVALID);
     return molecules[vm_vec_index];
   }
 
-  void get_molecules_ready_for_diffusion(MoleculeIdsVector& ready_vector) const {
-    // select all molecules that are scheduled for this iteration and are not defunct
-    ready_vector.clear();
-    double time_it_end = stats.get_current_iteration() + 1;
+  // selects all molecules that are scheduled for this iteration and are not defunct,
+  // in the order of schedulable_molecule_ids
+  void get_molecules_ready_for_diffusion(MoleculeIdsVector& ready_vector);
 
-    for (molecule_id_t id: schedulable_molecule_ids) {
-      const Molecule& m = get_m(id);
-      assert(!m.has_flag(MOLECULE_FLAG_NO_NEED_TO_SCHEDULE));
-      // new products may have been scheduled for the previous iteration
-      if (!m.is_defunct() &&
-          cmp_lt(m.diffusion_time, time_it_end, EPS)) {
-        ready_vector.push_back(m.id);
-      }
-    }
+  // first iteration after the current one in which a molecule may be ready for diffusion,
+  // ITERATION_NEVER if there is no such molecule
+  uint64_t get_next_diffusion_check_iteration() const {
+    return diffusion_calendar.get_next_iteration_to_check(
+        stats.get_current_iteration(), schedulable_molecule_ids.size());
+  }
+
+  // must be called when schedulable_molecule_ids is reordered or shrunk or when diffusion time
+  // of molecules is changed outside of their diffusion, see DiffusionCalendar
+  void reset_diffusion_calendar() {
+    diffusion_calendar.reset();
   }
 
   bool in_this_partition(const Vec3& pos) const {
@@ -250,6 +483,17 @@ public:
       && glm::all(glm::lessThan(pos, opposite_corner));
   }
 
+  const NeighborSubpartOffsets& get_neighbor_subpart_offsets(const uint zone_index) const {
+    assert(zone_index < NUM_SUBPART_ZONES);
+    return neighbor_subpart_offsets_per_zone[zone_index];
+  }
+
+  // reused by ray_trace_vol so that duplicate subparts are found using stamps,
+  // must be cleared before use
+  SubpartIndicesOrderedSet& get_crossed_subparts_for_molecules() {
+    return crossed_subparts_for_molecules;
+  }
+
   bool is_subpart_index_in_range(const int index) const {
     return index >= 0 && index < (int)config.num_subparts_per_partition_edge;
   }
@@ -403,6 +647,24 @@ public:
   }
 
 
+  // creates all data that update_molecule_reactants_map uses for molecules of this species,
+  // afterwards, update_molecule_reactants_map may be called concurrently for molecules
+  // that move within disjoint sets of subpartitions
+  void prepare_reactants_map_for_concurrent_updates(const species_id_t species_id) {
+    BNG::Species& species = get_species(species_id);
+    if (!species.has_bimol_vol_rxn()) {
+      return;
+    }
+
+    const BNG::ReactantClassIdSet& reacting_classes = get_all_rxns().get_reacting_classes(species);
+    for (const BNG::reactant_class_id_t reacting_class_id: reacting_classes) {
+      if (!get_all_rxns().get_reactant_class(reacting_class_id).target_only) {
+        volume_molecule_reactants_per_reactant_class.get_subparts_reactants_for_reactant_class(reacting_class_id);
+      }
+    }
+    volume_molecule_reactants_per_reactant_class.reserve_molecule_ids(next_molecule_id);
+  }
+
   void update_molecule_reactants_map(Molecule& vm) {
     assert(vm.v.subpart_index < config.num_subparts);
     assert(vm.v.reactant_subpart_index < config.num_subparts);
@@ -424,27 +686,28 @@ public:
 private:
   // internal methods that sets molecule's id and adds it to all relevant structures,
   // do not use species-id here because it may change
-  Molecule& add_molecule(const Molecule& m_copy, const bool is_vol, const double release_delay_time) {
+  // is_in_schedulable_list is set to true when the molecule reuses the defunct slot of its
+  // previous copy whose id is still in schedulable_molecule_ids
+  Molecule& add_molecule(
+      const Molecule& m_copy, const bool is_vol, const double release_delay_time,
+      bool& is_in_schedulable_list) {
 #ifndef NDEBUG
     const BNG::Species& species = get_species(m_copy.species_id);
     assert((is_vol && species.is_vol()) || (!is_vol && species.is_surf()));
 #endif
 
+    is_in_schedulable_list = false;
     if (m_copy.id == MOLECULE_ID_INVALID) {
-      // assign new ID, in theory, molecule IDs should be assigned by World, but this
-      // is a common operation and some decentralized solution is needed
+      // assign new ID, the counter is owned by World and shared by all partitions
+      // so that molecule ids are unique in the whole simulation
       molecule_id_t molecule_id = next_molecule_id;
       next_molecule_id++;
 
-      // We always have to increase the size of the mapping array - its size is
-      // large enough to hold ids for all molecules that were ever created,
-      // we will need to reuse ids or compress it later
+      // ids are never reused, the mapping releases pages of ids of removed molecules
+      // during defragmentation so its size is proportional to the number of live molecules,
+      // ids created by other partitions are not present in this partition
       molecule_index_t next_molecule_index = molecules.size(); // get the index of the molecule we are going to store
-      molecule_id_to_index_mapping.push_back(next_molecule_index);
-      assert(
-          molecule_id_to_index_mapping.size() == next_molecule_id
-          && "Mapping array must have value for every molecule index"
-      );
+      molecule_id_to_index_mapping.set(molecule_id, next_molecule_index);
 
       // This is the only place where we insert molecules into volume_molecules,
       // although this array size can be decreased in defragmentation
@@ -461,26 +724,31 @@ private:
       return new_m;
     }
     else {
-      // this is a checkpointed molecule
+      // this is a checkpointed or migrated molecule
 
       // update the next molecule id counter
       if (m_copy.id >= next_molecule_id) {
         next_molecule_id = m_copy.id + 1;
       }
 
-      // set its index in the molecule_id_to_index_mapping array
-      // its id must be at the position
-      uint32_t next_molecule_array_index = molecules.size(); // get the index of the molecule we are going to store
-
-      if (m_copy.id >= molecule_id_to_index_mapping.size()) {
-        // insert invalid indices up to the index specified by id
-        molecule_id_to_index_mapping.insert(
-            molecule_id_to_index_mapping.end(),
-            m_copy.id + 1 - molecule_id_to_index_mapping.size(),
-            MOLECULE_INDEX_INVALID
-        );
+      // a molecule that migrated back into this partition before defragmentation removed
+      // its defunct copy takes over the copy's slot so that a single slot and a single
+      // entry in schedulable_molecule_ids belongs to each id
+      molecule_index_t defunct_index = molecule_id_to_index_mapping.get(m_copy.id);
+      if (defunct_index != MOLECULE_INDEX_INVALID) {
+        Molecule& revived_m = molecules[defunct_index];
+        assert(revived_m.is_defunct());
+        is_in_schedulable_list = !revived_m.has_flag(MOLECULE_FLAG_NO_NEED_TO_SCHEDULE);
+        revived_m = m_copy;
+
+        // the calendar forgot the position when it found the copy defunct
+        diffusion_calendar.reset();
+        return revived_m;
       }
-      molecule_id_to_index_mapping[m_copy.id] = next_molecule_array_index;
+
+      // set its index in the molecule_id_to_index_mapping
+      uint32_t next_molecule_array_index = molecules.size(); // get the index of the molecule we are going to store
+      molecule_id_to_index_mapping.set(m_copy.id, next_molecule_array_index);
 
       // and append it to the molecules array
       molecules.push_back(m_copy);
@@ -490,7 +758,8 @@ private:
     }
   }
 
-  void update_species_for_new_molecule_and_add_to_schedulable_list(Molecule& m) {
+  void update_species_for_new_molecule_and_add_to_schedulable_list(
+      Molecule& m, const bool is_in_schedulable_list) {
     // make sure that the rxn for this species flags are up-to-date
     BNG::Species& sp = get_species(m.species_id);
     if (!sp.are_rxn_and_custom_flags_uptodate()) {
@@ -500,6 +769,7 @@ private:
       // update rxn classes for this new species, may create new species and
       // invalidate Species reference
       get_all_rxns().get_bimol_rxns_for_reactant(sp.id);
+      species_pair_rxn_class_cache.add_species(m.species_id);
     }
     // we must get a new reference
     get_species(m.species_id).inc_num_instantiations();
@@ -507,7 +777,7 @@ private:
     // also set a flag used for optimization
     m.set_no_need_to_schedule_flag(bng_engine.get_all_species());
 
-    if (!m.has_flag(MOLECULE_FLAG_NO_NEED_TO_SCHEDULE)) {
+    if (!m.has_flag(MOLECULE_FLAG_NO_NEED_TO_SCHEDULE) && !is_in_schedulable_list) {
       schedulable_molecule_ids.push_back(m.id);
     }
   }
@@ -527,6 +797,42 @@ private:
     }
   }
 
+  void inc_vol_mol_count(const species_id_t species_id, const counted_volume_index_t counted_volume_index) {
+    if (species_id >= vol_mol_counts_per_counted_volume.size()) {
+      vol_mol_counts_per_counted_volume.resize(species_id + 1);
+    }
+    vol_mol_counts_per_counted_volume[species_id][counted_volume_index]++;
+  }
+
+  void dec_vol_mol_count(const species_id_t species_id, const counted_volume_index_t counted_volume_index) {
+    assert(species_id < vol_mol_counts_per_counted_volume.size());
+    CountInGeomObjectMap& counts = vol_mol_counts_per_counted_volume[species_id];
+    auto it = counts.find(counted_volume_index);
+    assert(it != counts.end() && it->second > 0);
+    it->second--;
+    if (it->second == 0) {
+      counts.erase(it);
+    }
+  }
+
+  void inc_surf_mol_count(const species_id_t species_id, const wall_index_t wall_index) {
+    if (species_id >= surf_mol_counts_per_wall.size()) {
+      surf_mol_counts_per_wall.resize(species_id + 1);
+    }
+    surf_mol_counts_per_wall[species_id][wall_index]++;
+  }
+
+  void dec_surf_mol_count(const species_id_t species_id, const wall_index_t wall_index) {
+    assert(species_id < surf_mol_counts_per_wall.size());
+    CountOnWallMap& counts = surf_mol_counts_per_wall[species_id];
+    auto it = counts.find(wall_index);
+    assert(it != counts.end() && it->second > 0);
+    it->second--;
+    if (it->second == 0) {
+      counts.erase(it);
+    }
+  }
+
   void update_volume_compartment(Molecule& new_vm) {
     const BNG::Species& species = get_species(new_vm.species_id);
      BNG::compartment_id_t target_compartment_id = get_compartment_id_for_counted_volume(new_vm.v.counted_volume_index);
@@ -563,7 +869,8 @@ public:
     }
 
     // add a new molecule
-    Molecule& new_vm = add_molecule(vm_copy, true, release_delay_time);
+    bool is_in_schedulable_list;
+    Molecule& new_vm = add_molecule(vm_copy, true, release_delay_time, is_in_schedulable_list);
 
     // set subpart indices for vol-vol rxn handling
     new_vm.v.subpart_index = get_subpart_index(new_vm.v.pos);
@@ -579,7 +886,7 @@ public:
 
     // make sure that the rxn for this species flags are up-to-date and
     // increment number of instantiations of this species
-    update_species_for_new_molecule_and_add_to_schedulable_list(new_vm);
+    update_species_for_new_molecule_and_add_to_schedulable_list(new_vm, is_in_schedulable_list);
 
     // TODO: use Species::is_instantiated instead of the known_vol_species
     if (known_vol_species.count(new_vm.species_id) == 0) {
@@ -593,18 +900,23 @@ public:
     // might invalidate species references
     change_vol_reactants_map_from_orig_to_current(new_vm, true, false);
 
+    inc_vol_mol_count(new_vm.species_id, new_vm.v.counted_volume_index);
+
     return new_vm;
   }
 
   Molecule& add_surface_molecule(const Molecule& sm_copy, const double release_delay_time = 0) {
     assert(sm_copy.is_surf() && sm_copy.s.wall_index != WALL_INDEX_INVALID);
 
-    Molecule& new_sm = add_molecule(sm_copy, false, release_delay_time);
+    bool is_in_schedulable_list;
+    Molecule& new_sm = add_molecule(sm_copy, false, release_delay_time, is_in_schedulable_list);
 
     // set compartment if needed
     update_surface_compartment(new_sm);
 
-    update_species_for_new_molecule_and_add_to_schedulable_list(new_sm);
+    update_species_for_new_molecule_and_add_to_schedulable_list(new_sm, is_in_schedulable_list);
+
+    inc_surf_mol_count(new_sm.species_id, new_sm.s.wall_index);
 
     return new_sm;
   }
@@ -613,6 +925,13 @@ public:
     // set that this molecule does not exist anymore
     m.set_is_defunct();
 
+    if (m.is_vol()) {
+      dec_vol_mol_count(m.species_id, m.v.counted_volume_index);
+    }
+    else {
+      dec_surf_mol_count(m.species_id, m.s.wall_index);
+    }
+
     BNG::Species& sp = get_species(m.species_id);
     sp.dec_num_instantiations();
 
@@ -638,11 +957,13 @@ public:
     return opposite_corner;
   }
 
-  const MoleculeIdsSet& get_volume_molecule_reactants(subpart_index_t subpart_index, species_id_t species_id) const {
+  // returns reactants in the whole cell that contains this subpart,
+  // see get_subpart_cells
+  const MoleculeIdsVector& get_volume_molecule_reactants(subpart_index_t subpart_index, species_id_t species_id) const {
     assert(subpart_index < config.num_subparts);
     const BNG::Species& species = get_species(species_id);
     return volume_molecule_reactants_per_reactant_class.
-        get_subparts_reactants_for_reactant_class(species.get_reactant_class_id()).get_contained_set(subpart_index);
+        get_subparts_reactants_for_reactant_class(species.get_reactant_class_id()).get_contained_ids(subpart_index);
   }
 
   const std::vector<Molecule>& get_molecules() const {
@@ -653,18 +974,33 @@ public:
     return molecules;
   }
   
-  std::vector<molecule_index_t>& get_molecule_id_to_index_mapping() {
+  MoleculeIdToIndexMap& get_molecule_id_to_index_mapping() {
     return molecule_id_to_index_mapping;
   }
 
-  const std::vector<molecule_index_t>& get_molecule_id_to_index_mapping() const {
+  const MoleculeIdToIndexMap& get_molecule_id_to_index_mapping() const {
     return molecule_id_to_index_mapping;
   }
 
+  // called in defragmentation for each removed molecule
+  void release_reactant_slots(const molecule_id_t id) {
+    volume_molecule_reactants_per_reactant_class.release_molecule(id);
+  }
+
+  // called after defragmentation, releases memory used for ids of removed molecules
+  void release_unused_id_mapping_memory() {
+    molecule_id_to_index_mapping.release_empty_pages();
+    volume_molecule_reactants_per_reactant_class.release_unused_memory();
+  }
+
   std::vector<molecule_index_t>& get_schedulable_molecule_ids() {
     return schedulable_molecule_ids;
   }
 
+  const std::vector<molecule_index_t>& get_schedulable_molecule_ids() const {
+    return schedulable_molecule_ids;
+  }
+
   // ---------------------------------- geometry ----------------------------------
   vertex_index_t add_geometry_vertex(const Vec3 pos) {
     vertex_index_t index = geometry_vertices.size();
@@ -726,8 +1062,13 @@ public:
 
   // when a wall is added with add_uninitialized_wall,
   // its type and vertices are not know yet, we must include the walls
-  // into subpartitions and also for other purposes
-  void finalize_walls();
+  // into subpartitions and also for other purposes,
+  // the wall-subpartition collision tests are done in parallel when thread_pool is not nullptr
+  void finalize_walls(ThreadPool* thread_pool = nullptr);
+
+  // used when multiple partitions are used, all partitions contain the same geometry
+  // with the same indices, walls are assigned to this partition's subpartitions
+  void copy_geometry_from(const Partition& src, ThreadPool* thread_pool = nullptr);
 
   // returns reference to the new object, only sets id
   GeometryObject& add_uninitialized_geometry_object(const geometry_object_id_t id) {
@@ -886,8 +1227,37 @@ public:
   }
 
   // maybe we will need to filter out, e.g. just reflective surfaces
+  // returns walls in the whole cell that contains this subpart, see get_subpart_cells
   const WallsInSubpart& get_subpart_wall_indices(const subpart_index_t subpart_index) const {
-    return walls_per_subpart[subpart_index];
+    return walls_per_subpart[subpart_cells.get_cell_index(subpart_index)];
+  }
+
+  // same walls as get_subpart_wall_indices, packed for batched collision rejection
+  const SubpartWallBatch& get_subpart_wall_batch(const subpart_index_t subpart_index) const {
+    uint cell_index = subpart_cells.get_cell_index(subpart_index);
+    assert(cell_index < wall_batches_per_subpart.size());
+    return wall_batches_per_subpart[cell_index];
+  }
+
+  // subpartitions that share a cell also share their walls and reactants
+  const SubpartCells& get_subpart_cells() const {
+    return subpart_cells;
+  }
+
+  // rebuilds cells of the adaptive octree from the current molecule and wall
+  // occupancy of subpartitions, used only with config.use_adaptive_subparts
+  void rebalance_subpart_cells();
+
+  // built only when config.use_wall_bvh is set
+  const WallBvh& get_wall_bvh() const {
+    return wall_bvh;
+  }
+
+  // number of layers of subpartitions around this subpart that contain no walls
+  // and are all in this partition, -1 when the subpart itself contains a wall
+  int get_wall_free_radius(const subpart_index_t subpart_index) const {
+    assert(subpart_index < wall_free_radius_per_subpart.size());
+    return wall_free_radius_per_subpart[subpart_index];
   }
 
   // returns nullptr if either the wall does not exist or the wall's grid was not initialized
@@ -925,8 +1295,9 @@ public:
       std::vector<VertexMoveInfo*>& vertex_moves_due_to_paired_molecules);
 
 
+  // aux_rng is used when rng is nullptr
   void move_waypoint_because_positioned_on_wall(
-      const IVec3& waypoint_index, const bool reinitialize = true
+      const IVec3& waypoint_index, const bool reinitialize = true, rng_state* rng = nullptr
   );
 
   WallSharedData* create_wall_shared_data() {
@@ -969,6 +1340,10 @@ private:
       const WallsWithTheirMovesMap& walls_with_their_moves, const bool insert
   );
 
+  void update_wall_free_radius_per_subpart();
+
+  void init_neighbor_subpart_offsets();
+
   // automatically enlarges walls_using_vertex array
   void add_wall_using_vertex_mapping(vertex_index_t vertex_index, wall_index_t wall_index) {
     if (vertex_index >= walls_using_vertex_mapping.size()) {
@@ -977,11 +1352,28 @@ private:
     walls_using_vertex_mapping[vertex_index].push_back(wall_index);
   }
 
-  void initialize_waypoint(
+  // aux_rng is used when rng is nullptr and stats are used when thread_stats is nullptr,
+  // when deferred_counted_volume is not nullptr and the counted volume must be computed
+  // from scratch, this partition is not modified, objects that contain the waypoint are stored into
+  // deferred_counted_volume, waypoint's counted_volume_index is set to COUNTED_VOLUME_INDEX_INVALID
+  // and true is returned, such waypoint may be then copied by the next waypoint in its line
+  bool initialize_waypoint(
       const IVec3& waypoint_index,
       const bool use_previous_waypoint,
       const IVec3& previous_waypoint_index,
-      const bool keep_pos = false
+      const bool keep_pos = false,
+      rng_state* rng = nullptr,
+      CountedVolume* deferred_counted_volume = nullptr,
+      SimulationStats* thread_stats = nullptr
+  );
+
+  // initializes all waypoints with the given x index, see initialize_waypoint for the arguments
+  void initialize_waypoints_slab(
+      const uint x,
+      rng_state* rng = nullptr,
+      std::vector<CountedVolume>* deferred_counted_volumes = nullptr,
+      std::vector<uint8_t>* is_deferred = nullptr,
+      SimulationStats* thread_stats = nullptr
   );
 
 public:
@@ -996,33 +1388,63 @@ public:
   BNG::RxnContainer& get_all_rxns() { return bng_engine.get_all_rxns(); }
   const BNG::RxnContainer& get_all_rxns() const { return bng_engine.get_all_rxns(); }
 
+  // used only with config.use_rxn_pathway_alias_tables
+  RxnPathwayAliasTables& get_rxn_pathway_alias_tables() { return rxn_pathway_alias_tables; }
+
+  // cached variant of RxnContainer::get_bimol_rxn_class for species of existing molecules
+  BNG::RxnClass* get_bimol_rxn_class(const species_id_t species_id1, const species_id_t species_id2) {
+    return species_pair_rxn_class_cache.get_bimol_rxn_class(get_all_rxns(), species_id1, species_id2);
+  }
+
+  // must be called when rxn classes or species are removed or when rxn rates are changed from outside
+  void clear_rxn_class_caches() {
+    rxn_pathway_alias_tables.clear();
+    species_pair_rxn_class_cache.clear();
+  }
+
   // ---------------------------------- counting ----------------------------------
 
   // returns counted volume index for this position,
   counted_volume_index_t compute_counted_volume_from_scratch(const Vec3& pos);
   counted_volume_index_t compute_counted_volume_using_waypoints(const Vec3& pos);
 
-  void initialize_all_waypoints();
+  // slabs of waypoints are initialized in parallel when thread_pool is not nullptr,
+  // the result does not depend on the number of threads but differs from the serial variant
+  // in the random displacements of waypoints positioned on walls
+  void initialize_all_waypoints(ThreadPool* thread_pool = nullptr);
+
+  // waypoints must be already initialized, used only with config.use_counted_volume_voxels
+  void initialize_counted_volume_voxels() {
+    counted_volume_voxels.build(*this);
+  }
+
+  const CountedVolumeVoxels& get_counted_volume_voxels() const {
+    return counted_volume_voxels;
+  }
 
 
   bool is_valid_waypoint_index(const IVec3& index3d) const {
+    int n = config.num_subparts_per_partition_edge;
     return
-        index3d.x >= 0 &&
-        index3d.x < (int)waypoints.size() &&
-        index3d.y >= 0 &&
-        index3d.y < (int)waypoints[index3d.x].size() &&
-        index3d.z >= 0 &&
-        index3d.z < (int)waypoints[index3d.x][index3d.y].size();
+        !waypoints.empty() &&
+        index3d.x >= 0 && index3d.x < n &&
+        index3d.y >= 0 && index3d.y < n &&
+        index3d.z >= 0 && index3d.z < n;
   }
 
   Waypoint& get_waypoint(const IVec3& index3d) {
     assert(is_valid_waypoint_index(index3d));
-    return waypoints[index3d.x][index3d.y][index3d.z];
+    return waypoints[get_waypoint_array_index(index3d)];
   }
 
   const Waypoint& get_waypoint(const IVec3& index3d) const {
     assert(is_valid_waypoint_index(index3d));
-    return waypoints[index3d.x][index3d.y][index3d.z];
+    return waypoints[get_waypoint_array_index(index3d)];
+  }
+
+  uint get_waypoint_array_index(const IVec3& index3d) const {
+    uint n = config.num_subparts_per_partition_edge;
+    return (index3d.x * n + index3d.y) * n + index3d.z;
   }
 
   counted_volume_index_t find_or_add_counted_volume(const CountedVolume& cv);
@@ -1033,6 +1455,40 @@ public:
     return counted_volumes_vector[counted_volume_index];
   }
 
+  // the molecule counts are updated only for molecules that were already added to this partition,
+  // i.e. not for molecule copies that are being initialized
+  void set_counted_volume_index(Molecule& vm, const counted_volume_index_t counted_volume_index) {
+    assert(vm.is_vol());
+    if (vm.id != MOLECULE_ID_INVALID && vm.v.counted_volume_index != counted_volume_index) {
+      assert(&get_m(vm.id) == &vm && "Molecule must be stored in this partition");
+      dec_vol_mol_count(vm.species_id, vm.v.counted_volume_index);
+      inc_vol_mol_count(vm.species_id, counted_volume_index);
+    }
+    vm.v.counted_volume_index = counted_volume_index;
+  }
+
+  void set_surf_mol_wall_index(Molecule& sm, const wall_index_t wall_index) {
+    assert(sm.is_surf());
+    if (sm.id != MOLECULE_ID_INVALID && sm.s.wall_index != wall_index) {
+      assert(&get_m(sm.id) == &sm && "Molecule must be stored in this partition");
+      dec_surf_mol_count(sm.species_id, sm.s.wall_index);
+      inc_surf_mol_count(sm.species_id, wall_index);
+    }
+    sm.s.wall_index = wall_index;
+  }
+
+  // number of volume molecules per counted volume, indexed by species id,
+  // maintained incrementally, may be shorter than the number of species
+  const std::vector<CountInGeomObjectMap>& get_vol_mol_counts_per_counted_volume() const {
+    return vol_mol_counts_per_counted_volume;
+  }
+
+  // number of surface molecules per wall, indexed by species id,
+  // maintained incrementally, may be shorter than the number of species
+  const std::vector<CountOnWallMap>& get_surf_mol_counts_per_wall() const {
+    return surf_mol_counts_per_wall;
+  }
+
   void inc_rxn_in_volume_occured_count(
       const BNG::rxn_rule_id_t rxn_id, const counted_volume_index_t counted_volume_index) {
     assert(rxn_id != BNG::RXN_RULE_ID_INVALID);
@@ -1081,15 +1537,16 @@ public:
 
   void shuffle_schedulable_molecule_ids();
 
+  // orders schedulable molecule ids and ids in reactant sets by the index of molecules
+  // in the molecules array, used after the molecules array was sorted
+  void order_molecule_ids_by_molecule_index();
+
   // ------------ used directly by Pymcell4 API ------------
   bool does_molecule_exist(const molecule_id_t id) {
     if (id == MOLECULE_ID_INVALID) {
       return false;
     }
-    if (id >= molecule_id_to_index_mapping.size()) {
-      return false;
-    }
-    molecule_index_t index = molecule_id_to_index_mapping[id];
+    molecule_index_t index = molecule_id_to_index_mapping.get(id);
     if (index == MOLECULE_INDEX_INVALID) {
       return false;
     }
@@ -1125,15 +1582,20 @@ private:
   std::vector<Molecule> molecules;
 
   // contains mapping of molecule ids to indices to the molecules array
-  std::vector<molecule_index_t> molecule_id_to_index_mapping;
+  MoleculeIdToIndexMap molecule_id_to_index_mapping;
 
   // contains ids of molecules that need to be scheduled for diffusion or unimol rxn
   // execution
   std::vector<molecule_id_t> schedulable_molecule_ids;
 
-  // id of the next molecule to be created
-  // TODO_LATER: move to World
-  molecule_id_t next_molecule_id;
+  // tells which schedulable molecules need to be checked in get_molecules_ready_for_diffusion
+  DiffusionCalendar diffusion_calendar;
+
+  // auxiliary array used in get_molecules_ready_for_diffusion
+  std::vector<uint> schedulable_positions_to_check;
+
+  // id of the next molecule to be created, owned by World and shared by all partitions
+  molecule_id_t& next_molecule_id;
 
   // indexed with species_id
   ReactantClassSubpartReactantsSet volume_molecule_reactants_per_reactant_class;
@@ -1163,9 +1625,29 @@ private:
   // indexed by vertex_index_t
   std::vector< std::vector<wall_index_t>> walls_using_vertex_mapping;
 
-  // indexed by subpartition index, contains a container wall indices (wall_index_t)
+  // maps subpartitions to cells that hold walls and reactants
+  SubpartCells subpart_cells;
+
+  // indexed by zone index, see NeighborSubpartOffsets
+  NeighborSubpartOffsets neighbor_subpart_offsets_per_zone[NUM_SUBPART_ZONES];
+
+  // see get_crossed_subparts_for_molecules
+  SubpartIndicesOrderedSet crossed_subparts_for_molecules;
+
+  // indexed by cell index of subpart_cells, contains a container wall indices (wall_index_t)
   std::vector< WallsInSubpart > walls_per_subpart;
 
+  // indexed by cell index of subpart_cells, must be updated when walls_per_subpart
+  // or wall_collision_rejection_data change
+  std::vector<SubpartWallBatch> wall_batches_per_subpart;
+
+  // alternative to walls_per_subpart used for wall collisions when config.use_wall_bvh is set
+  WallBvh wall_bvh;
+
+  // indexed by subpart_index_t, see get_wall_free_radius,
+  // must be updated when walls move
+  std::vector<int> wall_free_radius_per_subpart;
+
   // ---------------------------------- counting ------------------------------------------
   // - key is rxn rule id and its values are maps that contain current reaction counts for each
   //   counted volume or wall
@@ -1175,6 +1657,12 @@ private:
   std::map< BNG::rxn_rule_id_t, CountInGeomObjectMap > rxn_counts_per_counted_volume;
   std::map< BNG::rxn_rule_id_t, CountOnWallMap > rxn_counts_per_wall_volume;
 
+  // - indexed by species id, contain only non-zero counts of existing molecules
+  // - updated in add_*_molecule, set_molecule_as_defunct, set_counted_volume_index and
+  //   set_surf_mol_wall_index so that counting does not have to go through all molecules
+  std::vector<CountInGeomObjectMap> vol_mol_counts_per_counted_volume;
+  std::vector<CountOnWallMap> surf_mol_counts_per_wall;
+
   // indexed by counted_volume_index_t
   std::vector<CountedVolume> counted_volumes_vector;
   // set for fast search
@@ -1183,8 +1671,17 @@ private:
 
   std::map<counted_volume_index_t, BNG::compartment_id_t> counted_volume_index_to_compartment_id_cache;
 
-  // indexed by [x][y][z]
-  std::vector< std::vector< std::vector< Waypoint > > > waypoints;
+  // ordered by x, y and z with z changing fastest so that lines of waypoints
+  // processed in initialize_all_waypoints are contiguous, see get_waypoint_array_index
+  std::vector<Waypoint> waypoints;
+
+  // built only when config.use_counted_volume_voxels is set
+  CountedVolumeVoxels counted_volume_voxels;
+
+  // filled lazily when config.use_rxn_pathway_alias_tables is set
+  RxnPathwayAliasTables rxn_pathway_alias_tables;
+
+  SpeciesPairRxnClassCache species_pair_rxn_class_cache;
 
   // bidirectional map -> each pair is added twice
   std::map<molecule_id_t, molecule_id_t> paired_molecules;
@@ -0,0 +1,35 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include <iostream>
+
+#include "rebalance_subpart_cells_event.h"
+#include "world.h"
+#include "partition.h"
+
+using namespace std;
+
+namespace MCell {
+
+void RebalanceSubpartCellsEvent::dump(const string ind) const {
+  cout << ind << "Rebalance subpart cells event:\n";
+  string ind2 = ind + "  ";
+  BaseEvent::dump(ind2);
+}
+
+
+void RebalanceSubpartCellsEvent::step() {
+  for (Partition& p: world->get_partitions()) {
+    p.rebalance_subpart_cells();
+  }
+}
+
+} // namespace MCell
@@ -0,0 +1,42 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_REBALANCE_SUBPART_CELLS_EVENT_H_
+#define SRC4_REBALANCE_SUBPART_CELLS_EVENT_H_
+
+#include "base_event.h"
+
+namespace MCell {
+
+/**
+ * Molecules redistribute during simulation, this event periodically
+ * rebuilds the adaptive octree cells of each partition so that crowded regions
+ * use small cells and empty regions are merged into large cells.
+ */
+class RebalanceSubpartCellsEvent: public BaseEvent {
+public:
+  RebalanceSubpartCellsEvent(World* world_)
+    : BaseEvent(EVENT_TYPE_INDEX_REBALANCE_SUBPART_CELLS),
+      world(world_) {
+  }
+
+  void step() override;
+  void dump(const std::string indent) const override;
+
+  // does not change molecules
+  bool ends_idle_time_skipping() const override { return false; }
+private:
+  World* world;
+};
+
+} // namespace mcell
+
+#endif // SRC4_REBALANCE_SUBPART_CELLS_EVENT_H_
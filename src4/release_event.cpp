@@ -470,17 +470,18 @@ bool ReleaseEvent::initialize_walls_for_release() {
     return true;
   }
 
-  // only a single partition for now
+  // all partitions have the same geometry
   const Partition& p = world->get_partition(PARTITION_ID_INITIAL);
   set<wall_index_t> wall_for_release;
   get_walls_for_release_recursively(p, region_expr.root, wall_for_release);
 
   // assuming that iterating over std::set is ordered
   for (wall_index_t wi: wall_for_release) {
-    const Wall& w = world->get_partition(PARTITION_ID_INITIAL).get_wall(wi);
+    const Wall& w = p.get_wall(wi);
 
     CummAreaPWallIndexPair item;
     item.first = w.area;
+    // surface molecules are supported only with a single partition
     item.second.first = PARTITION_ID_INITIAL;
     item.second.second = wi;
 
@@ -576,11 +577,12 @@ uint ReleaseEvent::calculate_number_to_release() {
 
 // returns the number of actually removed molecules
 int ReleaseEvent::randomly_remove_molecules(
-    Partition& p, const MoleculeIdsVector& mol_ids_in_region, int number_to_remove) {
+    const PartitionMoleculeIdPairsVector& mol_ids_in_region, int number_to_remove) {
   // randomly remove molecules
   int num_removed = 0;
   for (size_t i = 0; i < mol_ids_in_region.size(); i++) {
-    molecule_id_t m_id = mol_ids_in_region[i];
+    Partition& p = world->get_partition(mol_ids_in_region[i].first);
+    molecule_id_t m_id = mol_ids_in_region[i].second;
     int remaining = mol_ids_in_region.size() - i;
 
     if (rng_dbl(&world->rng) < ((double)(number_to_remove)) / ((double)remaining)) {
@@ -606,12 +608,10 @@ int ReleaseEvent::vacuum_from_regions(int number_to_remove) {
   assert(!cumm_area_and_pwall_index_pairs.empty());
   assert(number_to_remove > 0);
 
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
-
-  MoleculeIdsVector mol_ids_on_region;
+  PartitionMoleculeIdPairsVector mol_ids_on_region;
 
   for (auto& item: cumm_area_and_pwall_index_pairs) {
-    assert(item.second.first == PARTITION_ID_INITIAL);
+    Partition& p = world->get_partition(item.second.first);
     const Wall& w = p.get_wall(item.second.second);
 
     for (molecule_id_t m_id: w.grid.get_molecules_per_tile()) {
@@ -628,12 +628,12 @@ int ReleaseEvent::vacuum_from_regions(int number_to_remove) {
         if (orientation != ORIENTATION_NONE && m.s.orientation != orientation) {
           continue;
         }
-        mol_ids_on_region.push_back(m_id);
+        mol_ids_on_region.push_back(make_pair(p.id, m_id));
       }
     }
   }
 
-  return randomly_remove_molecules(p, mol_ids_on_region, number_to_remove);
+  return randomly_remove_molecules(mol_ids_on_region, number_to_remove);
 }
 
 
@@ -695,7 +695,7 @@ void ReleaseEvent::release_onto_regions(int& computed_release_number) {
               species_id, orientation, event_time, get_release_delay_time()
           );
 
-      schedule_for_immediate_diffusion_if_needed(sm_id, WallTileIndexPair(wall.index, tile_index));
+      schedule_for_immediate_diffusion_if_needed(p, sm_id, WallTileIndexPair(wall.index, tile_index));
 
       #ifdef DEBUG_RELEASES
         p.get_m(sm_id).dump(p, "Released sm:", "", p.stats.get_current_iteration(), actual_release_time, true);
@@ -732,7 +732,7 @@ void ReleaseEvent::release_onto_regions(int& computed_release_number) {
                     species_id, orientation, event_time, get_release_delay_time()
                 );
 
-            schedule_for_immediate_diffusion_if_needed(sm_id, WallTileIndexPair(wi, ti));
+            schedule_for_immediate_diffusion_if_needed(p, sm_id, WallTileIndexPair(wi, ti));
 
             #ifdef DEBUG_RELEASES
               p.get_m(sm_id).dump(p, "Released sm:", "", p.stats.get_current_iteration(), actual_release_time, true);
@@ -864,35 +864,35 @@ vacuum_inside_regions:
 int ReleaseEvent::vacuum_inside_regions(int number_to_remove) {
   assert(number_to_remove > 0);
 
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
-
-  MoleculeIdsVector mol_ids_in_region;
+  PartitionMoleculeIdPairsVector mol_ids_in_region;
 
   // get all molecules that match the removed species
   // MCell3 knows which molecules are in which subparts, we don't know this
   // so we must go through all molecule
-  for (const Molecule& m: p.get_molecules()) {
-    if (m.is_defunct()) {
-      continue;
-    }
-    if (m.species_id != species_id) {
-      continue;
-    }
-    release_assert(m.is_vol());
+  for (Partition& p: world->get_partitions()) {
+    for (const Molecule& m: p.get_molecules()) {
+      if (m.is_defunct()) {
+        continue;
+      }
+      if (m.species_id != species_id) {
+        continue;
+      }
+      release_assert(m.is_vol());
 
-    // filter by bounding box
-    if (!point_in_box(m.v.pos, region_llf, region_urb)) {
-      continue;
-    }
-    // then precisely by region
-    if (!is_point_inside_region_expr_recursively(p, m.v.pos, region_expr.root)) {
-      continue;
-    }
+      // filter by bounding box
+      if (!point_in_box(m.v.pos, region_llf, region_urb)) {
+        continue;
+      }
+      // then precisely by region
+      if (!is_point_inside_region_expr_recursively(p, m.v.pos, region_expr.root)) {
+        continue;
+      }
 
-    mol_ids_in_region.push_back(m.id);
+      mol_ids_in_region.push_back(make_pair(p.id, m.id));
+    }
   }
 
-  return randomly_remove_molecules(p, mol_ids_in_region, number_to_remove);
+  return randomly_remove_molecules(mol_ids_in_region, number_to_remove);
 }
 
 
@@ -905,8 +905,6 @@ void ReleaseEvent::release_inside_regions(int& computed_release_number) {
 
   assert(region_expr.root != nullptr);
 
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
-
   bool exact_number = false;
   if (release_number_method == ReleaseNumberMethod::CONCENTRATION_NUM) {
     computed_release_number = num_vol_mols_from_conc(exact_number);
@@ -925,6 +923,7 @@ void ReleaseEvent::release_inside_regions(int& computed_release_number) {
     pos.y = region_llf.y + (region_urb.y - region_llf.y) * rng_dbl(&world->rng);
     pos.z = region_llf.z + (region_urb.z - region_llf.z) * rng_dbl(&world->rng);
 
+    Partition& p = world->get_partition_for_pos(pos);
     if (!is_point_inside_region_expr_recursively(p, pos, region_expr.root)) {
       if (release_number_method == ReleaseNumberMethod::CONCENTRATION_NUM && !exact_number) {
         computed_release_number--;
@@ -939,7 +938,7 @@ void ReleaseEvent::release_inside_regions(int& computed_release_number) {
     new_vm.set_flag(MOLECULE_FLAG_VOL);
     new_vm.set_flag(MOLECULE_FLAG_SCHEDULE_UNIMOL_RXN);
 
-    schedule_for_immediate_diffusion_if_needed(new_vm.id);
+    schedule_for_immediate_diffusion_if_needed(p, new_vm.id);
 
     n--;
 
@@ -953,7 +952,6 @@ void ReleaseEvent::release_inside_regions(int& computed_release_number) {
 void ReleaseEvent::release_ellipsoid_or_rectcuboid(int computed_release_number) {
   assert(computed_release_number >= 0 && "Cannot have negative SPHERICAL release");
 
-  Partition& p = world->get_partition(PARTITION_ID_INITIAL);
   double time_step = world->get_all_species().get(species_id).time_step;
 
   const int is_spheroidal = (release_shape == ReleaseShape::SPHERICAL ||
@@ -989,13 +987,14 @@ void ReleaseEvent::release_ellipsoid_or_rectcuboid(int computed_release_number)
     molecule_location.y = base_location[0][1];
     molecule_location.z = base_location[0][2];
 
+    Partition& p = world->get_partition_for_pos(molecule_location);
     Molecule& new_vm = p.add_volume_molecule(
         Molecule(MOLECULE_ID_INVALID, species_id, molecule_location, event_time), get_release_delay_time()
     );
     new_vm.set_flag(MOLECULE_FLAG_VOL);
     new_vm.set_flag(MOLECULE_FLAG_SCHEDULE_UNIMOL_RXN);
 
-    schedule_for_immediate_diffusion_if_needed(new_vm.id);
+    schedule_for_immediate_diffusion_if_needed(p, new_vm.id);
 
 #ifdef DEBUG_RELEASES
     new_vm.dump(p, "Released vm:", "", p.stats.get_current_iteration(), actual_release_time, true);
@@ -1009,16 +1008,16 @@ void ReleaseEvent::release_list() {
   for (const SingleMoleculeReleaseInfo& info: molecule_list) {
 
     BNG::Species& species = world->get_all_species().get(info.species_id);
-    Partition& p = world->get_partition(PARTITION_ID_INITIAL);
 
     if (species.is_vol()) {
+      Partition& p = world->get_partition_for_pos(info.pos);
       Molecule& new_vm = p.add_volume_molecule(
           Molecule(MOLECULE_ID_INVALID, info.species_id, info.pos, event_time), get_release_delay_time()
       );
       new_vm.set_flag(MOLECULE_FLAG_VOL);
       new_vm.set_flag(MOLECULE_FLAG_SCHEDULE_UNIMOL_RXN);
 
-      schedule_for_immediate_diffusion_if_needed(new_vm.id);
+      schedule_for_immediate_diffusion_if_needed(p, new_vm.id);
 
       cout
         << "Released 1 " << species.name << " from \"" << release_site_name << "\""
@@ -1036,6 +1035,8 @@ void ReleaseEvent::release_list() {
 
       double diam = diameter.x;
       assert(diam != FLT_INVALID);
+      // surface molecules are supported only with a single partition
+      Partition& p = world->get_partition(PARTITION_ID_INITIAL);
       molecule_id_t sm_id = GridUtils::place_surface_molecule_to_closest_pos(
           p, world->rng, info.pos, info.species_id, orient, diameter.x,
           event_time, get_release_delay_time()
@@ -1043,7 +1044,7 @@ void ReleaseEvent::release_list() {
 
       if (sm_id != MOLECULE_ID_INVALID) {
         const Molecule& sm = p.get_m(sm_id);
-        schedule_for_immediate_diffusion_if_needed(sm_id, WallTileIndexPair(sm.s.wall_index, sm.s.grid_tile_index));
+        schedule_for_immediate_diffusion_if_needed(p, sm_id, WallTileIndexPair(sm.s.wall_index, sm.s.grid_tile_index));
 
         cout
           << "Released 1 " << species.name << " from \"" << release_site_name << "\""
@@ -1309,10 +1310,9 @@ void ReleaseEvent::step() {
 
 
 void ReleaseEvent::schedule_for_immediate_diffusion_if_needed(
-    const molecule_id_t id, const WallTileIndexPair& where_released) {
-  // NOTE: we do nto care about partitions here but we should
+    const Partition& p, const molecule_id_t id, const WallTileIndexPair& where_released) {
   if (running_diffuse_event_to_update != nullptr) {
-    running_diffuse_event_to_update->add_diffuse_action(DiffuseAction(id, where_released));
+    running_diffuse_event_to_update->add_diffuse_action(p.id, DiffuseAction(id, where_released));
   }
 }
 
@@ -222,7 +222,7 @@ private:
   uint calculate_number_to_release();
 
   int randomly_remove_molecules(
-      Partition& p, const MoleculeIdsVector& mol_ids_in_region, int number_to_remove);
+      const PartitionMoleculeIdPairsVector& mol_ids_in_region, int number_to_remove);
 
   // for surface molecule releases
   int vacuum_from_regions(int number_to_remove);
@@ -250,7 +250,7 @@ private:
   void release_initial_molecules_onto_surf_regions();
 
   void schedule_for_immediate_diffusion_if_needed(
-      const molecule_id_t id, const WallTileIndexPair& where_released = WallTileIndexPair());
+      const Partition& p, const molecule_id_t id, const WallTileIndexPair& where_released = WallTileIndexPair());
 
   double get_release_delay_time() const {
     if (cmp_eq(actual_release_time, event_time)) {
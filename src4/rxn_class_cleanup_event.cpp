@@ -28,6 +28,8 @@ void RxnClassCleanupEvent::dump(const string ind) const {
 
 
 void RxnClassCleanupEvent::step() {
+  // caches hold rxn classes that may be removed
+  world->clear_rxn_class_caches();
 
   // for all species
   for (BNG::Species* sp: world->get_all_species().get_species_vector()) {
@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include <cmath>
+
+#include "rxn_pathway_alias_tables.h"
+
+using namespace std;
+
+namespace MCell {
+
+// based on Vose's variant of the alias method
+void AliasTable::build(const std::vector<double>& weights) {
+  uint n = weights.size();
+  assert(n > 0);
+
+  double total = 0;
+  for (double w: weights) {
+    assert(w >= 0);
+    total += w;
+  }
+  release_assert(total > 0 && "At least one weight must be positive");
+
+  probabilities.resize(n);
+  aliases.resize(n);
+
+  // scaled so that the average weight is 1
+  vector<double> scaled(n);
+  vector<uint> small;
+  vector<uint> large;
+  for (uint i = 0; i < n; i++) {
+    scaled[i] = weights[i] * n / total;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    }
+    else {
+      large.push_back(i);
+    }
+  }
+
+  // each column is filled by one small item and the rest is taken from a large item
+  while (!small.empty() && !large.empty()) {
+    uint s = small.back();
+    small.pop_back();
+    uint l = large.back();
+
+    probabilities[s] = scaled[s];
+    aliases[s] = l;
+
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  // remaining items fill their columns up to rounding errors
+  for (uint i: large) {
+    probabilities[i] = 1.0;
+    aliases[i] = i;
+  }
+  for (uint i: small) {
+    probabilities[i] = 1.0;
+    aliases[i] = i;
+  }
+}
+
+
+BNG::rxn_class_pathway_index_t RxnPathwayAliasTables::get_pathway_index_for_probability(
+    BNG::RxnClass* rxn_class, const double prob, const double local_prob_factor) {
+
+  double max_fixed_p = rxn_class->get_max_fixed_p();
+
+  auto it = tables.find(rxn_class);
+  if (it == tables.end()) {
+    it = tables.insert(make_pair(rxn_class, RxnClassAliasTable())).first;
+    build_table(rxn_class, it->second);
+  }
+  else if (it->second.max_fixed_p != max_fixed_p ||
+      it->second.next_time_of_rxn_rate_update != rxn_class->get_next_time_of_rxn_rate_update()) {
+    // rates were updated
+    build_table(rxn_class, it->second);
+  }
+
+  // prob may be equal to the upper bound due to rounding
+  double u = min(prob / (max_fixed_p * local_prob_factor), nextafter(1.0, 0.0));
+  return it->second.table.sample(u);
+}
+
+
+void RxnPathwayAliasTables::build_table(BNG::RxnClass* rxn_class, RxnClassAliasTable& entry) {
+  entry.max_fixed_p = rxn_class->get_max_fixed_p();
+  entry.next_time_of_rxn_rate_update = rxn_class->get_next_time_of_rxn_rate_update();
+
+  // the rxn class provides only the mapping from probabilities to pathways,
+  // upper bounds of probabilities of each pathway are found by bisection
+  uint num_pathways = rxn_class->get_num_pathways();
+  assert(num_pathways > 0);
+  vector<double> weights(num_pathways);
+
+  double lower_bound = 0;
+  for (uint i = 0; i + 1 < num_pathways; i++) {
+    double lo = lower_bound;
+    double hi = entry.max_fixed_p;
+
+    if (rxn_class->get_pathway_index_for_probability(lo, 1) > (int)i) {
+      // this pathway has zero probability
+      hi = lo;
+    }
+    else {
+      while (true) {
+        double mid = lo + (hi - lo) / 2;
+        if (mid <= lo || mid >= hi) {
+          break;
+        }
+        if (rxn_class->get_pathway_index_for_probability(mid, 1) > (int)i) {
+          hi = mid;
+        }
+        else {
+          lo = mid;
+        }
+      }
+    }
+
+    weights[i] = hi - lower_bound;
+    lower_bound = hi;
+  }
+  weights[num_pathways - 1] = entry.max_fixed_p - lower_bound;
+
+  entry.table.build(weights);
+}
+
+} // namespace MCell
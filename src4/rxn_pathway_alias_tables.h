@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_RXN_PATHWAY_ALIAS_TABLES_H_
+#define SRC4_RXN_PATHWAY_ALIAS_TABLES_H_
+
+#include <vector>
+#include <unordered_map>
+
+#include "bng/bng.h"
+
+#include "defines.h"
+
+namespace MCell {
+
+/*
+ * Walker's alias table, selects an item with probability proportional to its weight
+ * using a single uniformly distributed random number in constant time.
+ */
+class AliasTable {
+public:
+  // weights must not be negative and at least one of them must be positive
+  void build(const std::vector<double>& weights);
+
+  // u must be in interval [0, 1)
+  uint sample(const double u) const {
+    assert(!probabilities.empty());
+    double x = u * probabilities.size();
+    uint i = std::min((uint)x, (uint)probabilities.size() - 1);
+    return (x - i < probabilities[i]) ? i : aliases[i];
+  }
+
+private:
+  // probability that item i is selected when column i is hit, 1 when it has no alias
+  std::vector<double> probabilities;
+  std::vector<uint> aliases;
+};
+
+
+/*
+ * Alias tables for selection of pathways of rxn classes with many pathways.
+ *
+ * A table is built lazily from the cumulative probabilities of a rxn class and rebuilt when
+ * the rxn class updated its rates, i.e. when its next time of rxn rate update or its
+ * maximal probability changed. The tables are keyed by rxn class pointers,
+ * so clear must be called whenever rxn classes are removed or their rates changed from outside.
+ */
+class RxnPathwayAliasTables {
+public:
+  // selects a pathway with the same probabilities as rxn_class->get_pathway_index_for_probability,
+  // prob must be in interval [0, rxn_class->get_max_fixed_p() * local_prob_factor)
+  BNG::rxn_class_pathway_index_t get_pathway_index_for_probability(
+      BNG::RxnClass* rxn_class, const double prob, const double local_prob_factor);
+
+  void clear() {
+    tables.clear();
+  }
+
+private:
+  struct RxnClassAliasTable {
+    AliasTable table;
+    // values of the rxn class when the table was built
+    double max_fixed_p;
+    double next_time_of_rxn_rate_update;
+  };
+
+  void build_table(BNG::RxnClass* rxn_class, RxnClassAliasTable& entry);
+
+  std::unordered_map<const BNG::RxnClass*, RxnClassAliasTable> tables;
+};
+
+} // namespace MCell
+
+#endif // SRC4_RXN_PATHWAY_ALIAS_TABLES_H_
@@ -30,6 +30,7 @@
 #include "partition.h"
 #include "geometry.h"
 #include "debug_config.h"
+#include "counter_based_rng.h"
 
 using namespace std;
 
@@ -56,13 +57,12 @@ trigger_bimolecular:
          the moving molecule is not inert!
 *************************************************************************/
 static void trigger_bimolecular(
-    BNG::BNGEngine& bng_engine,
+    Partition& p,
     const Molecule& reacA, const Molecule& reacB,
     orientation_t orientA, orientation_t orientB,
     BNG::RxnClassesVector& matching_rxn_classes // items are appended
 ) {
-  BNG::RxnClass* rxn_class =
-      bng_engine.get_all_rxns().get_bimol_rxn_class(reacA.species_id, reacB.species_id);
+  BNG::RxnClass* rxn_class = p.get_bimol_rxn_class(reacA.species_id, reacB.species_id);
   if (rxn_class == nullptr) {
     // no reaction
     return;
@@ -84,12 +84,12 @@ static void trigger_bimolecular(
 }
 
 static void trigger_bimolecular_orientation_from_mols(
-    BNG::BNGEngine& bng_engine,
+    Partition& p,
     const Molecule& reacA, const Molecule& reacB,
     BNG::RxnClassesVector& matching_rxn_classes // items are appended
 ) {
   trigger_bimolecular(
-      bng_engine,
+      p,
       reacA, reacB,
       reacA.s.orientation, reacB.s.orientation,
       matching_rxn_classes
@@ -320,6 +320,25 @@ static int binary_search_double(const std::vector<double>& A, double match, int
 }
 
 
+// selects a pathway of a rxn class for prob in interval [0, max_fixed_p * local_prob_factor),
+// rxn classes with many pathways use alias tables when enabled
+static BNG::rxn_class_pathway_index_t select_pathway(
+    Partition& p,
+    BNG::RxnClass* rxn_class,
+    const double prob,
+    const double local_prob_factor
+) {
+  if (p.config.use_rxn_pathway_alias_tables &&
+      rxn_class->get_num_pathways() >= RXN_PATHWAY_ALIAS_TABLE_MIN_PATHWAYS) {
+    return p.get_rxn_pathway_alias_tables().get_pathway_index_for_probability(
+        rxn_class, prob, local_prob_factor);
+  }
+  else {
+    return rxn_class->get_pathway_index_for_probability(prob, local_prob_factor);
+  }
+}
+
+
 /*************************************************************************
 test_bimolecular
   In: the reaction we're testing
@@ -406,10 +425,10 @@ static int test_bimolecular(
 #endif
 
   if (local_prob_factor > 0) {
-    return rxn_class->get_pathway_index_for_probability(prob, local_prob_factor);
+    return select_pathway(p, rxn_class, prob, local_prob_factor);
   }
   else {
-    return rxn_class->get_pathway_index_for_probability(prob, 1);
+    return select_pathway(p, rxn_class, prob, 1);
   }
 }
 
@@ -420,9 +439,10 @@ test_many_unimol:
       rng state
   Out: index of the selected rxn class
 *************************************************************************/
+template<class RNG>
 static uint test_many_unimol(
     const BNG::RxnClassesVector& rxn_classes,
-    rng_state& rng) {
+    RNG& rng) {
 
   assert(!rxn_classes.empty());
 
@@ -439,7 +459,7 @@ static uint test_many_unimol(
     cum_rxn_class_probs[i] = cum_rxn_class_probs[i - 1] + rxn_classes[i]->get_max_fixed_p();
   }
 
-  double p = rng_dbl(&rng) * cum_rxn_class_probs[n - 1];
+  double p = rng_next_dbl(rng) * cum_rxn_class_probs[n - 1];
 
   /* Pick the reaction that happens */
   uint res = binary_search_double(cum_rxn_class_probs, p, cum_rxn_class_probs.size() - 1, 1);
@@ -568,10 +588,10 @@ static int test_many_bimolecular(
   /* Now pick the pathway within that reaction */
   // NOTE: might optimize if there is just one rxn
   if (all_neighbors_flag && local_prob_factor > 0) {
-    m = selected_rxn_class->get_pathway_index_for_probability(prob, local_prob_factor);
+    m = select_pathway(p, selected_rxn_class, prob, local_prob_factor);
   }
   else {
-    m = selected_rxn_class->get_pathway_index_for_probability(prob, 1);
+    m = select_pathway(p, selected_rxn_class, prob, 1);
   }
 
   chosen_pathway_index = m;
@@ -591,11 +611,12 @@ test_intersect
         update counters assuming the reaction will take place.
 *************************************************************************/
 static BNG::rxn_class_pathway_index_t test_intersect(
+    Partition& p,
     BNG::RxnClass* rxn_class,
     const double scaling,
     const double current_time,
     rng_state& rng) {
-  double p;
+  double prob;
 
   assert(rxn_class->type == BNG::RxnType::Standard &&
       "Reflect and Transparent should be handled elsewhere, AbsorbRegionBorder is not applicable here");
@@ -605,24 +626,24 @@ static BNG::rxn_class_pathway_index_t test_intersect(
   double max_prob = rxn_class->get_max_fixed_p();
 
   if (max_prob > scaling) {
-    p = rng_dbl(&rng) * max_prob;
+    prob = rng_dbl(&rng) * max_prob;
   }
   else {
-    p = rng_dbl(&rng) * scaling;
+    prob = rng_dbl(&rng) * scaling;
 
-    if (p > max_prob) {
+    if (prob > max_prob) {
       return BNG::PATHWAY_INDEX_NO_RXN;
     }
   }
 
-  if (p > rxn_class->get_max_fixed_p()) {
+  if (prob > rxn_class->get_max_fixed_p()) {
     return BNG::PATHWAY_INDEX_NO_RXN;
   }
 
   double match = rng_dbl(&rng);
   match = match * rxn_class->get_max_fixed_p();
 
-  return rxn_class->get_pathway_index_for_probability(match, 1);
+  return select_pathway(p, rxn_class, match, 1);
 }
 
 
@@ -639,6 +660,7 @@ test_many_intersect:
         update counters assuming the reaction will take place.
 *************************************************************************/
 static BNG::rxn_class_pathway_index_t test_many_intersect(
+    Partition& p,
     BNG::RxnClassesVector& rxn_classes,
     const double scaling,
     const double current_time,
@@ -653,7 +675,7 @@ static BNG::rxn_class_pathway_index_t test_many_intersect(
 
   if (num_classes == 1) {
     selected_rxn_class_index = 0;
-    return test_intersect(rxn_classes[0], scaling, current_time, rng);
+    return test_intersect(p, rxn_classes[0], scaling, current_time, rng);
   }
 
   // array of cumulative rxn probabilities
@@ -665,29 +687,29 @@ static BNG::rxn_class_pathway_index_t test_many_intersect(
     rxn_probs[i] = rxn_probs[i - 1] + rxn_classes[i]->get_max_fixed_p() / scaling;
   }
 
-  double p;
+  double prob;
   if (rxn_probs[num_classes - 1] > 1.0) {
-    p = rng_dbl(&rng) * rxn_probs[num_classes - 1];
+    prob = rng_dbl(&rng) * rxn_probs[num_classes - 1];
   } else {
-    p = rng_dbl(&rng);
-    if (p > rxn_probs[num_classes - 1]) {
+    prob = rng_dbl(&rng);
+    if (prob > rxn_probs[num_classes - 1]) {
       selected_rxn_class_index = BNG::RNX_CLASS_INDEX_INVALID;
       return BNG::PATHWAY_INDEX_NO_RXN;
     }
   }
 
   /* Pick the reaction that happens */
-  selected_rxn_class_index = binary_search_double(rxn_probs, p, num_classes - 1, 1);
+  selected_rxn_class_index = binary_search_double(rxn_probs, prob, num_classes - 1, 1);
 
   BNG::RxnClass *selected_rxn_class = rxn_classes[selected_rxn_class_index];
 
   if (selected_rxn_class_index > 0) {
-    p = (p - rxn_probs[selected_rxn_class_index - 1]);
+    prob = (prob - rxn_probs[selected_rxn_class_index - 1]);
   }
-  p = p * scaling;
+  prob = prob * scaling;
 
   /* Now pick the pathway within that reaction */
-  return selected_rxn_class->get_pathway_index_for_probability(p, 1);
+  return select_pathway(p, selected_rxn_class, prob, 1);
 }
 
 
@@ -718,7 +740,8 @@ static void pick_unimol_rxn_classes(
 
 
 // based on timeof_unimolecular
-static double time_of_unimol(BNG::RxnClass* rxn_class, rng_state& rng) {
+template<class RNG>
+static double time_of_unimol(BNG::RxnClass* rxn_class, RNG& rng) {
   double k_tot = rxn_class->get_max_fixed_p();
 #ifdef MCELL4_NO_RNG_FOR_UNIMOL_RXN_P_0
   if (k_tot <= 0) {
@@ -726,7 +749,7 @@ static double time_of_unimol(BNG::RxnClass* rxn_class, rng_state& rng) {
     return TIME_FOREVER;
   }
 #endif  
-  double p = rng_dbl(&rng);
+  double p = rng_next_dbl(rng);
 
   if ((k_tot <= 0) || (!distinguishable_f(p, 0, EPS))) {
     return TIME_FOREVER;
@@ -736,9 +759,10 @@ static double time_of_unimol(BNG::RxnClass* rxn_class, rng_state& rng) {
 
 
 // based on compute_lifetime
+template<class RNG>
 static double compute_unimol_lifetime(
     const Partition& p,
-    rng_state& rng,
+    RNG& rng,
     BNG::RxnClass* rx,
     const double current_time,
     Molecule& m
@@ -771,15 +795,57 @@ which_unimolecular:
   In: the reaction we're testing
   Out: int containing which unimolecular reaction occurs (one must occur)
 *************************************************************************/
-static BNG::rxn_class_pathway_index_t which_unimolecular(const Molecule& m, BNG::RxnClass *rxn_class, rng_state& rng) {
+template<class RNG>
+static BNG::rxn_class_pathway_index_t which_unimolecular(
+    Partition& p, const Molecule& m, BNG::RxnClass *rxn_class, RNG& rng) {
   assert(rxn_class != nullptr);
   if (rxn_class->get_num_reactions() == 1) {
     return 0;
   }
 
-  double match = rng_dbl(&rng);
+  double match = rng_next_dbl(rng);
   match = match * rxn_class->get_max_fixed_p();
-  return rxn_class->get_pathway_index_for_probability(match, 1);
+  return select_pathway(p, rxn_class, match, 1);
+}
+
+
+// selects one of the rxn classes and returns time from now when its unimolecular rxn occurs,
+// rxn_classes must not be empty
+template<class RNG>
+static double pick_unimol_rxn_class_and_lifetime(
+    const Partition& p,
+    RNG& rng,
+    const BNG::RxnClassesVector& rxn_classes,
+    const double current_time,
+    Molecule& m
+) {
+  uint idx = 0;
+  if (rxn_classes.size() > 1) {
+    idx = test_many_unimol(rxn_classes, rng);
+  }
+
+  // there is a check when computing the reaction rate to make sure that the time is reasonably higher than 0
+  return compute_unimol_lifetime(p, rng, rxn_classes[idx], current_time, m);
+}
+
+
+// selects one of the rxn classes and its pathway for a unimolecular rxn that occurs now,
+// rxn_classes must not be empty
+template<class RNG>
+static void pick_unimol_rxn_class_and_pathway(
+    Partition& p,
+    const Molecule& m,
+    RNG& rng,
+    const BNG::RxnClassesVector& rxn_classes,
+    uint& rxn_class_index,
+    BNG::rxn_class_pathway_index_t& pathway_index
+) {
+  rxn_class_index = 0;
+  if (rxn_classes.size() > 1) {
+    rxn_class_index = test_many_unimol(rxn_classes, rng);
+  }
+
+  pathway_index = which_unimolecular(p, m, rxn_classes[rxn_class_index], rng);
 }
 
 } // namespace RxUtil
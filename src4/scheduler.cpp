@@ -242,6 +242,50 @@ double Calendar::get_time_up_to_next_barrier(
 }
 
 
+// returns max_time if no event that ends idle time skipping is scheduled for interval
+// current_time .. current_time+max_time,
+// if such an event exists, returns the time from current_time to the start of
+// the iteration of this event but at least one time step
+double Calendar::get_time_up_to_next_idle_time_skipping_end(
+    const double current_time, const double max_time) const {
+
+  for (const Bucket& bucket: queue) {
+    if (bucket.start_time >= current_time + max_time) {
+      break;
+    }
+    for (const BaseEvent* event: bucket.events) {
+      if (event->ends_idle_time_skipping()) {
+        return std::min(std::max(floor_f(event->event_time) - current_time, 1.0), max_time);
+      }
+    }
+  }
+
+  return max_time;
+}
+
+
+void Calendar::end_idle_time_skipping(const double time) {
+  std::vector<BaseEvent*> events_to_reschedule;
+  for (Bucket& bucket: queue) {
+    auto it = bucket.events.begin();
+    while (it != bucket.events.end()) {
+      if ((*it)->get_idle_time_to_skip() > 0 && cmp_lt(time, (*it)->event_time, SCHEDULER_COMPARISON_EPS)) {
+        events_to_reschedule.push_back(*it);
+        it = bucket.events.erase(it);
+      }
+      else {
+        it++;
+      }
+    }
+  }
+
+  for (BaseEvent* event: events_to_reschedule) {
+    event->event_time = time;
+    insert(event);
+  }
+}
+
+
 void Scheduler::schedule_event(BaseEvent* event) {
   release_assert(event->event_time != TIME_INVALID);
   calendar.insert(event);
@@ -313,6 +357,14 @@ EventExecutionInfo Scheduler::handle_next_event() {
   event->step();
   event_being_executed = nullptr;
 
+  // events may skip time in which they have nothing to do up to
+  // an event that may give them more work
+  double idle_time_to_skip = event->get_idle_time_to_skip();
+  if (idle_time_to_skip > 0) {
+    event->set_idle_time_to_skip(
+        calendar.get_time_up_to_next_idle_time_skipping_end(event_time, idle_time_to_skip));
+  }
+
   event_type_index_t type_index = event->type_index;
   bool return_from_run_iterations = event->return_from_run_n_iterations_after_execution();
 
@@ -74,6 +74,10 @@ public:
 
   double get_time_up_to_next_barrier(const double current_time, const double max_time_step);
 
+  double get_time_up_to_next_idle_time_skipping_end(const double current_time, const double max_time) const;
+
+  void end_idle_time_skipping(const double time);
+
   void print_periodic_stats() const {
     std::cout << "Calendar: queue.size() = " << queue.size() << "\n";
   }
@@ -139,6 +143,12 @@ public:
   // returns time of the event that was handled
   EventExecutionInfo handle_next_event();
 
+  // events that skipped idle time and are scheduled after the given time are
+  // rescheduled to this time, used when the model may be changed from outside
+  void end_idle_time_skipping(const double time) {
+    calendar.end_idle_time_skipping(time);
+  }
+
   // skip events for checkpointing,
   // may take long time if periodic events are scheduled
   void skip_events_up_to_time(const double start_time);
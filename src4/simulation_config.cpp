@@ -157,6 +157,7 @@ void SimulationConfig::dump() {
 #define DUMP_ATTR(A) cout << "  " #A ": \t\t" << A << "\n"
   DUMP_ATTR(vacancy_search_dist2);
   DUMP_ATTR(partition0_llf);
+  DUMP_ATTR(num_partitions_per_world_edge);
   DUMP_ATTR(partition_edge_length);
   DUMP_ATTR(num_subparts_per_partition_edge);
   DUMP_ATTR(num_subparts_per_partition_edge_squared);
@@ -170,6 +171,18 @@ void SimulationConfig::dump() {
   DUMP_ATTR(rxn_class_cleanup_periodicity);
   DUMP_ATTR(species_cleanup_periodicity);
   DUMP_ATTR(sort_mols_by_subpart);
+  DUMP_ATTR(sort_mols_in_morton_order);
+  DUMP_ATTR(num_threads);
+  DUMP_ATTR(use_counter_based_rng);
+  DUMP_ATTR(use_batched_gauss_rng);
+  DUMP_ATTR(use_async_viz_output);
+  DUMP_ATTR(max_pending_viz_frames);
+  DUMP_ATTR(use_async_count_output);
+  DUMP_ATTR(max_pending_count_output_mb);
+  DUMP_ATTR(use_wall_bvh);
+  DUMP_ATTR(use_adaptive_subparts);
+  DUMP_ATTR(use_counted_volume_voxels);
+  DUMP_ATTR(use_rxn_pathway_alias_tables);
   DUMP_ATTR(memory_limit_gb);
   DUMP_ATTR(simulation_stats_every_n_iterations);
   DUMP_ATTR(has_intersecting_counted_objects);
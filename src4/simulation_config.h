@@ -31,6 +31,7 @@ public:
     initial_time(TIME_INVALID),
     initial_iteration(UINT_INVALID),
     vacancy_search_dist2(FLT_INVALID),
+    num_partitions_per_world_edge(1),
     partition_edge_length(FLT_INVALID),
     num_subparts_per_partition_edge(UINT_INVALID),
     num_subparts_per_partition_edge_squared(UINT_INVALID),
@@ -45,9 +46,22 @@ public:
     species_cleanup_periodicity(0),
     molecules_order_random_shuffle_periodicity(DEFAULT_MOL_ORDER_SHUFFLE_PERIODICITY),
     sort_mols_by_subpart(false),
+    sort_mols_in_morton_order(false),
+    num_threads(1),
+    use_counter_based_rng(false),
+    use_batched_gauss_rng(false),
+    use_async_viz_output(false),
+    max_pending_viz_frames(2),
+    use_async_count_output(false),
+    max_pending_count_output_mb(64),
+    use_wall_bvh(false),
+    use_adaptive_subparts(false),
+    use_counted_volume_voxels(false),
+    use_rxn_pathway_alias_tables(false),
     memory_limit_gb(-1),
     iteration_report(true),
     wall_overlap_report(false),
+    startup_timing_report(false),
     simulation_stats_every_n_iterations(0),
     continue_after_sigalrm(false),
     has_intersecting_counted_objects(false)
@@ -63,7 +77,10 @@ public:
   pos_t vacancy_search_dist2; /* Square of distance to search for free grid
                                   location to place surface product */
 
+  // llf corner of the lattice of partitions, the lattice has
+  // num_partitions_per_world_edge^3 partitions, each with edge partition_edge_length
   Vec3 partition0_llf;
+  uint num_partitions_per_world_edge;
 
   pos_t partition_edge_length;
   uint num_subparts_per_partition_edge;
@@ -91,6 +108,49 @@ public:
 
   bool sort_mols_by_subpart;
 
+  // molecules, schedulable molecule ids and subpart reactants are sorted by the Z-order curve
+  // position of subparts when the diffusion order lost its locality
+  bool sort_mols_in_morton_order;
+
+  // number of threads used to diffuse volume molecules, 1 means serial execution,
+  // only molecules that cannot hit a wall or react during their step are diffused in parallel
+  uint num_threads;
+
+  // diffusion and unimolecular reaction random numbers are generated per molecule
+  // by CounterBasedRng and do not depend on the order in which molecules are simulated,
+  // bimolecular reactions, product placement and releases still use World::rng
+  bool use_counter_based_rng;
+
+  // normally distributed numbers for diffusion are generated in blocks by GaussBuffer,
+  // ignored when use_counter_based_rng is set
+  bool use_batched_gauss_rng;
+
+  // visualization files are written by VizOutputWriter in a background thread,
+  // simulation waits only when max_pending_viz_frames frames are not written yet
+  bool use_async_viz_output;
+  uint max_pending_viz_frames;
+
+  // count buffers are written by CountBufferWriter in a background thread,
+  // simulation waits only when more than max_pending_count_output_mb of data is not written yet
+  bool use_async_count_output;
+  uint max_pending_count_output_mb;
+
+  // wall collisions of volume molecules are found using a bounding volume hierarchy (WallBvh)
+  // instead of walls stored per subpartition
+  bool use_wall_bvh;
+
+  // walls and reactants are stored per cell of an adaptive octree over subpartitions (SubpartCells),
+  // cells are periodically rebuilt by RebalanceSubpartCellsEvent
+  bool use_adaptive_subparts;
+
+  // counted volumes of positions are looked up in CountedVolumeVoxels when possible,
+  // used only when has_intersecting_counted_objects is true
+  bool use_counted_volume_voxels;
+
+  // pathways of rxn classes with many pathways are selected using alias tables
+  // stored in RxnPathwayAliasTables
+  bool use_rxn_pathway_alias_tables;
+
   int memory_limit_gb; // -1 means that limit is disabled
 
   // similar to MCell3's ITERATION_REPORT
@@ -98,6 +158,9 @@ public:
 
   bool wall_overlap_report;
 
+  // prints wall-clock time of startup phases at the end of World::init_simulation
+  bool startup_timing_report;
+
   int simulation_stats_every_n_iterations;
 
   bool continue_after_sigalrm;
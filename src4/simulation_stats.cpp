@@ -111,6 +111,9 @@ void SimulationStats::print_report(const std::string& warnings_report_file_name)
   cout << "Total number of mol reflections from a wall: " << mol_wall_reflections << "\n";
   cout << "Total number of vol mol vol mol collisions: " << vol_mol_vol_mol_collisions << "\n";
   cout << "Total number of molecule moves between walls: " << mol_moves_between_walls << "\n";
+  if (mol_partition_crossings != 0) {
+    cout << "Total number of molecule moves between partitions: " << mol_partition_crossings << "\n";
+  }
   cout << "Total number of usages of waypoints for counted volumes: " << num_waypoints_used << "\n";
   cout << "Total number of counted volume recomputations: " << recomputations_of_counted_volume << "\n";
   cout << "Total number of diffuse 3d calls: " << diffuse_3d_calls << "\n";
@@ -49,6 +49,9 @@ public:
   void inc_ray_polygon_tests() {
     ray_polygon_tests++;
   }
+  void add_ray_polygon_tests(const uint64_t count) {
+    ray_polygon_tests += count;
+  }
   void inc_ray_polygon_colls() {
     ray_polygon_colls++;
   }
@@ -66,6 +69,10 @@ public:
     mol_moves_between_walls++;
   }
 
+  void inc_mol_partition_crossings() {
+    mol_partition_crossings++;
+  }
+
   void inc_recomputations_of_counted_volume() {
     recomputations_of_counted_volume++;
   }
@@ -82,6 +89,21 @@ public:
     diffusion_cummtime += steps; // this is a bit weird, steps are not time
   }
 
+  // adds ray tracing stats collected separately by threads that initialize waypoints in parallel
+  void add_ray_stats(const SimulationStats& other) {
+    ray_voxel_tests += other.ray_voxel_tests;
+    ray_polygon_tests += other.ray_polygon_tests;
+    ray_polygon_colls += other.ray_polygon_colls;
+  }
+
+  // adds stats collected separately by threads that diffuse molecules in parallel
+  void add_parallel_diffusion_stats(
+      const uint64_t diffuse_3d_calls_, const uint64_t diffusion_number_, const double diffusion_cummtime_) {
+    diffuse_3d_calls += diffuse_3d_calls_;
+    diffusion_number += diffusion_number_;
+    diffusion_cummtime += diffusion_cummtime_;
+  }
+
   // warnings_report_file_name may be "", in that case warnings are not appended to
   // the warnings file
   void print_report(const std::string& warnings_report_file_name = "");
@@ -119,6 +141,7 @@ public:
     mol_wall_reflections = 0;
     vol_mol_vol_mol_collisions = 0;
     mol_moves_between_walls = 0;
+    mol_partition_crossings = 0;
     num_waypoints_used = 0;
     recomputations_of_counted_volume = 0;
     diffuse_3d_calls = 0;
@@ -145,6 +168,7 @@ private:
   uint64_t vol_mol_vol_mol_collisions;
 
   uint64_t mol_moves_between_walls;
+  uint64_t mol_partition_crossings;
 
   uint64_t num_waypoints_used;
   uint64_t recomputations_of_counted_volume;
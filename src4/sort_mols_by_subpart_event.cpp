@@ -27,36 +27,107 @@ void SortMolsBySubpartEvent::dump(const string ind) const {
 }
 
 
-struct SubpartComparatorForId
+// molecules that can diffuse are ordered by their subpartition, the rest is at the end
+struct SubpartComparatorForMol
 {
-  SubpartComparatorForId(const vector<uint>& mempart_indices_)
-    : mempart_indices(mempart_indices_) {
+  SubpartComparatorForMol(const vector<bool>& species_can_diffuse_)
+    : species_can_diffuse(species_can_diffuse_) {
   }
 
-  bool operator () (const molecule_id_t id1, const molecule_id_t id2) const {
-    assert(id1 < mempart_indices.size());
-    assert(id2 < mempart_indices.size());
-    return mempart_indices[id1] < mempart_indices[id2];
+  uint get_key(const Molecule& m) const {
+    assert(m.species_id < species_can_diffuse.size());
+    if (m.is_vol() && species_can_diffuse[m.species_id]) {
+      return m.v.subpart_index;
+    }
+    else {
+      // set some value that should not collide with subpart indices
+      return 0x80000000;
+    }
   }
 
-  const vector<uint>& mempart_indices;
+  bool operator () (const Molecule& m1, const Molecule& m2) const {
+    return get_key(m1) < get_key(m2);
+  }
+
+  const vector<bool>& species_can_diffuse;
 };
 
 
-struct SubpartComparatorForMol
-{
-  SubpartComparatorForMol(const vector<uint>& mempart_indices_)
-    : mempart_indices(mempart_indices_) {
+// spreads lower 21 bits of v so that there are two zero bits between each of them
+static inline uint64_t spread_bits_by_3(uint64_t v) {
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+
+
+const uint64_t MORTON_KEY_NOT_SORTED = UINT64_MAX;
+
+// position of molecule's subpart on the Z-order curve,
+// molecules that do not diffuse in volume are placed at the end
+static uint64_t get_morton_key(const Partition& p, const Molecule& m, const vector<bool>& species_can_diffuse) {
+  assert(m.species_id < species_can_diffuse.size());
+  if (!m.is_vol() || !species_can_diffuse[m.species_id]) {
+    return MORTON_KEY_NOT_SORTED;
   }
 
-  bool operator () (const Molecule& m1, const Molecule& m2) const {
-    assert(m1.id < mempart_indices.size());
-    assert(m2.id < mempart_indices.size());
-    return mempart_indices[m1.id] < mempart_indices[m2.id];
+  IVec3 indices;
+  p.get_subpart_3d_indices_from_index(m.v.subpart_index, indices);
+  return spread_bits_by_3(indices.x) | (spread_bits_by_3(indices.y) << 1) | (spread_bits_by_3(indices.z) << 2);
+}
+
+
+// locality metric, fraction of consecutively diffused molecules whose subparts
+// are not in Z-order, 0 right after sorting, about 0.5 for a random order
+static double get_fraction_of_unordered_schedulable_molecules(
+    const Partition& p, const vector<bool>& species_can_diffuse) {
+
+  const vector<molecule_id_t>& ids = p.get_schedulable_molecule_ids();
+  if (ids.size() < 2) {
+    return 0;
   }
 
-  const vector<uint>& mempart_indices;
-};
+  uint num_unordered = 0;
+  uint64_t prev_key = get_morton_key(p, p.get_m(ids[0]), species_can_diffuse);
+  for (size_t i = 1; i < ids.size(); i++) {
+    uint64_t key = get_morton_key(p, p.get_m(ids[i]), species_can_diffuse);
+    if (key < prev_key) {
+      num_unordered++;
+    }
+    prev_key = key;
+  }
+  return (double)num_unordered / (double)(ids.size() - 1);
+}
+
+
+static void sort_molecules_in_morton_order(Partition& p, const vector<bool>& species_can_diffuse) {
+  vector<Molecule>& molecules = p.get_molecules();
+
+  vector<pair<uint64_t, molecule_index_t>> keys_and_indices(molecules.size());
+  for (molecule_index_t i = 0; i < molecules.size(); i++) {
+    keys_and_indices[i] = make_pair(get_morton_key(p, molecules[i], species_can_diffuse), i);
+  }
+  sort(keys_and_indices.begin(), keys_and_indices.end());
+
+  vector<Molecule> sorted_molecules;
+  sorted_molecules.reserve(molecules.size());
+  for (const auto& key_and_index: keys_and_indices) {
+    sorted_molecules.push_back(molecules[key_and_index.second]);
+  }
+  molecules.swap(sorted_molecules);
+
+  MoleculeIdToIndexMap& molecule_id_to_index_mapping = p.get_molecule_id_to_index_mapping();
+  for (size_t i = 0; i < molecules.size(); i++) {
+    molecule_id_to_index_mapping.set(molecules[i].id, i);
+  }
+
+  // molecules are diffused and reactants are checked in the order in which they are stored
+  p.order_molecule_ids_by_molecule_index();
+}
 
 
 void SortMolsBySubpartEvent::step() {
@@ -69,30 +140,35 @@ void SortMolsBySubpartEvent::step() {
       continue;
     }
 
-    // may create too large array when multiple partitions will be used
-    // but currently the molecule ID assignment is done in partitions anyway
-    vector<uint> mempart_indices(p.get_next_molecule_id_no_increment());
-
-    for (Molecule& m: molecules) {
-      const BNG::Species& sp = p.get_species(m.species_id);
-      if (m.is_vol() && sp.can_diffuse()) {
-        mempart_indices[m.id] = m.v.subpart_index;
+    // indexed by species id, unlike an array indexed by molecule ids
+    // its size does not grow with the number of molecules that were ever created
+    const auto& all_species = world->get_all_species().get_species_vector();
+    vector<bool> species_can_diffuse(all_species.size(), false);
+    for (const BNG::Species* sp: all_species) {
+      // species may have been removed
+      if (sp != nullptr) {
+        assert(sp->id < species_can_diffuse.size());
+        species_can_diffuse[sp->id] = sp->can_diffuse();
       }
-      else {
-        // set some value that should not collide with subpart indices
-        mempart_indices[m.id] = 0x80000000;
+    }
+
+    if (world->config.sort_mols_in_morton_order) {
+      // sort only when new molecules or shuffling broke the order
+      if (get_fraction_of_unordered_schedulable_molecules(p, species_can_diffuse) >
+          SORT_MOLS_MAX_UNORDERED_FRACTION) {
+        sort_molecules_in_morton_order(p, species_can_diffuse);
       }
+      continue;
     }
 
     // also sort molecules in the molecules array
-    sort(molecules.begin(), molecules.end(), SubpartComparatorForMol(mempart_indices));
+    sort(molecules.begin(), molecules.end(), SubpartComparatorForMol(species_can_diffuse));
 
     // and update their indices in the molecule_id_to_index_mapping
-    std::vector<molecule_index_t>& molecule_id_to_index_mapping = p.get_molecule_id_to_index_mapping();
+    MoleculeIdToIndexMap& molecule_id_to_index_mapping = p.get_molecule_id_to_index_mapping();
     for (size_t i = 0; i < molecules.size(); i++) {
       const Molecule& m = molecules[i];
-      assert(molecule_id_to_index_mapping.size() < m.id);
-      molecule_id_to_index_mapping[m.id] = i;
+      molecule_id_to_index_mapping.set(m.id, i);
     }
   }
 }
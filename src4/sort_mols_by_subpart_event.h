@@ -30,6 +30,9 @@ public:
 
   void step() override;
   void dump(const std::string indent) const override;
+
+  // only reorders molecules
+  bool ends_idle_time_skipping() const override { return false; }
 private:
   World* world;
 };
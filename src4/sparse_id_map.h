@@ -0,0 +1,117 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_SPARSE_ID_MAP_H_
+#define SRC4_SPARSE_ID_MAP_H_
+
+#include <vector>
+
+#include "defines.h"
+
+namespace MCell {
+
+/*
+ * Two-level map from ids to values, ids are split into pages of PAGE_SIZE items
+ * and a page is allocated only when it contains at least one valid value.
+ *
+ * Molecule ids are never reused and new molecules get ever increasing ids,
+ * so pages with ids of molecules that were all removed can be released,
+ * the directory of pages grows with the highest id
+ * (sizeof(std::vector<T>), i.e. 24 bytes, per PAGE_SIZE ids).
+ *
+ * Memory is proportional to the number of live ids only when ids of long-lived
+ * molecules are clustered, in the worst case, each live id is in a different page
+ * and keeps PAGE_SIZE * sizeof(T) bytes allocated.
+ */
+template<class T, T INVALID_VALUE>
+class SparseIdMap {
+public:
+  static const uint PAGE_SIZE_BITS = 12;
+  static const uint PAGE_SIZE = 1 << PAGE_SIZE_BITS;
+
+  // returns INVALID_VALUE if there is no value for this id
+  T get(const uint id) const {
+    uint page_index = id >> PAGE_SIZE_BITS;
+    if (page_index >= pages.size() || pages[page_index].empty()) {
+      return INVALID_VALUE;
+    }
+    return pages[page_index][id & (PAGE_SIZE - 1)];
+  }
+
+  // allocates a page if needed, setting a value for an id whose page exists
+  // may be called concurrently for different ids
+  void set(const uint id, const T value) {
+    uint page_index = id >> PAGE_SIZE_BITS;
+    if (page_index >= pages.size()) {
+      pages.resize(page_index + 1);
+    }
+    std::vector<T>& page = pages[page_index];
+    if (page.empty()) {
+      page.resize(PAGE_SIZE, INVALID_VALUE);
+    }
+    page[id & (PAGE_SIZE - 1)] = value;
+  }
+
+  // memory is released later by release_empty_pages
+  void erase(const uint id) {
+    uint page_index = id >> PAGE_SIZE_BITS;
+    if (page_index >= pages.size() || pages[page_index].empty()) {
+      return;
+    }
+    pages[page_index][id & (PAGE_SIZE - 1)] = INVALID_VALUE;
+  }
+
+  // makes sure that the page directory will not be resized when setting ids lower than num_ids
+  void reserve(const uint num_ids) {
+    uint num_pages = (num_ids + PAGE_SIZE - 1) >> PAGE_SIZE_BITS;
+    if (num_pages > pages.size()) {
+      pages.resize(num_pages);
+    }
+  }
+
+  // pages are not tracked, the whole directory and all values of allocated pages
+  // are checked, i.e. the time is proportional to the allocated memory
+  void release_empty_pages() {
+    for (std::vector<T>& page: pages) {
+      if (page.empty()) {
+        continue;
+      }
+      bool all_invalid = true;
+      for (const T& value: page) {
+        if (value != INVALID_VALUE) {
+          all_invalid = false;
+          break;
+        }
+      }
+      if (all_invalid) {
+        std::vector<T>().swap(page);
+      }
+    }
+  }
+
+  uint get_num_allocated_pages() const {
+    uint res = 0;
+    for (const std::vector<T>& page: pages) {
+      if (!page.empty()) {
+        res++;
+      }
+    }
+    return res;
+  }
+
+private:
+  // indexed by id >> PAGE_SIZE_BITS, an empty vector represents a page without valid values
+  std::vector<std::vector<T>> pages;
+};
+
+} // namespace MCell
+
+#endif // SRC4_SPARSE_ID_MAP_H_
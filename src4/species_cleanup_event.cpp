@@ -54,8 +54,10 @@ void SpeciesCleanupEvent::remove_unused_reactant_classes() {
     // from rxn container including reacting classes
     world->get_all_rxns().remove_reactant_class(id);
 
-    // and from partition's reactants map
-    world->get_partition(PARTITION_ID_INITIAL).remove_reactant_class_usage(id);
+    // and from partitions' reactants maps
+    for (Partition& p: world->get_partitions()) {
+      p.remove_reactant_class_usage(id);
+    }
   }
 }
 
@@ -64,6 +66,7 @@ void SpeciesCleanupEvent::step() {
 
   // remove all rxn classes and all caches
   world->get_all_rxns().reset_caches();
+  world->clear_rxn_class_caches();
 
   for (BNG::Species* sp: world->get_all_species().get_species_vector()) {
     release_assert(sp != nullptr);
@@ -32,6 +32,9 @@ public:
 
   void step() override;
   void dump(const std::string indent) const override;
+
+  // does not change molecules
+  bool ends_idle_time_skipping() const override { return false; }
 private:
 
   void remove_unused_reactant_classes();
@@ -0,0 +1,46 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include "species_pair_rxn_class_cache.h"
+
+using namespace std;
+
+namespace MCell {
+
+void SpeciesPairRxnClassCache::add_species(const species_id_t species_id) {
+  if (get_species_index(species_id) != UINT_INVALID ||
+      num_species >= SPECIES_PAIR_RXN_CLASS_CACHE_MAX_SPECIES) {
+    return;
+  }
+
+  if (species_id >= species_index_per_species_id.size()) {
+    species_index_per_species_id.resize(species_id + 1, UINT_INVALID);
+  }
+  species_index_per_species_id[species_id] = num_species;
+  num_species++;
+
+  if (num_species > table_dim) {
+    // copy rows into a larger table, new items are not cached yet
+    uint new_table_dim = max(table_dim * 2, (uint)16);
+    vector<BNG::RxnClass*> new_rxn_classes(new_table_dim * new_table_dim, get_not_cached_marker());
+    for (uint row = 0; row < table_dim; row++) {
+      copy(
+          rxn_classes.begin() + row * table_dim,
+          rxn_classes.begin() + (row + 1) * table_dim,
+          new_rxn_classes.begin() + row * new_table_dim
+      );
+    }
+    rxn_classes.swap(new_rxn_classes);
+    table_dim = new_table_dim;
+  }
+}
+
+} // namespace MCell
@@ -0,0 +1,103 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_SPECIES_PAIR_RXN_CLASS_CACHE_H_
+#define SRC4_SPECIES_PAIR_RXN_CLASS_CACHE_H_
+
+#include <vector>
+
+#include "bng/rxn_container.h"
+
+#include "defines.h"
+
+namespace MCell {
+
+/*
+ * Dense table of bimolecular rxn classes for pairs of species instantiated in a partition,
+ * used on the collision hot path instead of RxnContainer::get_bimol_rxn_class.
+ *
+ * Species get a compact index when they are instantiated, the table is indexed by a pair
+ * of these indices and its items are filled lazily. Pairs with species that do not fit into
+ * SPECIES_PAIR_RXN_CLASS_CACHE_MAX_SPECIES are looked up in RxnContainer directly.
+ *
+ * Holds pointers to rxn classes, so clear must be called whenever rxn classes or species
+ * are removed.
+ */
+class SpeciesPairRxnClassCache {
+public:
+  SpeciesPairRxnClassCache()
+    : num_species(0), table_dim(0) {
+  }
+
+  // returns the same rxn class as RxnContainer::get_bimol_rxn_class, nullptr if there is no rxn,
+  // both species must be already instantiated
+  BNG::RxnClass* get_bimol_rxn_class(
+      BNG::RxnContainer& all_rxns, const species_id_t species_id1, const species_id_t species_id2) {
+
+    uint index1 = get_species_index(species_id1);
+    uint index2 = get_species_index(species_id2);
+    if (index1 == UINT_INVALID || index2 == UINT_INVALID) {
+      // species was instantiated in a different partition
+      add_species(species_id1);
+      add_species(species_id2);
+      index1 = get_species_index(species_id1);
+      index2 = get_species_index(species_id2);
+      if (index1 == UINT_INVALID || index2 == UINT_INVALID) {
+        // table is full
+        return all_rxns.get_bimol_rxn_class(species_id1, species_id2);
+      }
+    }
+
+    BNG::RxnClass*& rxn_class = rxn_classes[index1 * table_dim + index2];
+    if (rxn_class == get_not_cached_marker()) {
+      rxn_class = all_rxns.get_bimol_rxn_class(species_id1, species_id2);
+    }
+    return rxn_class;
+  }
+
+  // assigns a compact index to a species, called when a molecule of a species
+  // that was not instantiated yet is added, does nothing if the species already has an index
+  void add_species(const species_id_t species_id);
+
+  void clear() {
+    species_index_per_species_id.clear();
+    rxn_classes.clear();
+    num_species = 0;
+    table_dim = 0;
+  }
+
+private:
+  uint get_species_index(const species_id_t species_id) const {
+    return (species_id < species_index_per_species_id.size()) ?
+        species_index_per_species_id[species_id] : UINT_INVALID;
+  }
+
+  // nullptr means that there is no rxn, items that were not looked up yet use this value
+  static BNG::RxnClass* get_not_cached_marker() {
+    static char marker;
+    return reinterpret_cast<BNG::RxnClass*>(&marker);
+  }
+
+  // indexed by species_id_t, UINT_INVALID for species without an index
+  std::vector<uint> species_index_per_species_id;
+
+  uint num_species;
+
+  // number of rows and columns of the table, grows by doubling
+  uint table_dim;
+
+  // table_dim x table_dim items, row is given by the first species
+  std::vector<BNG::RxnClass*> rxn_classes;
+};
+
+} // namespace MCell
+
+#endif // SRC4_SPECIES_PAIR_RXN_CLASS_CACHE_H_
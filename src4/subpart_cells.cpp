@@ -0,0 +1,139 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include "subpart_cells.h"
+
+using namespace std;
+
+namespace MCell {
+
+static uint get_block_index(const IVec3& indices, const uint num_blocks_per_edge) {
+  return
+      indices.x +
+      indices.y * num_blocks_per_edge +
+      indices.z * num_blocks_per_edge * num_blocks_per_edge;
+}
+
+
+void SubpartCells::build_count_pyramid(
+    const std::vector<uint>& molecule_count_per_subpart,
+    const std::vector<uint>& wall_count_per_subpart,
+    std::vector<CountPyramidLevel>& pyramid) const {
+
+  pyramid.clear();
+  pyramid.push_back(CountPyramidLevel());
+  pyramid.back().num_blocks_per_edge = num_subparts_per_edge;
+  pyramid.back().molecule_counts = molecule_count_per_subpart;
+  pyramid.back().wall_counts = wall_count_per_subpart;
+
+  // each level halves the number of blocks along each edge until there is a single block
+  while (pyramid.back().num_blocks_per_edge > 1) {
+    uint prev_level = pyramid.size() - 1;
+    uint prev_dim = pyramid[prev_level].num_blocks_per_edge;
+    uint dim = (prev_dim + 1) / 2;
+
+    pyramid.push_back(CountPyramidLevel());
+    CountPyramidLevel& level = pyramid.back();
+    const CountPyramidLevel& prev = pyramid[prev_level];
+    level.num_blocks_per_edge = dim;
+    level.molecule_counts.resize(dim * dim * dim, 0);
+    level.wall_counts.resize(dim * dim * dim, 0);
+
+    for (uint z = 0; z < prev_dim; z++) {
+      for (uint y = 0; y < prev_dim; y++) {
+        for (uint x = 0; x < prev_dim; x++) {
+          uint prev_index = get_block_index(IVec3(x, y, z), prev_dim);
+          uint index = get_block_index(IVec3(x / 2, y / 2, z / 2), dim);
+          level.molecule_counts[index] += prev.molecule_counts[prev_index];
+          level.wall_counts[index] += prev.wall_counts[prev_index];
+        }
+      }
+    }
+  }
+}
+
+
+void SubpartCells::assign_cells(
+    const std::vector<CountPyramidLevel>& pyramid,
+    const uint level, const IVec3& block_indices,
+    std::vector<uint>& new_cell_index_per_subpart, uint& new_num_cells) const {
+
+  const CountPyramidLevel& current = pyramid[level];
+  uint block_index = get_block_index(block_indices, current.num_blocks_per_edge);
+
+  bool split =
+      level > 0 &&
+      (current.molecule_counts[block_index] > SUBPART_CELL_MAX_MOLECULES ||
+       current.wall_counts[block_index] > SUBPART_CELL_MAX_WALLS);
+
+  if (split) {
+    uint child_dim = pyramid[level - 1].num_blocks_per_edge;
+    for (int z = 0; z < 2; z++) {
+      for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+          IVec3 child(block_indices * IVec3(2) + IVec3(x, y, z));
+          if (child.x < (int)child_dim && child.y < (int)child_dim && child.z < (int)child_dim) {
+            assign_cells(pyramid, level - 1, child, new_cell_index_per_subpart, new_num_cells);
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  // leaf, all subparts of this block belong to a new cell
+  uint cell_index = new_num_cells;
+  new_num_cells++;
+
+  uint block_edge = 1 << level;
+  IVec3 llf(block_indices * IVec3(block_edge));
+  IVec3 urb(glm::min((glm_ivec3_t)(llf + IVec3(block_edge)), (glm_ivec3_t)IVec3(num_subparts_per_edge)));
+  for (int z = llf.z; z < urb.z; z++) {
+    for (int y = llf.y; y < urb.y; y++) {
+      for (int x = llf.x; x < urb.x; x++) {
+        new_cell_index_per_subpart[get_block_index(IVec3(x, y, z), num_subparts_per_edge)] = cell_index;
+      }
+    }
+  }
+}
+
+
+bool SubpartCells::rebuild(
+    const std::vector<uint>& molecule_count_per_subpart,
+    const std::vector<uint>& wall_count_per_subpart) {
+
+  uint num_subparts = powu(num_subparts_per_edge, 3);
+  assert(molecule_count_per_subpart.size() == num_subparts);
+  assert(wall_count_per_subpart.size() == num_subparts);
+
+  vector<CountPyramidLevel> pyramid;
+  build_count_pyramid(molecule_count_per_subpart, wall_count_per_subpart, pyramid);
+
+  vector<uint> new_cell_index_per_subpart(num_subparts, UINT_INVALID);
+  uint new_num_cells = 0;
+  assign_cells(pyramid, pyramid.size() - 1, IVec3(0), new_cell_index_per_subpart, new_num_cells);
+  assert(new_num_cells <= num_subparts);
+
+  if (new_num_cells == num_subparts) {
+    // each subpart is its own cell, use identity so that cell and subpart indices are the same
+    new_cell_index_per_subpart.clear();
+  }
+
+  if (new_cell_index_per_subpart == cell_index_per_subpart) {
+    return false;
+  }
+
+  cell_index_per_subpart.swap(new_cell_index_per_subpart);
+  num_cells = new_num_cells;
+  return true;
+}
+
+} // namespace MCell
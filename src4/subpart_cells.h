@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_SUBPART_CELLS_H_
+#define SRC4_SUBPART_CELLS_H_
+
+#include <vector>
+
+#include "defines.h"
+
+namespace MCell {
+
+/*
+ * Maps subpartitions to cells of an adaptive octree built over the uniform subpartition grid.
+ *
+ * Each leaf of the octree is a cube of 2^k x 2^k x 2^k subpartitions (clipped by the
+ * partition boundary) and gets its own cell index. A cube is split into octants as long as
+ * it contains more molecules or walls than allowed, so crowded regions use single subpartitions
+ * as cells and empty regions are covered by a few large cells.
+ *
+ * Per-subpartition data such as reactant sets and walls are stored per cell, a cell contains
+ * data of all its subpartitions. When no octree was built yet, each subpartition is its own cell.
+ */
+class SubpartCells {
+public:
+  SubpartCells()
+    : num_subparts_per_edge(0), num_cells(0) {
+  }
+
+  void init(const uint num_subparts_per_edge_) {
+    num_subparts_per_edge = num_subparts_per_edge_;
+    num_cells = powu(num_subparts_per_edge, 3);
+    cell_index_per_subpart.clear();
+  }
+
+  uint get_cell_index(const subpart_index_t subpart_index) const {
+    if (cell_index_per_subpart.empty()) {
+      return subpart_index;
+    }
+    else {
+      assert(subpart_index < cell_index_per_subpart.size());
+      return cell_index_per_subpart[subpart_index];
+    }
+  }
+
+  uint get_num_cells() const {
+    return num_cells;
+  }
+
+  // true when at least one cell contains more than one subpartition
+  bool has_merged_subparts() const {
+    return !cell_index_per_subpart.empty();
+  }
+
+  // - counts are indexed by subpart_index_t
+  // - returns true if the mapping changed, data stored per cell must be then rebuilt
+  bool rebuild(
+      const std::vector<uint>& molecule_count_per_subpart,
+      const std::vector<uint>& wall_count_per_subpart);
+
+private:
+  // sums of counts over aligned blocks of 2^level subparts along each edge
+  struct CountPyramidLevel {
+    uint num_blocks_per_edge;
+    std::vector<uint> molecule_counts;
+    std::vector<uint> wall_counts;
+  };
+
+  void build_count_pyramid(
+      const std::vector<uint>& molecule_count_per_subpart,
+      const std::vector<uint>& wall_count_per_subpart,
+      std::vector<CountPyramidLevel>& pyramid) const;
+
+  void assign_cells(
+      const std::vector<CountPyramidLevel>& pyramid,
+      const uint level, const IVec3& block_indices,
+      std::vector<uint>& new_cell_index_per_subpart, uint& new_num_cells) const;
+
+  uint num_subparts_per_edge;
+  uint num_cells;
+
+  // indexed by subpart_index_t, empty when each subpart is its own cell
+  std::vector<uint> cell_index_per_subpart;
+};
+
+} // namespace MCell
+
+#endif // SRC4_SUBPART_CELLS_H_
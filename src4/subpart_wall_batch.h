@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_SUBPART_WALL_BATCH_H_
+#define SRC4_SUBPART_WALL_BATCH_H_
+
+#include <vector>
+
+#include "defines.h"
+#include "wall.h"
+
+namespace MCell {
+
+// number of walls tested together by SubpartWallBatch::collect_candidate_walls,
+// the inner loop has a fixed length so that compilers can vectorize it
+const uint WALL_BATCH_SIZE = 8;
+
+/*
+ * Packed copy of WallCollisionRejectionData of all walls in a subpart stored as
+ * structure of arrays, walls are in the same order as in the subpart's WallsInSubpart,
+ * arrays are padded to a multiple of WALL_BATCH_SIZE with walls that are always rejected.
+ */
+class SubpartWallBatch {
+public:
+  // WallIndices is a container of wall_index_t such as WallsInSubpart
+  template<class WallIndices>
+  void update(
+      const WallIndices& subpart_wall_indices,
+      const std::vector<WallCollisionRejectionData>& rejection_data) {
+
+    size_t num_walls = subpart_wall_indices.size();
+    size_t padded_size = (num_walls + WALL_BATCH_SIZE - 1) / WALL_BATCH_SIZE * WALL_BATCH_SIZE;
+
+    wall_indices.clear();
+    normal_x.clear();
+    normal_y.clear();
+    normal_z.clear();
+    distance_to_origin.clear();
+    if (padded_size == 0) {
+      return;
+    }
+
+    wall_indices.reserve(padded_size);
+    normal_x.reserve(padded_size);
+    normal_y.reserve(padded_size);
+    normal_z.reserve(padded_size);
+    distance_to_origin.reserve(padded_size);
+
+    for (wall_index_t wi: subpart_wall_indices) {
+      assert(wi < rejection_data.size());
+      const WallCollisionRejectionData& d = rejection_data[wi];
+      wall_indices.push_back(wi);
+      normal_x.push_back(d.normal.x);
+      normal_y.push_back(d.normal.y);
+      normal_z.push_back(d.normal.z);
+      distance_to_origin.push_back(d.distance_to_origin);
+    }
+
+    // zero normal and negative distance means that the start and the end
+    // are always above the plane
+    while (wall_indices.size() < padded_size) {
+      wall_indices.push_back(WALL_INDEX_INVALID);
+      normal_x.push_back(0);
+      normal_y.push_back(0);
+      normal_z.push_back(0);
+      distance_to_origin.push_back(-1);
+    }
+  }
+
+  // - appends walls that collide_wall would not reject right away because the start and the end
+  //   of the move lie on the same side of their plane, uses the same arithmetic as collide_wall,
+  //   the order of candidates is the same as in WallsInSubpart
+  // - excluded_wall_index is skipped
+  // - returns the number of rejected walls
+  uint collect_candidate_walls(
+      const Vec3& pos, const Vec3& move, const wall_index_t excluded_wall_index,
+      WallIndicesVector& candidates) const {
+
+    uint num_rejected = 0;
+    for (size_t base = 0; base < wall_indices.size(); base += WALL_BATCH_SIZE) {
+
+      bool may_collide[WALL_BATCH_SIZE];
+      for (uint i = 0; i < WALL_BATCH_SIZE; i++) {
+        size_t k = base + i;
+        pos_t dp = normal_x[k] * pos.x + normal_y[k] * pos.y + normal_z[k] * pos.z;
+        pos_t dv = normal_x[k] * move.x + normal_y[k] * move.y + normal_z[k] * move.z;
+        pos_t dd = dp - distance_to_origin[k];
+
+        pos_t d_eps_above = (dd < POS_EPS) ? (pos_t)0.5 * dd : POS_EPS;
+        pos_t d_eps_below = (dd > -POS_EPS) ? (pos_t)0.5 * dd : -POS_EPS;
+
+        bool above = dd > 0 && dd + dv > d_eps_above;
+        bool below = dd < 0 && dd + dv < d_eps_below;
+        may_collide[i] = !above && !below;
+      }
+
+      for (uint i = 0; i < WALL_BATCH_SIZE; i++) {
+        wall_index_t wi = wall_indices[base + i];
+        if (wi == WALL_INDEX_INVALID || wi == excluded_wall_index) {
+          continue;
+        }
+        if (may_collide[i]) {
+          candidates.push_back(wi);
+        }
+        else {
+          num_rejected++;
+        }
+      }
+    }
+    return num_rejected;
+  }
+
+private:
+  std::vector<wall_index_t> wall_indices;
+  std::vector<pos_t> normal_x;
+  std::vector<pos_t> normal_y;
+  std::vector<pos_t> normal_z;
+  std::vector<pos_t> distance_to_origin;
+};
+
+} // namespace MCell
+
+#endif // SRC4_SUBPART_WALL_BATCH_H_
@@ -0,0 +1,117 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include <atomic>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace MCell {
+
+ThreadPool::ThreadPool(const uint num_threads_)
+  : num_threads(num_threads_),
+    current_func(nullptr),
+    generation(0),
+    num_workers_running(0),
+    terminate(false) {
+
+  release_assert(num_threads >= 1);
+  for (uint i = 1; i < num_threads; i++) {
+    workers.push_back(thread(&ThreadPool::worker_loop, this, i));
+  }
+}
+
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mtx);
+    terminate = true;
+  }
+  work_available.notify_all();
+
+  for (thread& t: workers) {
+    t.join();
+  }
+}
+
+
+void ThreadPool::run_on_all_threads(const std::function<void(const uint)>& func) {
+  if (workers.empty()) {
+    func(0);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(mtx);
+    assert(current_func == nullptr && "Recursive call of run_on_all_threads");
+    current_func = &func;
+    num_workers_running = workers.size();
+    generation++;
+  }
+  work_available.notify_all();
+
+  // the calling thread does its part of the work too
+  func(0);
+
+  unique_lock<mutex> lock(mtx);
+  work_finished.wait(lock, [this] { return num_workers_running == 0; });
+  current_func = nullptr;
+}
+
+
+void ThreadPool::run_for_each_index(
+    ThreadPool* thread_pool, const uint num_indices, const std::function<void(const uint)>& func) {
+
+  if (thread_pool == nullptr || thread_pool->workers.empty()) {
+    for (uint i = 0; i < num_indices; i++) {
+      func(i);
+    }
+    return;
+  }
+
+  atomic<uint> next_index(0);
+  thread_pool->run_on_all_threads(
+      [&](const uint) {
+        for (uint i = next_index++; i < num_indices; i = next_index++) {
+          func(i);
+        }
+      }
+  );
+}
+
+
+void ThreadPool::worker_loop(const uint thread_index) {
+  uint64_t last_generation = 0;
+
+  while (true) {
+    const std::function<void(const uint)>* func;
+    {
+      unique_lock<mutex> lock(mtx);
+      work_available.wait(lock, [this, last_generation] { return terminate || generation != last_generation; });
+      if (terminate) {
+        return;
+      }
+      last_generation = generation;
+      func = current_func;
+    }
+
+    (*func)(thread_index);
+
+    {
+      lock_guard<mutex> lock(mtx);
+      num_workers_running--;
+    }
+    work_finished.notify_one();
+  }
+}
+
+} // namespace MCell
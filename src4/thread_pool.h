@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_THREAD_POOL_H_
+#define SRC4_THREAD_POOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "defines.h"
+
+namespace MCell {
+
+/*
+ * Fixed set of worker threads that execute the same function,
+ * the calling thread participates as the thread with index 0.
+ */
+class ThreadPool {
+public:
+  // creates num_threads_ - 1 worker threads
+  ThreadPool(const uint num_threads_);
+
+  ~ThreadPool();
+
+  uint get_num_threads() const {
+    return num_threads;
+  }
+
+  // calls func(thread_index) for each thread_index in 0..num_threads-1 in parallel,
+  // returns once all calls finished, must not be called recursively
+  void run_on_all_threads(const std::function<void(const uint)>& func);
+
+  // calls func(index) for each index in 0..num_indices-1, threads pick the next index once they
+  // finish the previous one, so the work may differ between indices,
+  // the calls are done serially when thread_pool is nullptr
+  static void run_for_each_index(
+      ThreadPool* thread_pool, const uint num_indices, const std::function<void(const uint)>& func);
+
+private:
+  void worker_loop(const uint thread_index);
+
+  uint num_threads;
+  std::vector<std::thread> workers;
+
+  std::mutex mtx;
+  std::condition_variable work_available;
+  std::condition_variable work_finished;
+
+  // guarded by mtx
+  const std::function<void(const uint)>* current_func;
+  uint64_t generation; // incremented with each run_on_all_threads call
+  uint num_workers_running;
+  bool terminate;
+};
+
+} // namespace MCell
+
+#endif // SRC4_THREAD_POOL_H_
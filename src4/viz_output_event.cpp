@@ -23,6 +23,7 @@
 #include "mcell_structs_shared.h"
 
 #include "viz_output_event.h"
+#include "viz_output_writer.h"
 #include "geometry.h"
 #include "world.h"
 #include "datamodel_defines.h"
@@ -46,18 +47,23 @@ void VizOutputEvent::dump(const std::string ind) const {
 
 
 void VizOutputEvent::step() {
-  switch (viz_mode) {
-    case NO_VIZ_MODE:
-      break;
-    case ASCII_MODE:
-      output_ascii_molecules();
-      break;
-    case CELLBLENDER_MODE_V1:
-    case CELLBLENDER_MODE_V2:
-      output_cellblender_molecules();
-      break;
-    default:
-      assert(false);
+  if (viz_mode == NO_VIZ_MODE) {
+    return;
+  }
+
+  VizOutputWriter* writer = world->get_viz_output_writer();
+  if (writer != nullptr) {
+    // only copy the data, the file is written in the background
+    VizFrame* frame = writer->acquire_frame();
+    fill_frame(*frame);
+    writer->submit_frame(frame);
+  }
+  else {
+    sync_frame.clear();
+    fill_frame(sync_frame);
+    if (!VizOutputWriter::write_frame(sync_frame)) {
+      mcell_die();
+    }
   }
 }
 
@@ -76,10 +82,7 @@ string VizOutputEvent::iterations_to_string(const uint64_t current_iterations, c
 }
 
 
-FILE* VizOutputEvent::create_and_open_output_file_name() {
-
-  long long current_iteration = round(event_time); // NOTE: usage of round might be a little shaky here, maybe we will need a better way how to get the iteration index
-  //fprintf(stderr, "***dumps: %lld\n", current_iteration);
+string VizOutputEvent::get_output_file_name() {
   const char* type_name = (viz_mode == ASCII_MODE) ? "ascii" : "cellbin";
   char* cf_name = CHECKED_SPRINTF(
       "%s.%s.%s.dat",
@@ -88,16 +91,27 @@ FILE* VizOutputEvent::create_and_open_output_file_name() {
       iterations_to_string(world->stats.get_current_iteration(), world->total_iterations).c_str()
    );
   assert(cf_name != nullptr);
+  string res = cf_name;
+  free(cf_name);
+  return res;
+}
 
-  FSUtils::make_dir_for_file_w_multiple_attempts(cf_name);
-  FILE *custom_file = ::open_file(cf_name, (viz_mode == ASCII_MODE) ? "w" : "wb");
-  if (custom_file == nullptr)
-    mcell_die();
-  else {
-    no_printf("Writing to file %s\n", cf_name);
+
+void VizOutputEvent::fill_frame(VizFrame& frame) {
+  frame.viz_mode = viz_mode;
+  frame.file_name = get_output_file_name();
+
+  switch (viz_mode) {
+    case ASCII_MODE:
+      fill_ascii_frame(frame);
+      break;
+    case CELLBLENDER_MODE_V1:
+    case CELLBLENDER_MODE_V2:
+      fill_cellblender_frame(frame);
+      break;
+    default:
+      assert(false);
   }
-  free(cf_name);
-  return custom_file;
 }
 
 
@@ -129,9 +143,8 @@ void VizOutputEvent::compute_where_and_norm(
 }
 
 
-void VizOutputEvent::output_ascii_molecules() {
+void VizOutputEvent::fill_ascii_frame(VizFrame& frame) {
   // assuming that fdlp->type == ALL_MOL_DATA
-  FILE *custom_file = create_and_open_output_file_name();
 
   // simply go through all partitions and dump all molecules
   for (Partition& p: world->get_partitions()) {
@@ -147,35 +160,23 @@ void VizOutputEvent::output_ascii_molecules() {
       Vec3 norm;
       compute_where_and_norm(p, m, where, norm);
 
+      // consecutive molecules of the same species share a block
       const BNG::Species& species = world->get_all_species().get(m.species_id);
+      if (frame.blocks.empty() || frame.blocks.back().species_name != species.name) {
+        uint begin = frame.ids.size();
+        frame.blocks.push_back(VizFrameBlock{species.name, species.is_surf(), begin, begin});
+      }
 
-      // cast to double for printouts
-      glm::dvec3 dwhere = where;
-      glm::dvec3 dnorm = norm;
-      assert(sizeof(dwhere.x) == sizeof(double));
-
-      errno = 0;
-      fprintf(custom_file, "%s %u %.9g %.9g %.9g %.9g %.9g %.9g\n",
-          species.name.c_str(), m.id,
-          dwhere.x, dwhere.y, dwhere.z,
-          dnorm.x, dnorm.y, dnorm.z
-      );
-      assert(errno == 0);
+      frame.ids.push_back(m.id);
+      frame.positions.push_back(where);
+      frame.norms.push_back(norm);
+      frame.blocks.back().end++;
     }
   }
-
-  errno = 0;
-  fclose(custom_file);
-  assert(errno == 0);
 }
 
 
-void VizOutputEvent::output_cellblender_molecules() {
-  assert(sizeof(u_int) == sizeof(uint));
-
-  FILE *custom_file = create_and_open_output_file_name();
-  double length_unit = world->config.length_unit;
-
+void VizOutputEvent::fill_cellblender_frame(VizFrame& frame) {
   // sort all molecules by species
   typedef pair<const Partition*, const Molecule*> PartitionMoleculePair;
 
@@ -194,88 +195,32 @@ void VizOutputEvent::output_cellblender_molecules() {
     }
   }
 
-  /* Write file header */
-  uint ver = (viz_mode == CELLBLENDER_MODE_V2) ? 2 : 1;
-  fwrite(&ver, sizeof(uint), 1, custom_file);
-
   /* Write all the molecules whether EXTERNAL_SPECIES or not (for now) */
-  for (species_id_t species_idx = 0; species_idx < world->get_all_species().get_count(); species_idx++) {
-    // count of molecules for this species
-    vector<PartitionMoleculePair>& species_molecules = volume_molecules_by_species[species_idx];
+  for (auto& species_molecules_pair: volume_molecules_by_species) {
+    // map is ordered by species id
+    vector<PartitionMoleculePair>& species_molecules = species_molecules_pair.second;
     if (species_molecules.empty()) {
       continue;
     }
 
-    /* Write species name: */
-    const BNG::Species& species = world->get_all_species().get(species_idx);
-    string mol_name = species.name;
-    if (ver == 1) {
-      unsigned char name_len = mol_name.length();
-      fwrite(&name_len, sizeof(unsigned char), 1, custom_file);
-    }
-    else {
-      uint name_len = mol_name.length();
-      fwrite(&name_len, sizeof(uint), 1, custom_file);
-    }
-    fwrite(mol_name.c_str(), sizeof(char), mol_name.length(), custom_file);
-
-     /* Write species type: */
-    unsigned char species_type = 0;
-    if (species.is_surf()) {
-      species_type = 1;
-    }
-    fwrite(&species_type, sizeof(unsigned char), 1, custom_file);
+    const BNG::Species& species = world->get_all_species().get(species_molecules_pair.first);
+    uint begin = frame.ids.size();
+    frame.blocks.push_back(
+        VizFrameBlock{species.name, species.is_surf(), begin, (uint)(begin + species_molecules.size())});
 
-    /* write number of x,y,z floats for mol positions to follow: */
-    if (ver == 1) {
-      uint n_floats = 3 * species_molecules.size();
-      fwrite(&n_floats, sizeof(uint), 1, custom_file);
-    }
-    else {
-      uint n_mols = species_molecules.size();
-      fwrite(&n_mols, sizeof(uint), 1, custom_file);
-    }
+    for (const PartitionMoleculePair& partition_molecule_ptr_pair: species_molecules) {
+      frame.ids.push_back(partition_molecule_ptr_pair.second->id);
 
-    /* Write molecule ids: */
-    if (ver == 2) {
-      for (const PartitionMoleculePair& partition_molecule_ptr_pair :species_molecules) {
-        fwrite(&partition_molecule_ptr_pair.second->id, sizeof(uint), 1, custom_file);
-      }
-    }
-
-    /* Write positions of volume and surface molecules: */
-    std::vector<Vec3> norms;
-    for (const PartitionMoleculePair& partition_molecule_ptr_pair :species_molecules) {
       Vec3 where;
       Vec3 norm;
       compute_where_and_norm(
           *partition_molecule_ptr_pair.first, *partition_molecule_ptr_pair.second,
           where, norm
       );
-
-      // the values are always stored as float
-      glm::fvec3 fwhere = where;
-      assert(sizeof(fwhere.x) == sizeof(float));
-
-      fwrite(&fwhere.x, sizeof(float), 1, custom_file);
-      fwrite(&fwhere.y, sizeof(float), 1, custom_file);
-      fwrite(&fwhere.z, sizeof(float), 1, custom_file);
-
-      if (species.is_surf()) {
-        norms.push_back(norm);
-      }
-    }
-
-    // store norm - presence of this information is determined by species_type
-    for (const Vec3& norm :norms) {
-      glm::fvec3 fnorm = norm;
-      fwrite(&fnorm.x, sizeof(float), 1, custom_file);
-      fwrite(&fnorm.y, sizeof(float), 1, custom_file);
-      fwrite(&fnorm.z, sizeof(float), 1, custom_file);
+      frame.positions.push_back(where);
+      frame.norms.push_back(norm);
     }
   }
-
-  fclose(custom_file);
 }
 
 
@@ -15,6 +15,7 @@
 
 #include "base_event.h"
 #include "mcell_structs_shared.h"
+#include "viz_output_writer.h"
 
 namespace MCell {
 
@@ -57,9 +58,15 @@ private:
       Vec3& where, Vec3& norm
   );
 
-  FILE* create_and_open_output_file_name();
-  void output_ascii_molecules();
-  void output_cellblender_molecules();
+  std::string get_output_file_name();
+
+  // copies everything needed to write the output file into frame
+  void fill_frame(VizFrame& frame);
+  void fill_ascii_frame(VizFrame& frame);
+  void fill_cellblender_frame(VizFrame& frame);
+
+  // reused by each step when files are written synchronously
+  VizFrame sync_frame;
 };
 
 } // namespace mcell
@@ -0,0 +1,244 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include <stdio.h>
+#include <errno.h>
+
+#include "logging.h"
+#include "util.h"
+
+#include "viz_output_writer.h"
+
+#include "bng/filesystem_utils.h"
+
+using namespace std;
+
+namespace MCell {
+
+VizOutputWriter::VizOutputWriter(const uint max_pending_frames_)
+  : terminate(false) {
+
+  release_assert(max_pending_frames_ >= 1);
+  frames.resize(max_pending_frames_ + 1);
+  for (VizFrame& f: frames) {
+    free_frames.push_back(&f);
+  }
+
+  writer = thread(&VizOutputWriter::writer_loop, this);
+}
+
+
+VizOutputWriter::~VizOutputWriter() {
+  // errors were already reported by open_file,
+  // the simulation ends anyway
+  wait_for_pending_frames();
+
+  {
+    lock_guard<mutex> lock(mtx);
+    terminate = true;
+  }
+  frame_submitted.notify_one();
+
+  writer.join();
+}
+
+
+VizFrame* VizOutputWriter::acquire_frame() {
+  unique_lock<mutex> lock(mtx);
+  frame_written.wait(lock, [this] { return !free_frames.empty(); });
+
+  VizFrame* res = free_frames.back();
+  free_frames.pop_back();
+  res->clear();
+  return res;
+}
+
+
+void VizOutputWriter::submit_frame(VizFrame* frame) {
+  assert(frame != nullptr);
+  {
+    lock_guard<mutex> lock(mtx);
+    pending_frames.push_back(frame);
+  }
+  frame_submitted.notify_one();
+
+  terminate_if_write_failed();
+}
+
+
+void VizOutputWriter::wait_until_all_written() {
+  wait_for_pending_frames();
+  terminate_if_write_failed();
+}
+
+
+void VizOutputWriter::wait_for_pending_frames() {
+  unique_lock<mutex> lock(mtx);
+  frame_written.wait(lock, [this] { return pending_frames.empty(); });
+}
+
+
+void VizOutputWriter::terminate_if_write_failed() {
+  string file_name;
+  {
+    lock_guard<mutex> lock(mtx);
+    file_name = failed_file_name;
+  }
+  if (file_name != "") {
+    mcell_error("Could not write visualization output file %s, terminating.", file_name.c_str());
+  }
+}
+
+
+void VizOutputWriter::writer_loop() {
+  while (true) {
+    VizFrame* frame;
+    {
+      unique_lock<mutex> lock(mtx);
+      frame_submitted.wait(lock, [this] { return terminate || !pending_frames.empty(); });
+      if (pending_frames.empty()) {
+        // terminate is set and there is nothing more to write
+        return;
+      }
+      frame = pending_frames.front();
+    }
+
+    bool ok = write_frame(*frame);
+
+    {
+      lock_guard<mutex> lock(mtx);
+      if (!ok && failed_file_name == "") {
+        failed_file_name = frame->file_name;
+      }
+      pending_frames.pop_front();
+      free_frames.push_back(frame);
+    }
+    frame_written.notify_all();
+  }
+}
+
+
+bool VizOutputWriter::write_frame(const VizFrame& frame) {
+  assert(frame.viz_mode != NO_VIZ_MODE);
+
+  FSUtils::make_dir_for_file_w_multiple_attempts(frame.file_name.c_str());
+  FILE *custom_file = ::open_file(frame.file_name.c_str(), (frame.viz_mode == ASCII_MODE) ? "w" : "wb");
+  if (custom_file == nullptr) {
+    // error was already printed
+    return false;
+  }
+  else {
+    no_printf("Writing to file %s\n", frame.file_name.c_str());
+  }
+
+  if (frame.viz_mode == ASCII_MODE) {
+    write_ascii_frame(frame, custom_file);
+  }
+  else {
+    write_cellblender_frame(frame, custom_file);
+  }
+
+  errno = 0;
+  fclose(custom_file);
+  assert(errno == 0);
+  return true;
+}
+
+
+void VizOutputWriter::write_ascii_frame(const VizFrame& frame, FILE* f) {
+  for (const VizFrameBlock& block: frame.blocks) {
+    for (uint i = block.begin; i < block.end; i++) {
+      // cast to double for printouts
+      glm::dvec3 dwhere = frame.positions[i];
+      glm::dvec3 dnorm = frame.norms[i];
+      assert(sizeof(dwhere.x) == sizeof(double));
+
+      errno = 0;
+      fprintf(f, "%s %u %.9g %.9g %.9g %.9g %.9g %.9g\n",
+          block.species_name.c_str(), frame.ids[i],
+          dwhere.x, dwhere.y, dwhere.z,
+          dnorm.x, dnorm.y, dnorm.z
+      );
+      assert(errno == 0);
+    }
+  }
+}
+
+
+void VizOutputWriter::write_cellblender_frame(const VizFrame& frame, FILE* f) {
+  assert(sizeof(u_int) == sizeof(uint));
+
+  /* Write file header */
+  uint ver = (frame.viz_mode == CELLBLENDER_MODE_V2) ? 2 : 1;
+  fwrite(&ver, sizeof(uint), 1, f);
+
+  // the values are always stored as float,
+  // converted per species so that each species needs just one fwrite
+  vector<float> float_buffer;
+
+  for (const VizFrameBlock& block: frame.blocks) {
+    uint num_mols = block.end - block.begin;
+    assert(num_mols > 0);
+
+    /* Write species name: */
+    const string& mol_name = block.species_name;
+    if (ver == 1) {
+      unsigned char name_len = mol_name.length();
+      fwrite(&name_len, sizeof(unsigned char), 1, f);
+    }
+    else {
+      uint name_len = mol_name.length();
+      fwrite(&name_len, sizeof(uint), 1, f);
+    }
+    fwrite(mol_name.c_str(), sizeof(char), mol_name.length(), f);
+
+     /* Write species type: */
+    unsigned char species_type = block.is_surf ? 1 : 0;
+    fwrite(&species_type, sizeof(unsigned char), 1, f);
+
+    /* write number of x,y,z floats for mol positions to follow: */
+    if (ver == 1) {
+      uint n_floats = 3 * num_mols;
+      fwrite(&n_floats, sizeof(uint), 1, f);
+    }
+    else {
+      fwrite(&num_mols, sizeof(uint), 1, f);
+    }
+
+    /* Write molecule ids: */
+    if (ver == 2) {
+      static_assert(sizeof(molecule_id_t) == sizeof(uint), "Molecule ids are stored as uint");
+      fwrite(&frame.ids[block.begin], sizeof(uint), num_mols, f);
+    }
+
+    /* Write positions of volume and surface molecules: */
+    float_buffer.clear();
+    for (uint i = block.begin; i < block.end; i++) {
+      glm::fvec3 fwhere = frame.positions[i];
+      float_buffer.push_back(fwhere.x);
+      float_buffer.push_back(fwhere.y);
+      float_buffer.push_back(fwhere.z);
+    }
+
+    // store norm - presence of this information is determined by species_type
+    if (block.is_surf) {
+      for (uint i = block.begin; i < block.end; i++) {
+        glm::fvec3 fnorm = frame.norms[i];
+        float_buffer.push_back(fnorm.x);
+        float_buffer.push_back(fnorm.y);
+        float_buffer.push_back(fnorm.z);
+      }
+    }
+    fwrite(float_buffer.data(), sizeof(float), float_buffer.size(), f);
+  }
+}
+
+} // namespace MCell
@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_VIZ_OUTPUT_WRITER_H_
+#define SRC4_VIZ_OUTPUT_WRITER_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <string>
+
+#include "defines.h"
+
+namespace MCell {
+
+// consecutive molecules of a VizFrame that belong to the same species
+struct VizFrameBlock {
+  std::string species_name;
+  bool is_surf;
+  // range of indices into VizFrame::ids, positions and norms
+  uint begin;
+  uint end;
+};
+
+/*
+ * Copy of all data needed to write one visualization output file,
+ * does not reference any simulation data so it can be written while the simulation continues.
+ */
+class VizFrame {
+public:
+  VizFrame()
+    : viz_mode(NO_VIZ_MODE) {
+  }
+
+  // keeps allocated memory so that the frame can be reused
+  void clear() {
+    file_name.clear();
+    blocks.clear();
+    ids.clear();
+    positions.clear();
+    norms.clear();
+  }
+
+  viz_mode_t viz_mode;
+  std::string file_name;
+
+  // one block per species for cellblender modes,
+  // for ascii mode the blocks follow the order of molecules in partitions
+  std::vector<VizFrameBlock> blocks;
+
+  std::vector<molecule_id_t> ids;
+  std::vector<Vec3> positions; // already scaled by length unit
+  std::vector<Vec3> norms; // zero for volume molecules
+};
+
+
+/*
+ * Writes visualization frames in a background thread.
+ *
+ * There are max_pending_frames_ + 1 frames that are reused, one is being filled by the simulation
+ * and the rest waits to be written, acquire_frame blocks when all of them are pending.
+ */
+class VizOutputWriter {
+public:
+  VizOutputWriter(const uint max_pending_frames_);
+
+  // writes all pending frames
+  ~VizOutputWriter();
+
+  // returns an empty frame, blocks until a frame is available
+  VizFrame* acquire_frame();
+
+  // frame must have been obtained with acquire_frame,
+  // the writer owns the frame again after this call,
+  // terminates the simulation if a previously submitted frame could not be written
+  void submit_frame(VizFrame* frame);
+
+  // blocks until all submitted frames were written,
+  // terminates the simulation if any of them could not be written
+  void wait_until_all_written();
+
+  // writes frame in the calling thread, returns false if the file could not be opened
+  static bool write_frame(const VizFrame& frame);
+
+private:
+  // waits without checking for errors
+  void wait_for_pending_frames();
+
+  // must be called from the simulation thread, mcell_error must not be called
+  // from the writer thread while the simulation is running
+  void terminate_if_write_failed();
+
+  static void write_ascii_frame(const VizFrame& frame, FILE* f);
+  static void write_cellblender_frame(const VizFrame& frame, FILE* f);
+
+  void writer_loop();
+
+  std::vector<VizFrame> frames;
+  std::thread writer;
+
+  std::mutex mtx;
+  std::condition_variable frame_submitted;
+  std::condition_variable frame_written;
+
+  // guarded by mtx
+  std::vector<VizFrame*> free_frames;
+  std::deque<VizFrame*> pending_frames; // includes the frame being written
+  bool terminate;
+  // name of the first file that could not be written, empty when there was no error
+  std::string failed_file_name;
+};
+
+} // namespace MCell
+
+#endif // SRC4_VIZ_OUTPUT_WRITER_H_
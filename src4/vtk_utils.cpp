@@ -31,6 +31,7 @@
 #include "logging.h"
 
 #include "world.h"
+#include "thread_pool.h"
 #include "partition.h"
 #include "geometry.h"
 
@@ -137,21 +138,29 @@ static vtkSmartPointer<vtkPolyData> convert_geometry_object_to_polydata(
 static bool convert_objects_to_clean_polydata(World* world, GeomObjectInfoVector& counted_objects) {
   bool res = true;
 
-  for (GeomObjectInfo& obj_info: counted_objects) {
-
-    GeometryObject& obj = world->get_geometry_object(obj_info.geometry_object_id);
-    vtkSmartPointer<vtkPolyData> polydata = convert_geometry_object_to_polydata(world, obj);
+  // each object is converted independently, only the geometry of the partition is read
+  vector<vtkSmartPointer<vtkPolyData>> polydata_per_object(counted_objects.size());
+  vector<uint8_t> closed_per_object(counted_objects.size(), 0);
+  ThreadPool::run_for_each_index(world->get_thread_pool(), counted_objects.size(),
+      [&](const uint i) {
+        const GeometryObject& obj = world->get_geometry_object(counted_objects[i].geometry_object_id);
+        polydata_per_object[i] = convert_geometry_object_to_polydata(world, obj);
+        closed_per_object[i] = vtkSelectEnclosedPoints::IsSurfaceClosed(polydata_per_object[i].Get()) == 1;
+      }
+  );
 
+  for (uint i = 0; i < counted_objects.size(); i++) {
+    GeomObjectInfo& obj_info = counted_objects[i];
 
-    int closed = vtkSelectEnclosedPoints::IsSurfaceClosed(polydata.Get());
-    if (closed != 1) {
+    if (!closed_per_object[i]) {
+      GeometryObject& obj = world->get_geometry_object(obj_info.geometry_object_id);
       mcell_warn("Counting object must be closed, error for %s.", obj.name.c_str());
       res = false;
       continue;
     }
 
     // copy a reference to object info as well
-    obj_info.polydata = polydata;
+    obj_info.polydata = polydata_per_object[i];
   }
 
   return res;
@@ -71,6 +71,9 @@ void Grid::initialize(const Partition& p, const Wall& w) {
 
   assert(w.index != WALL_INDEX_INVALID);
   wall_index = w.index;
+
+  // tiles changed, neighbors must be computed again
+  clear_tile_neighbors();
 }
 
 
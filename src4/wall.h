@@ -182,6 +182,29 @@ public:
 
   void dump() const;
 
+  bool has_tile_neighbors() const {
+    return !tile_neighbors_offsets.empty();
+  }
+
+  void clear_tile_neighbors() {
+    tile_neighbors_offsets.clear();
+    tile_neighbors.clear();
+    tile_neighbors_walls_without_grid.clear();
+  }
+
+  // Neighbors of each tile as computed by GridUtils::find_neighbor_tiles when searching
+  // for reactants of a molecule that is not restricted by region borders,
+  // built lazily by GridUtils::build_tile_neighbors.
+  // Neighbors of tile i are stored in the same order as find_neighbor_tiles returns them
+  // in range tile_neighbors[tile_neighbors_offsets[i]] .. tile_neighbors[tile_neighbors_offsets[i+1]-1],
+  // tile_neighbors_offsets has num_tiles + 1 items when built.
+  std::vector<uint> tile_neighbors_offsets;
+  std::vector<WallTileIndexPair> tile_neighbors;
+
+  // neighbor walls that had no grid when the neighbors were built,
+  // neighbors must be built again once any of these walls gets a grid
+  WallIndicesVector tile_neighbors_walls_without_grid;
+
 private:
   uint num_occupied; // How many tiles are occupied
 
@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#include "wall_bvh.h"
+#include "partition.h"
+
+using namespace std;
+
+namespace MCell {
+
+void WallBvh::compute_wall_box(
+    const Partition& p, const wall_index_t wall_index, Vec3& box_min, Vec3& box_max) const {
+
+  const Wall& w = p.get_wall(wall_index);
+  box_min = p.get_wall_vertex(w, 0);
+  box_max = box_min;
+  for (uint i = 1; i < VERTICES_IN_TRIANGLE; i++) {
+    const Vec3& v = p.get_wall_vertex(w, i);
+    box_min = glm::min((glm_vec3_t)box_min, (glm_vec3_t)v);
+    box_max = glm::max((glm_vec3_t)box_max, (glm_vec3_t)v);
+  }
+
+  // boxes of walls parallel with an axis are flat, collide_wall also accepts hits
+  // that are slightly outside of the wall
+  box_min = box_min - Vec3(POS_SQRT_EPS);
+  box_max = box_max + Vec3(POS_SQRT_EPS);
+}
+
+
+void WallBvh::build(const Partition& p) {
+  nodes.clear();
+  wall_indices.clear();
+
+  uint num_walls = p.get_wall_count();
+  if (num_walls == 0) {
+    return;
+  }
+
+  vector<Vec3> centroids(num_walls);
+  for (wall_index_t wi = 0; wi < num_walls; wi++) {
+    const Wall& w = p.get_wall(wi);
+    centroids[wi] =
+        (p.get_wall_vertex(w, 0) + p.get_wall_vertex(w, 1) + p.get_wall_vertex(w, 2)) / Vec3(3);
+    wall_indices.push_back(wi);
+  }
+
+  // median split creates leaves with at least 2 walls (unless there is just one wall),
+  // so there is less than num_walls nodes
+  nodes.reserve(num_walls + 1);
+  nodes.push_back(Node());
+  build_node(p, centroids, 0, 0, num_walls);
+}
+
+
+void WallBvh::build_node(
+    const Partition& p, const std::vector<Vec3>& centroids,
+    const uint node_index, const uint first, const uint count) {
+
+  assert(count > 0);
+
+  // box of all walls in this node
+  Vec3 box_min, box_max;
+  compute_wall_box(p, wall_indices[first], box_min, box_max);
+  Vec3 centroid_min = centroids[wall_indices[first]];
+  Vec3 centroid_max = centroid_min;
+  for (uint i = first + 1; i < first + count; i++) {
+    Vec3 wall_min, wall_max;
+    compute_wall_box(p, wall_indices[i], wall_min, wall_max);
+    box_min = glm::min((glm_vec3_t)box_min, (glm_vec3_t)wall_min);
+    box_max = glm::max((glm_vec3_t)box_max, (glm_vec3_t)wall_max);
+
+    const Vec3& c = centroids[wall_indices[i]];
+    centroid_min = glm::min((glm_vec3_t)centroid_min, (glm_vec3_t)c);
+    centroid_max = glm::max((glm_vec3_t)centroid_max, (glm_vec3_t)c);
+  }
+
+  // nodes may be reallocated by the recursive calls, do not keep a reference
+  nodes[node_index].box_min = box_min;
+  nodes[node_index].box_max = box_max;
+
+  Vec3 centroid_extent = centroid_max - centroid_min;
+  if (count <= WALL_BVH_MAX_WALLS_IN_LEAF || max3(centroid_extent) == 0) {
+    nodes[node_index].first = first;
+    nodes[node_index].count = count;
+    nodes[node_index].left = 0;
+    return;
+  }
+
+  // split by the median of centroids along the longest axis
+  uint axis = 0;
+  if (centroid_extent.y > centroid_extent[axis]) {
+    axis = 1;
+  }
+  if (centroid_extent.z > centroid_extent[axis]) {
+    axis = 2;
+  }
+
+  uint half = count / 2;
+  nth_element(
+      wall_indices.begin() + first, wall_indices.begin() + first + half, wall_indices.begin() + first + count,
+      [&centroids, axis](const wall_index_t a, const wall_index_t b) -> bool {
+        return centroids[a][axis] < centroids[b][axis];
+      }
+  );
+
+  uint left = nodes.size();
+  nodes[node_index].first = 0;
+  nodes[node_index].count = 0;
+  nodes[node_index].left = left;
+  nodes.push_back(Node());
+  nodes.push_back(Node());
+
+  build_node(p, centroids, left, first, half);
+  build_node(p, centroids, left + 1, first + half, count - half);
+}
+
+
+void WallBvh::refit(const Partition& p) {
+  // children always have higher indices than their parent
+  for (int i = (int)nodes.size() - 1; i >= 0; i--) {
+    Node& node = nodes[i];
+    if (node.is_leaf()) {
+      compute_wall_box(p, wall_indices[node.first], node.box_min, node.box_max);
+      for (uint k = node.first + 1; k < node.first + node.count; k++) {
+        Vec3 wall_min, wall_max;
+        compute_wall_box(p, wall_indices[k], wall_min, wall_max);
+        node.box_min = glm::min((glm_vec3_t)node.box_min, (glm_vec3_t)wall_min);
+        node.box_max = glm::max((glm_vec3_t)node.box_max, (glm_vec3_t)wall_max);
+      }
+    }
+    else {
+      const Node& left = nodes[node.left];
+      const Node& right = nodes[node.left + 1];
+      node.box_min = glm::min((glm_vec3_t)left.box_min, (glm_vec3_t)right.box_min);
+      node.box_max = glm::max((glm_vec3_t)left.box_max, (glm_vec3_t)right.box_max);
+    }
+  }
+}
+
+} // namespace MCell
@@ -0,0 +1,146 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2021 by
+ * The Salk Institute for Biological Studies
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file or at
+ * https://opensource.org/licenses/MIT.
+ *
+******************************************************************************/
+
+#ifndef SRC4_WALL_BVH_H_
+#define SRC4_WALL_BVH_H_
+
+#include <vector>
+#include <algorithm>
+
+#include "defines.h"
+
+namespace MCell {
+
+class Partition;
+
+// maximal number of walls in a leaf node of WallBvh
+const uint WALL_BVH_MAX_WALLS_IN_LEAF = 4;
+
+/*
+ * Bounding volume hierarchy of axis-aligned boxes over all walls of a partition,
+ * an alternative to walls_per_subpart whose cost does not depend on the
+ * number of subpartitions and on how uniformly the walls are distributed.
+ *
+ * The tree is built once by build() when walls are finalized. When vertices move,
+ * refit() only recomputes the boxes and the topology is kept.
+ */
+class WallBvh {
+public:
+  void build(const Partition& p);
+
+  // must be called after any vertex of a wall was moved
+  void refit(const Partition& p);
+
+  bool is_built() const {
+    return !nodes.empty();
+  }
+
+  // appends walls whose bounding box is intersected by the segment from pos to pos + move,
+  // excluded_wall_index is skipped, the order of candidates is not defined
+  void collect_walls_along_segment(
+      const Vec3& pos, const Vec3& move, const wall_index_t excluded_wall_index,
+      WallIndicesVector& candidates) const {
+
+    if (nodes.empty()) {
+      return;
+    }
+
+    // the tree depth is logarithmic in the number of walls thanks to the median split,
+    // so a fixed-size stack is sufficient
+    uint stack[64];
+    uint stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+      const Node& node = nodes[stack[--stack_size]];
+      if (!segment_intersects_box(pos, move, node.box_min, node.box_max)) {
+        continue;
+      }
+
+      if (node.is_leaf()) {
+        for (uint i = node.first; i < node.first + node.count; i++) {
+          if (wall_indices[i] != excluded_wall_index) {
+            candidates.push_back(wall_indices[i]);
+          }
+        }
+      }
+      else {
+        assert(stack_size + 2 <= sizeof(stack)/sizeof(stack[0]));
+        stack[stack_size++] = node.left;
+        stack[stack_size++] = node.left + 1;
+      }
+    }
+  }
+
+  uint get_num_nodes() const {
+    return nodes.size();
+  }
+
+private:
+  struct Node {
+    bool is_leaf() const {
+      return count != 0;
+    }
+
+    Vec3 box_min;
+    Vec3 box_max;
+    // leaf: range [first, first+count) in wall_indices
+    uint first;
+    uint count;
+    // inner node: children are at indices left and left + 1, both are higher than the index of this node
+    uint left;
+  };
+
+  // slab test, the segment is parametrized as pos + t * move for t in [0, 1]
+  static bool segment_intersects_box(
+      const Vec3& pos, const Vec3& move, const Vec3& box_min, const Vec3& box_max) {
+
+    pos_t t_enter = 0;
+    pos_t t_exit = 1;
+    for (uint dim = 0; dim < 3; dim++) {
+      if (move[dim] == 0) {
+        if (pos[dim] < box_min[dim] || pos[dim] > box_max[dim]) {
+          return false;
+        }
+        continue;
+      }
+
+      pos_t inv = 1 / move[dim];
+      pos_t t0 = (box_min[dim] - pos[dim]) * inv;
+      pos_t t1 = (box_max[dim] - pos[dim]) * inv;
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      t_enter = std::max(t_enter, t0);
+      t_exit = std::min(t_exit, t1);
+      if (t_enter > t_exit) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void compute_wall_box(const Partition& p, const wall_index_t wall_index, Vec3& box_min, Vec3& box_max) const;
+
+  // node with index node_index must already exist, its children are appended to nodes
+  void build_node(
+      const Partition& p, const std::vector<Vec3>& centroids,
+      const uint node_index, const uint first, const uint count);
+
+  std::vector<Node> nodes;
+
+  // walls referenced by leaves, reordered during build
+  std::vector<wall_index_t> wall_indices;
+};
+
+} // namespace MCell
+
+#endif // SRC4_WALL_BVH_H_
@@ -740,7 +740,7 @@ static pos_t find_closest_wall_any_object(
   pos_t search_d = sqrt_p(search_d2);
   IVec3 subpart_indices;
   p.get_subpart_3d_indices(pos, subpart_indices);
-  SubpartIndicesSet crossed_subpart_indices;
+  SubpartIndicesOrderedSet crossed_subpart_indices;
   crossed_subpart_indices.insert(p.get_subpart_index_from_3d_indices(subpart_indices));
   CollisionUtils::collect_neighboring_subparts(
       p, pos, subpart_indices, search_d, p.config.subpart_edge_length,
@@ -26,11 +26,15 @@
 #include "util.h"
 
 #include "world.h"
+#include "thread_pool.h"
+#include "viz_output_writer.h"
+#include "count_buffer_writer.h"
 #include "viz_output_event.h"
 #include "defragmentation_event.h"
 #include "rxn_class_cleanup_event.h"
 #include "species_cleanup_event.h"
 #include "sort_mols_by_subpart_event.h"
+#include "rebalance_subpart_cells_event.h"
 #include "release_event.h"
 #include "mol_or_rxn_count_event.h"
 #include "datamodel_defines.h"
@@ -75,6 +79,10 @@ World::World(API::Callbacks& callbacks_)
   : bng_engine(config),
     callbacks(callbacks_),
     total_iterations(0),
+    thread_pool(nullptr),
+    viz_output_writer(nullptr),
+    count_buffer_writer(nullptr),
+    next_molecule_id(0),
     next_wall_id(0),
     next_region_id(0),
     next_geometry_object_id(0),
@@ -104,6 +112,10 @@ World::~World() {
   for (MolOrRxnCountEvent* e: unscheduled_count_events) {
     delete e;
   }
+
+  delete thread_pool;
+  delete viz_output_writer;
+  delete count_buffer_writer;
 }
 
 
@@ -144,14 +156,171 @@ void World::create_initial_surface_region_release_event() {
 
 
 void World::init_counted_volumes() {
-  assert(partitions.size() == 1);
+  assert(!partitions.empty());
 
+  // geometry is created only in the initial partition
+  auto start_time = chrono::steady_clock::now();
   bool ok = VtkUtils::initialize_counted_volumes(this, config.has_intersecting_counted_objects);
   if (!ok) {
     mcell_error("Processing of counted volumes failed, terminating.");
   }
+  add_startup_phase_time("counted volumes", start_time);
+
+  // all other partitions of the lattice get the same geometry
+  if (partitions.size() > 1) {
+    start_time = chrono::steady_clock::now();
+    const Partition& p0 = partitions[PARTITION_ID_INITIAL];
+    for (Partition& p: partitions) {
+      if (p.id != PARTITION_ID_INITIAL) {
+        p.copy_geometry_from(p0, thread_pool);
+      }
+    }
+    add_startup_phase_time("geometry copies for partitions", start_time);
+  }
+
+  start_time = chrono::steady_clock::now();
+  for (Partition& p: partitions) {
+    p.initialize_all_waypoints(thread_pool);
+  }
+  add_startup_phase_time("waypoints", start_time);
+
+  // voxels use counted volumes of waypoints, these are computed only for intersecting counted objects
+  if (config.use_counted_volume_voxels && config.has_intersecting_counted_objects) {
+    start_time = chrono::steady_clock::now();
+    for (Partition& p: partitions) {
+      p.initialize_counted_volume_voxels();
+    }
+    add_startup_phase_time("counted volume voxels", start_time);
+  }
+}
+
+
+// grids of these walls would be initialized one by one by the initial surface release event,
+// the initialization of each grid is independent so it is done in parallel beforehand,
+// surface molecules are supported only with a single partition
+void World::init_wall_grids_for_initial_surface_releases() {
+  Partition& p = get_partition(PARTITION_ID_INITIAL);
+  vector<wall_index_t> wall_indices;
+  for (const Wall& w: p.get_walls()) {
+    if (w.has_initialized_grid()) {
+      continue;
+    }
+    for (region_index_t reg_index: w.regions) {
+      if (p.get_region(reg_index).has_initial_molecules()) {
+        wall_indices.push_back(w.index);
+        break;
+      }
+    }
+  }
+
+  ThreadPool::run_for_each_index(thread_pool, wall_indices.size(),
+      [&](const uint i) {
+        p.get_wall(wall_indices[i]).initialize_grid(p);
+      }
+  );
+}
+
+
+void World::create_thread_pool_if_needed() {
+  if (config.num_threads > 1 && thread_pool == nullptr) {
+    thread_pool = new ThreadPool(config.num_threads);
+  }
+}
+
+
+void World::add_startup_phase_time(
+    const std::string& phase_name, const std::chrono::time_point<std::chrono::steady_clock>& start_time) {
+
+  auto current_time = chrono::steady_clock::now();
+  double seconds = chrono::duration_cast<chrono::microseconds>(current_time - start_time).count() / 1000000.0;
+  startup_phase_times.push_back(make_pair(phase_name, seconds));
+}
+
+
+void World::print_startup_timing_report() const {
+  cout << "Startup time per phase (wall clock, " << config.num_threads << " thread(s)):\n";
+  double total = 0;
+  for (const auto& phase_and_time: startup_phase_times) {
+    cout << "  " << phase_and_time.first << ": " << phase_and_time.second << " s\n";
+    total += phase_and_time.second;
+  }
+  cout << "  total: " << total << " s\n";
+}
+
+
+void World::add_partition_lattice() {
+  assert(partitions.empty());
+  uint n = config.num_partitions_per_world_edge;
+  release_assert(n >= 1);
+
+  // partitions must not be copied once they contain walls
+  partitions.reserve(powu(n, 3));
+  for (uint z = 0; z < n; z++) {
+    for (uint y = 0; y < n; y++) {
+      for (uint x = 0; x < n; x++) {
+        Vec3 llf = config.partition0_llf + Vec3(IVec3(x, y, z)) * Vec3(config.partition_edge_length);
+        partition_id_t index = add_partition(llf);
+        release_assert(index == x + y * n + z * n * n);
+      }
+    }
+  }
+}
+
+
+partition_id_t World::get_neighbor_partition_index(
+    const Partition& src, const Vec3& pos, const Vec3& displacement) const {
+
+  uint n = config.num_partitions_per_world_edge;
+  assert(partitions.size() == powu(n, 3));
+
+  // find the face through which the displacement leaves the partition first
+  const Vec3& llf = src.get_origin_corner();
+  const Vec3& urb = src.get_opposite_corner();
+  int exit_dim = -1;
+  pos_t min_time = 0;
+  for (int dim = 0; dim < 3; dim++) {
+    if (displacement[dim] == 0) {
+      continue;
+    }
+    pos_t face = (displacement[dim] > 0) ? urb[dim] : llf[dim];
+    pos_t time = (face - pos[dim]) / displacement[dim];
+    if (exit_dim == -1 || time < min_time) {
+      exit_dim = dim;
+      min_time = time;
+    }
+  }
+  if (exit_dim == -1) {
+    return PARTITION_ID_INVALID;
+  }
+
+  // partitions are ordered in the same way as subpartitions
+  IVec3 indices(src.id % n, (src.id / n) % n, src.id / (n * n));
+  indices[exit_dim] += (displacement[exit_dim] > 0) ? 1 : -1;
+  if (indices[exit_dim] < 0 || indices[exit_dim] >= (int)n) {
+    return PARTITION_ID_INVALID;
+  }
+  return indices.x + indices.y * n + indices.z * n * n;
+}
+
+
+Molecule& World::migrate_volume_molecule(
+    Partition& src, const molecule_id_t id, Partition& dst, const Vec3& dst_pos) {
+
+  Molecule vm_copy = src.get_m(id);
+  assert(vm_copy.is_vol() && !vm_copy.is_defunct());
+  src.set_molecule_as_defunct(src.get_m(id));
+
+  vm_copy.v.pos = dst_pos;
+
+  // counted volumes are the same in all partitions after initialization but
+  // new counted volumes may be added later, so the index must be translated
+  if (vm_copy.v.counted_volume_index != COUNTED_VOLUME_INDEX_INVALID) {
+    vm_copy.v.counted_volume_index =
+        dst.find_or_add_counted_volume(src.get_counted_volume(vm_copy.v.counted_volume_index));
+  }
 
-  partitions[PARTITION_ID_INITIAL].initialize_all_waypoints();
+  // keeps id, diffusion and unimol rxn times
+  return dst.add_volume_molecule(vm_copy);
 }
 
 
@@ -269,12 +438,39 @@ void World::init_simulation(const double start_time) {
 
   init_fpu();
 
+  // also used to initialize counted volumes and waypoints
+  create_thread_pool_if_needed();
+
   init_counted_volumes();
 
+  auto grids_start_time = chrono::steady_clock::now();
+  init_wall_grids_for_initial_surface_releases();
+  add_startup_phase_time("wall grids", grids_start_time);
+
+  if (partitions.size() > 1) {
+    cout <<
+        "Simulation space is split into " << config.num_partitions_per_world_edge << "^3 partitions, " <<
+        "partition size is " << config.partition_edge_length * config.length_unit << " microns.\n";
+  }
   cout <<
       "Partition contains " <<  config.num_subparts_per_partition_edge << "^3 subpartitions, " <<
       "subpartition size is " << config.subpart_edge_length * config.length_unit << " microns.\n";
-  assert(partitions.size() == 1 && "Initial partition must have been created, only 1 is allowed for now");
+  assert(!partitions.empty() && "Initial partition must have been created");
+
+  if (config.num_threads > 1) {
+    cout << "Volume molecules are diffused using " << config.num_threads << " threads.\n";
+  }
+
+  if (config.use_async_viz_output) {
+    viz_output_writer = new VizOutputWriter(config.max_pending_viz_frames);
+  }
+
+  if (config.use_async_count_output) {
+    count_buffer_writer = new CountBufferWriter((size_t)config.max_pending_count_output_mb * 1024 * 1024);
+    for (CountBuffer& b: count_buffers) {
+      b.set_background_writer(count_buffer_writer);
+    }
+  }
 
   // create event that diffuses molecules
   DiffuseReactEvent* event = new DiffuseReactEvent(this);
@@ -310,7 +506,7 @@ void World::init_simulation(const double start_time) {
   }
 
   // create subpart sorting events
-  if (config.sort_mols_by_subpart) {
+  if (config.sort_mols_by_subpart || config.sort_mols_in_morton_order) {
     SortMolsBySubpartEvent* sort_event = new SortMolsBySubpartEvent(this);
     if (start_time == 0) {
       sort_event->event_time = TIME_SIMULATION_START;
@@ -322,6 +518,20 @@ void World::init_simulation(const double start_time) {
     scheduler.schedule_event(sort_event);
   }
 
+  // create adaptive subpartition events, the first rebalance is done
+  // after the initial releases
+  if (config.use_adaptive_subparts) {
+    RebalanceSubpartCellsEvent* rebalance_event = new RebalanceSubpartCellsEvent(this);
+    if (start_time == 0) {
+      rebalance_event->event_time = TIME_SIMULATION_START;
+    }
+    else {
+      rebalance_event->event_time = get_event_start_time(start_time, SUBPART_CELLS_REBALANCE_PERIODICITY);
+    }
+    rebalance_event->periodicity_interval = SUBPART_CELLS_REBALANCE_PERIODICITY;
+    scheduler.schedule_event(rebalance_event);
+  }
+
   // simulation statistics, mostly for development purposes
   if (config.simulation_stats_every_n_iterations > 0) {
     CustomFunctionCallEvent<World*>* stats_event =
@@ -365,6 +575,10 @@ void World::init_simulation(const double start_time) {
       "at iteration " + to_string(stats.get_current_iteration()) +
       " and time " + BNG::get_current_date_time() + ".\n");
 
+  if (config.startup_timing_report) {
+    print_startup_timing_report();
+  }
+
   simulation_initialized = true;
 }
 
@@ -499,11 +713,22 @@ uint64_t World::run_n_iterations(const uint64_t num_iterations, const bool termi
         run_n_iterations_terminated_with_checkpoint = true;
       }
 
+      if (event_info.return_from_run_iterations) {
+        // the model may be changed before the simulation continues,
+        // diffusion must not skip the next iterations
+        scheduler.end_idle_time_skipping(current_iteration);
+      }
+
       break;
     }
 
   } while (true); // terminated when the nr. of iterations is reached
 
+  // all viz output files must be complete when we return to the caller
+  if (viz_output_writer != nullptr) {
+    viz_output_writer->wait_until_all_written();
+  }
+
 #ifndef NDEBUG
   // flush everything, we want the output to be mixed with Python in the right ordering
   cout.flush();
@@ -518,11 +743,17 @@ uint64_t World::run_n_iterations(const uint64_t num_iterations, const bool termi
 
 count_buffer_id_t World::create_dat_count_buffer(
     const std::string file_name, const size_t buffer_size, const bool open_for_append) {
+  if (count_buffer_writer != nullptr) {
+    // writer references buffers that may be moved by push_back
+    count_buffer_writer->wait_until_all_written();
+  }
+
   count_buffer_id_t id = count_buffers.size();
   std::vector<std::string> column_names = { file_name }; // name is not used when .dat format is used
   count_buffers.push_back(
       CountBuffer(CountOutputFormat::DAT, file_name, column_names, buffer_size, open_for_append));
   count_buffers.back().open();
+  count_buffers.back().set_background_writer(count_buffer_writer);
   return id;
 }
 
@@ -530,10 +761,16 @@ count_buffer_id_t World::create_dat_count_buffer(
 count_buffer_id_t World::create_gdat_count_buffer(
     const std::string file_name, const std::vector<std::string>& column_names,
     const size_t buffer_size, const bool open_for_append) {
+  if (count_buffer_writer != nullptr) {
+    // writer references buffers that may be moved by push_back
+    count_buffer_writer->wait_until_all_written();
+  }
+
   count_buffer_id_t id = count_buffers.size();
   count_buffers.push_back(
       CountBuffer(CountOutputFormat::GDAT, file_name, column_names, buffer_size, open_for_append));
   count_buffers.back().open();
+  count_buffers.back().set_background_writer(count_buffer_writer);
   return id;
 }
 
@@ -553,6 +790,10 @@ void World::flush_and_close_buffers() {
   for (CountBuffer& b: count_buffers) {
     b.flush_and_close();
   }
+
+  if (viz_output_writer != nullptr) {
+    viz_output_writer->wait_until_all_written();
+  }
   buffers_flushed = true;
 }
 
@@ -687,6 +928,9 @@ void World::reset_unimol_rxn_times(const BNG::rxn_rule_id_t rxn_rule_id) {
 
   // and then reset unimol time for each molecule of that species
   for (Partition& p: partitions) {
+    // diffusion time of molecules that are not being diffused may change
+    p.reset_diffusion_calendar();
+
     for (Molecule& m: p.get_molecules()) {
 
       assert((rxn->species_applicable_as_any_reactant.count(m.species_id) != 0 ||
@@ -39,6 +39,7 @@
 
 #include "logging.h"
 #include "rng.h"
+#include "gauss_buffer.h"
 
 namespace Json {
 class Value;
@@ -53,6 +54,9 @@ enum class BNGSimulationMethod;
 }
 
 class MolOrRxnCountEvent;
+class ThreadPool;
+class VizOutputWriter;
+class CountBufferWriter;
 
 class World {
 
@@ -99,7 +103,20 @@ public:
 
   // -------------- partition manipulation methods --------------
   partition_id_t get_partition_index(const Vec3& pos) {
-    // for now a slow approach, later some hashing/memoization might be needed
+    // partitions form a regular lattice whose ids are ordered in the same way as
+    // subpartition indices, so the index can be computed directly
+    uint n = config.num_partitions_per_world_edge;
+    if (partitions.size() == powu(n, 3)) {
+      IVec3 indices = floor3((pos - config.partition0_llf) / Vec3(config.partition_edge_length));
+      if (glm::all(glm::greaterThanEqual(indices, IVec3(0))) && glm::all(glm::lessThan(indices, IVec3((int)n)))) {
+        partition_id_t i = indices.x + indices.y * n + indices.z * n * n;
+        // rounding may move a point that is close to a boundary into the neighbor
+        if (partitions[i].in_this_partition(pos)) {
+          return i;
+        }
+      }
+    }
+
     for (partition_id_t i = 0; i < partitions.size(); i++) {
       if (partitions[i].in_this_partition(pos)) {
         return i;
@@ -108,15 +125,53 @@ public:
     return PARTITION_ID_INVALID;
   }
 
+  // returns partition that contains pos, if there is no such partition, the initial partition
+  // is returned and its methods that create molecules report an error
+  Partition& get_partition_for_pos(const Vec3& pos) {
+    partition_id_t i = get_partition_index(pos);
+    return get_partition((i != PARTITION_ID_INVALID) ? i : PARTITION_ID_INITIAL);
+  }
+
   // add a partition in a predefined 'lattice' that contains point pos as its llf point
   // size is given by config
   partition_id_t add_partition(const Vec3& partition_llf) {
     assert(config.partition_edge_length != 0);
     assert(get_partition_index(partition_llf) == PARTITION_ID_INVALID && "Partition must not exist");
-    partitions.push_back(Partition(partitions.size(), partition_llf, config, bng_engine, stats));
+    // partitions own their walls through pointers and must not be copied once they
+    // contain geometry, space for all of them is reserved in add_partition_lattice
+    assert(partitions.size() < partitions.capacity() || partitions.empty());
+    partitions.push_back(Partition(partitions.size(), partition_llf, next_molecule_id, config, bng_engine, stats));
     return partitions.size() - 1;
   }
 
+  // creates all num_partitions_per_world_edge^3 partitions starting at partition0_llf,
+  // partition with index (x, y, z) in the lattice has id x + y*n + z*n^2
+  void add_partition_lattice();
+
+  // returns partition that contains molecule with this id (defunct molecules are ignored),
+  // nullptr if there is no such partition,
+  // checks all partitions so it is meant for API calls, simulation code knows the partition
+  Partition* find_partition_with_molecule(const molecule_id_t id) {
+    for (Partition& p: partitions) {
+      if (p.does_molecule_exist(id)) {
+        return &p;
+      }
+    }
+    return nullptr;
+  }
+
+  // returns the neighbor of partition src into which a molecule moves when it
+  // crosses the boundary of src at pos in the direction of displacement,
+  // PARTITION_ID_INVALID if there is no such partition
+  partition_id_t get_neighbor_partition_index(
+      const Partition& src, const Vec3& pos, const Vec3& displacement) const;
+
+  // moves volume molecule from partition src into partition dst while keeping
+  // its id, dst_pos must be in partition dst, the defunct copy stays in src until
+  // defragmentation and is reused if the molecule returns before that
+  Molecule& migrate_volume_molecule(
+      Partition& src, const molecule_id_t id, Partition& dst, const Vec3& dst_pos);
+
   Partition& get_partition(partition_id_t i) {
     assert(i < partitions.size());
     return partitions[i];
@@ -210,6 +265,13 @@ public:
 
   void reset_unimol_rxn_times(const BNG::rxn_rule_id_t rxn_rule_id);
 
+  // must be called when rxn classes or species are removed or when rxn rates are changed from outside
+  void clear_rxn_class_caches() {
+    for (Partition& p: partitions) {
+      p.clear_rxn_class_caches();
+    }
+  }
+
   // gives ownership of the event to this World object
   void add_unscheduled_count_event(MolOrRxnCountEvent* e) {
     unscheduled_count_events.push_back(e);
@@ -222,6 +284,25 @@ public:
   // prints message, flushes buffers, and terminates
   void fatal_error(const std::string& msg);
 
+  // called before geometry is converted so that startup can use multiple threads,
+  // does nothing when config.num_threads is 1 or the pool was already created
+  void create_thread_pool_if_needed();
+
+  // returns nullptr when config.num_threads is 1
+  ThreadPool* get_thread_pool() {
+    return thread_pool;
+  }
+
+  // records wall-clock time of a startup phase that began at start_time,
+  // the times are printed at the end of init_simulation when config.startup_timing_report is set
+  void add_startup_phase_time(
+      const std::string& phase_name, const std::chrono::time_point<std::chrono::steady_clock>& start_time);
+
+  // returns nullptr when config.use_async_viz_output is not set
+  VizOutputWriter* get_viz_output_writer() {
+    return viz_output_writer;
+  }
+
 private:
   void check_checkpointing_signal();
 
@@ -229,6 +310,9 @@ private:
 
   void init_fpu();
   void init_counted_volumes();
+  void init_wall_grids_for_initial_surface_releases();
+
+  void print_startup_timing_report() const;
 
   void initialization_to_data_model(Json::Value& mcell_node) const;
 
@@ -254,6 +338,10 @@ public:
 
   rng_state rng; // single state for the random number generator
 
+  // normally distributed numbers drawn from rng, used when config.use_batched_gauss_rng is set,
+  // discarded when a checkpoint is saved or when rng state is loaded from a checkpoint
+  GaussBuffer gauss_buffer;
+
 private:
   PartitionVector partitions;
 
@@ -262,7 +350,17 @@ private:
   // periodic check of used memory using timer
   MemoryLimitChecker memory_limit_checker;
 
+  // created in create_thread_pool_if_needed when multiple threads are enabled
+  ThreadPool* thread_pool;
+
+  // created in init_simulation when asynchronous viz output is enabled
+  VizOutputWriter* viz_output_writer;
+
+  // created in init_simulation when asynchronous count output is enabled
+  CountBufferWriter* count_buffer_writer;
+
   // global ID counters
+  molecule_id_t next_molecule_id; // shared by all partitions
   wall_id_t next_wall_id;
   region_id_t next_region_id;
   geometry_object_id_t next_geometry_object_id;
@@ -289,6 +387,9 @@ private:
 
   std::chrono::time_point<std::chrono::steady_clock> previous_buffer_flush_time;
 
+  // name of a startup phase and its wall-clock time in seconds, in the order of execution
+  std::vector<std::pair<std::string, double>> startup_phase_times;
+
   // and to nicely report simulation progress
   uint64_t previous_iteration;
 